@@ -0,0 +1,36 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 worldXZ;
+in float viewDistance;
+
+uniform float lineSpacing;    // finest spacing in world units
+uniform float fadeDistance;
+
+const float MIN_CELL_PIXELS = 8.0;
+
+// Antialiased coverage of the lines at multiples of spacing, about one pixel wide.
+float lineCoverage(vec2 p, float spacing) {
+    vec2 coord = p / spacing;
+    vec2 width = max(fwidth(coord), vec2(1e-6));
+    vec2 dist = abs(fract(coord - 0.5) - 0.5) / width;
+    return 1.0 - min(min(dist.x, dist.y), 1.0);
+}
+
+void main() {
+    // Spacings go up in decades; use the finest one whose cells are still
+    // MIN_CELL_PIXELS wide and fade it into the next as the camera recedes.
+    vec2 footprint = fwidth(worldXZ);
+    float pixel = max(footprint.x, footprint.y);
+    float lod = max(log(pixel * MIN_CELL_PIXELS / lineSpacing) / log(10.0), 0.0);
+
+    float fine = lineSpacing * pow(10.0, floor(lod));
+    float blend = fract(lod);
+    float coverage = max(lineCoverage(worldXZ, fine) * (1.0 - blend), lineCoverage(worldXZ, fine * 10.0));
+
+    coverage *= 1.0 - smoothstep(0.7 * fadeDistance, fadeDistance, viewDistance);
+    if (coverage < 0.01)
+        discard;
+
+    FragColor = vec4(1.0, 1.0, 1.0, 0.2 * coverage);
+}
@@ -0,0 +1,42 @@
+#version 330 core
+
+layout (std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+    vec4 time;
+    vec4 viewport;
+};
+
+// Depth of the warp, as in GridVertexShader.glsl.
+uniform sampler2D heightField;
+uniform vec4 fieldTransform;
+
+uniform int planeCells;      // cells per side
+uniform float planeExtent;   // half width in world units
+uniform float planeHeight;
+
+out vec2 worldXZ;
+out float viewDistance;
+
+const ivec2 corners[6] = ivec2[6](
+    ivec2(0, 0), ivec2(1, 0), ivec2(1, 1),
+    ivec2(0, 0), ivec2(1, 1), ivec2(0, 1));
+
+// No vertex buffer: two triangles per cell, built from gl_VertexID.
+void main() {
+    int cell = gl_VertexID / 6;
+    ivec2 lattice = ivec2(cell % planeCells, cell / planeCells) + corners[gl_VertexID % 6];
+
+    // Spread as sign(u) u^2 so the lattice is finest around the Sun.
+    vec2 u = vec2(lattice) / float(planeCells) * 2.0 - 1.0;
+    vec2 xz = sign(u) * u * u * planeExtent;
+
+    float depth = textureLod(heightField, xz * fieldTransform.xy + fieldTransform.zw, 0.0).r;
+    vec3 world = vec3(xz.x, planeHeight - depth, xz.y);
+
+    worldXZ = xz;
+    viewDistance = distance(world, cameraPosition.xyz);
+    gl_Position = viewProjection * vec4(world, 1.0);
+}
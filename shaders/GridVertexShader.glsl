@@ -1,25 +1,22 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+layout (std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+    vec4 time;
+    vec4 viewport;
+};
 
-#define MAX_PLANETS 10
-
-uniform vec3 planetPositions[MAX_PLANETS];
-uniform float planetMasses[MAX_PLANETS];
-uniform int planetCount;
+// Depth of the warp at each lattice point, computed on the CPU (PotentialField).
+uniform sampler2D heightField;
+uniform vec4 fieldTransform; // xy: scale, zw: offset from world xz to texture coordinates
 
 void main() {
-    vec3 distortedPos = aPos;
-    for (int i = 0; i < planetCount; ++i) {
-        vec2 delta = distortedPos.xz - planetPositions[i].xz;
-        float dist2 = max(dot(delta, delta), 0.001);
-        float distortion = 0.008 * planetMasses[i] / (1.0 + dist2 / (2.0 * 2.0));
-        distortion = clamp(distortion, 0.0, 38.0);
-        distortedPos.y -= distortion;
-    }
+    vec2 uv = aPos.xz * fieldTransform.xy + fieldTransform.zw;
+    float depth = textureLod(heightField, uv, 0.0).r;
 
-    gl_Position = projection * view * model * vec4(distortedPos, 1.0);
+    gl_Position = viewProjection * vec4(aPos.x, aPos.y - depth, aPos.z, 1.0);
 }
@@ -0,0 +1,25 @@
+#version 330 core
+layout (location = 1) in vec4 aInstance; // xyz: position, w: radius
+layout (location = 2) in vec4 aColor;
+
+layout (std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+    vec4 time;
+    vec4 viewport;
+};
+
+const float MIN_POINT_SIZE = 2.0;
+
+out vec3 planetColor;
+
+// One point per body too small on screen for a sphere mesh (see Lod.h).
+void main() {
+    gl_Position = viewProjection * vec4(aInstance.xyz, 1.0);
+
+    float radiusPixels = aInstance.w * viewport.z / max(gl_Position.w, 1e-6);
+    gl_PointSize = max(2.0 * radiusPixels, MIN_POINT_SIZE);
+    planetColor = aColor.rgb;
+}
@@ -0,0 +1,19 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+
+layout (std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+    vec4 time;
+    vec4 viewport;
+};
+
+uniform float pointSize;
+
+// One point per test particle, fixed size on screen.
+void main() {
+    gl_Position = viewProjection * vec4(aPos, 1.0);
+    gl_PointSize = pointSize;
+}
@@ -1,10 +1,21 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec4 aInstance; // xyz: position, w: radius
+layout (location = 2) in vec4 aColor;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+layout (std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+    vec4 time;
+    vec4 viewport;
+};
+
+out vec3 planetColor;
 
 void main() {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    vec3 world = aInstance.xyz + aPos * aInstance.w;
+    gl_Position = viewProjection * vec4(world, 1.0);
+    planetColor = aColor.rgb;
 }
@@ -0,0 +1,217 @@
+#include "bench/Benchmark.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double secondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    double percentile(const std::vector<double>& sorted, double p)
+    {
+        if (sorted.empty())
+            return 0.0;
+
+        double rank = p * (sorted.size() - 1);
+        size_t lo = static_cast<size_t>(rank);
+        size_t hi = std::min(lo + 1, sorted.size() - 1);
+        return sorted[lo] + (sorted[hi] - sorted[lo]) * (rank - lo);
+    }
+
+    std::string jsonString(const std::string& s)
+    {
+        std::string out = "\"";
+        for (char c : s)
+        {
+            if (c == '"' || c == '\\')
+                out += '\\';
+            out += c;
+        }
+        return out + "\"";
+    }
+
+    // Values written by writeResultsJson: one result object per line.
+    bool findField(const std::string& line, const std::string& key, std::string& value)
+    {
+        std::string tag = "\"" + key + "\":";
+        size_t pos = line.find(tag);
+        if (pos == std::string::npos)
+            return false;
+
+        pos = line.find_first_not_of(' ', pos + tag.size());
+        if (pos == std::string::npos)
+            return false;
+
+        if (line[pos] == '"')
+        {
+            size_t end = line.find('"', pos + 1);
+            value = line.substr(pos + 1, end - pos - 1);
+        }
+        else
+        {
+            size_t end = line.find_first_of(",}", pos);
+            value = line.substr(pos, end - pos);
+        }
+        return true;
+    }
+}
+
+bool BenchmarkRunner::enabled(const std::string& name) const
+{
+    return settings.filter.empty() || name.find(settings.filter) != std::string::npos;
+}
+
+void BenchmarkRunner::run(const std::string& name, double itemsPerCall, const std::string& unit, const std::function<void()>& call)
+{
+    if (!enabled(name))
+        return;
+
+    // Warm caches and find how many calls fill one sample.
+    size_t calls = 1;
+    auto warmStart = Clock::now();
+    while (true)
+    {
+        auto start = Clock::now();
+        for (size_t i = 0; i < calls; ++i)
+            call();
+        double elapsed = secondsSince(start);
+
+        if (elapsed >= settings.minSample_s && secondsSince(warmStart) >= settings.warmup_s)
+            break;
+        if (elapsed < settings.minSample_s)
+            calls *= 2;
+    }
+
+    std::vector<double> perCall(settings.samples);
+    double total = 0.0;
+    for (size_t s = 0; s < settings.samples; ++s)
+    {
+        auto start = Clock::now();
+        for (size_t i = 0; i < calls; ++i)
+            call();
+        perCall[s] = secondsSince(start) * 1e9 / calls;
+        total += perCall[s];
+    }
+    std::sort(perCall.begin(), perCall.end());
+
+    BenchResult r;
+    r.name = name;
+    r.unit = unit;
+    r.itemsPerCall = itemsPerCall;
+    r.samples = settings.samples;
+    r.callsPerSample = calls;
+    r.mean_ns = total / settings.samples;
+    r.p50_ns = percentile(perCall, 0.50);
+    r.p90_ns = percentile(perCall, 0.90);
+    r.p99_ns = percentile(perCall, 0.99);
+    r.min_ns = perCall.front();
+    r.throughput = r.p50_ns > 0.0 ? itemsPerCall * 1e9 / r.p50_ns : 0.0;
+
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-44s %12.1f ns  p90 %12.1f  %12.4g %s/s",
+        name.c_str(), r.p50_ns, r.p90_ns, r.throughput, unit.c_str());
+    std::cout << line << std::endl;
+
+    all.push_back(r);
+}
+
+bool writeResultsJson(const std::string& path, const std::vector<BenchResult>& results, std::string& error)
+{
+    std::ofstream out(path);
+    if (!out)
+    {
+        error = "cannot write " + path;
+        return false;
+    }
+
+    out.precision(10);
+    out << "{\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const BenchResult& r = results[i];
+        out << "    {\"name\": " << jsonString(r.name)
+            << ", \"unit\": " << jsonString(r.unit)
+            << ", \"items_per_call\": " << r.itemsPerCall
+            << ", \"samples\": " << r.samples
+            << ", \"calls_per_sample\": " << r.callsPerSample
+            << ", \"mean_ns\": " << r.mean_ns
+            << ", \"p50_ns\": " << r.p50_ns
+            << ", \"p90_ns\": " << r.p90_ns
+            << ", \"p99_ns\": " << r.p99_ns
+            << ", \"min_ns\": " << r.min_ns
+            << ", \"throughput_per_s\": " << r.throughput
+            << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    return true;
+}
+
+bool readResultsJson(const std::string& path, std::vector<BenchResult>& results, std::string& error)
+{
+    std::ifstream in(path);
+    if (!in)
+    {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    results.clear();
+    std::string line, value;
+    while (std::getline(in, line))
+    {
+        BenchResult r;
+        if (!findField(line, "name", r.name))
+            continue;
+
+        if (!findField(line, "p50_ns", value))
+        {
+            error = path + ": result without p50_ns";
+            return false;
+        }
+        r.p50_ns = std::atof(value.c_str());
+
+        if (findField(line, "mean_ns", value))
+            r.mean_ns = std::atof(value.c_str());
+        if (findField(line, "unit", value))
+            r.unit = value;
+
+        results.push_back(r);
+    }
+    return true;
+}
+
+int compareWithBaseline(const std::vector<BenchResult>& current, const std::vector<BenchResult>& baseline, double tolerance)
+{
+    int regressions = 0;
+
+    for (const BenchResult& r : current)
+    {
+        auto match = std::find_if(baseline.begin(), baseline.end(),
+            [&](const BenchResult& b) { return b.name == r.name; });
+
+        if (match == baseline.end() || match->p50_ns <= 0.0)
+        {
+            std::cout << "  new   " << r.name << std::endl;
+            continue;
+        }
+
+        double ratio = r.p50_ns / match->p50_ns;
+        bool   slower = ratio > 1.0 + tolerance;
+        regressions += slower ? 1 : 0;
+
+        char line[256];
+        std::snprintf(line, sizeof(line), "  %-5s %-44s %6.2fx", slower ? "SLOW" : "ok", r.name.c_str(), ratio);
+        std::cout << line << std::endl;
+    }
+
+    return regressions;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+
+struct BenchResult
+{
+    std::string name;
+    std::string unit;          // what one item is, for the throughput figure
+    double      itemsPerCall = 1.0;
+    size_t      samples = 0;
+    size_t      callsPerSample = 0;
+    double      mean_ns = 0.0; // per call
+    double      p50_ns = 0.0;
+    double      p90_ns = 0.0;
+    double      p99_ns = 0.0;
+    double      min_ns = 0.0;
+    double      throughput = 0.0; // items per second at the median
+};
+
+// Times a callable in samples long enough to swamp the clock resolution and
+// reports per-call statistics over the samples.
+class BenchmarkRunner
+{
+public:
+    struct Settings
+    {
+        size_t      samples = 30;
+        double      minSample_s = 0.005;
+        double      warmup_s = 0.05;
+        std::string filter;    // run only cases whose name contains this
+    };
+
+    explicit BenchmarkRunner(const Settings& settings) : settings(settings) {}
+
+    bool enabled(const std::string& name) const;
+    void run(const std::string& name, double itemsPerCall, const std::string& unit, const std::function<void()>& call);
+
+    const std::vector<BenchResult>& results() const { return all; }
+
+private:
+    Settings settings;
+    std::vector<BenchResult> all;
+};
+
+bool writeResultsJson(const std::string& path, const std::vector<BenchResult>& results, std::string& error);
+bool readResultsJson(const std::string& path, std::vector<BenchResult>& results, std::string& error);
+
+// Prints each case's median against the baseline and returns the number of
+// cases slower than baseline * (1 + tolerance).
+int compareWithBaseline(const std::vector<BenchResult>& current, const std::vector<BenchResult>& baseline, double tolerance);
@@ -0,0 +1,437 @@
+#define _USE_MATH_DEFINES
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <glm/gtc/matrix_transform.hpp>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include "bench/Benchmark.h"
+#include "core/Bvh.h"
+#include "core/Geometry.h"
+#include "core/PotentialField.h"
+#include "core/ThreadPool.h"
+#include "physics/Collisions.h"
+#include "physics/Kepler.h"
+#include "physics/PhysicsSystem.h"
+#include "physics/Scenario.h"
+#include "physics/SimulationThread.h"
+#include "physics/TestParticles.h"
+
+namespace
+{
+    constexpr double AU = 1.495978707e11;
+
+    // A Sun and n - 1 light bodies on roughly circular orbits in a thick disc.
+    std::vector<BodyState> makeDisc(size_t n, uint64_t seed)
+    {
+        std::mt19937_64 rng(seed);
+        std::uniform_real_distribution<double> radius(0.3, 40.0);
+        std::uniform_real_distribution<double> angle(0.0, 2.0 * M_PI);
+        std::normal_distribution<double> tilt(0.0, 0.02);
+
+        const double sunMass = 1.989e30;
+        std::vector<BodyState> bodies;
+        bodies.push_back({ glm::dvec3(0.0), glm::dvec3(0.0), sunMass });
+
+        for (size_t i = 1; i < n; ++i)
+        {
+            double r = radius(rng) * AU;
+            double a = angle(rng);
+            double v = std::sqrt(PhysicsSystem::G * sunMass / r);
+            glm::dvec3 pos(r * std::cos(a), r * tilt(rng), r * std::sin(a));
+            glm::dvec3 vel(-v * std::sin(a), 0.0, v * std::cos(a));
+            bodies.push_back({ pos, vel, 1e20 + 1e24 * std::pow(rng() / double(rng.max()), 4.0) });
+        }
+        return bodies;
+    }
+
+    void benchPhysics(BenchmarkRunner& runner)
+    {
+        struct Case { GravitySolver solver; const char* name; size_t n; };
+        const Case cases[] = {
+            { GravitySolver::Direct, "direct", 64 },
+            { GravitySolver::Direct, "direct", 256 },
+            { GravitySolver::Direct, "direct", 1024 },
+            { GravitySolver::Direct, "direct", 4096 },
+            { GravitySolver::BarnesHut, "barnes-hut", 1024 },
+            { GravitySolver::BarnesHut, "barnes-hut", 4096 },
+            { GravitySolver::BarnesHut, "barnes-hut", 16384 },
+        };
+
+        for (const Case& c : cases)
+        {
+            std::string name = std::string("physics.update/") + c.name + "/N=" + std::to_string(c.n);
+            if (!runner.enabled(name))
+                continue;
+
+            PhysicsSystem physics;
+            physics.solver = c.solver;
+            physics.pool = &ThreadPool::global();
+            std::vector<BodyState> bodies = makeDisc(c.n, 42);
+
+            runner.run(name, static_cast<double>(c.n), "bodies", [&]()
+                {
+                    physics.update(bodies, 1.0 / 60.0);
+                });
+        }
+    }
+
+    // One leapfrog step of a main belt under the nine bodies of the built-in
+    // solar system, which stay put so every step costs the same.
+    void benchParticles(BenchmarkRunner& runner)
+    {
+        for (size_t n : { 10000, 100000 })
+        {
+            std::string name = "particles.step/particles=" + std::to_string(n);
+            if (!runner.enabled(name))
+                continue;
+
+            Scenario scenario = builtinSolarSystem();
+            BodySoA bodies;
+            bodies.assign(scenario.bodies);
+
+            TestParticles particles;
+            particles.pool = &ThreadPool::global();
+            particles.G = PhysicsSystem::G;
+            particles.soften = PhysicsSystem::SOFTEN;
+            generateBelt(mainAsteroidBelt(n), scenario.bodies[0], PhysicsSystem::G, particles.particles);
+
+            runner.run(name, static_cast<double>(n), "particles", [&]()
+                {
+                    particles.beginStep(bodies, 3600.0);
+                    particles.endStep(bodies, 3600.0);
+                });
+        }
+    }
+
+    // One closed-form evaluation of a main belt, the per-tick cost of the
+    // Kepler mode at any time-warp.
+    void benchKepler(BenchmarkRunner& runner)
+    {
+        for (size_t n : { 10000, 1000000 })
+        {
+            std::string name = "kepler.evaluate/orbits=" + std::to_string(n);
+            if (!runner.enabled(name))
+                continue;
+
+            Scenario scenario = builtinSolarSystem();
+            ParticleSoA belt;
+            generateBelt(mainAsteroidBelt(n), scenario.bodies[0], PhysicsSystem::G, belt);
+
+            KeplerOrbits orbits;
+            orbits.pool = &ThreadPool::global();
+            double mu = PhysicsSystem::G * scenario.bodies[0].mass_kg;
+            for (size_t i = 0; i < n; ++i)
+                orbits.add(glm::dvec3(belt.x[i], belt.y[i], belt.z[i]), glm::dvec3(belt.vx[i], belt.vy[i], belt.vz[i]), mu);
+
+            double t = 0.0;
+            runner.run(name, static_cast<double>(n), "orbits", [&]()
+                {
+                    t += 86400.0 * 365.25;
+                    orbits.evaluate(t, belt.x.data(), belt.y.data(), belt.z.data(), belt.vx.data(), belt.vy.data(), belt.vz.data());
+                });
+        }
+    }
+
+    // Broad and narrow phase over one hour of disc motion, for comparison
+    // with physics.update at the same N.
+    void benchCollisions(BenchmarkRunner& runner)
+    {
+        for (size_t n : { 1024, 16384, 100000 })
+        {
+            std::string name = "collisions.resolve/bodies=" + std::to_string(n);
+            if (!runner.enabled(name))
+                continue;
+
+            std::vector<BodyState> disc = makeDisc(n, 42);
+            for (BodyState& b : disc)
+                b.radius_m = sphereRadius_m(b.mass_kg, 3000.0);
+            disc[0].radius_m = 6.96e8;
+
+            BodySoA bodies;
+            bodies.assign(disc);
+            CollisionSystem collisions;
+            collisions.pool = &ThreadPool::global();
+            std::vector<MergeEvent> merges;
+
+            runner.run(name, static_cast<double>(n), "bodies", [&]()
+                {
+                    merges.clear();
+                    collisions.resolve(bodies, 3600.0, 0.0, merges);
+                });
+        }
+    }
+
+    void benchMeshes(BenchmarkRunner& runner)
+    {
+        for (int depth = 1; depth <= 6; ++depth)
+        {
+            MeshData mesh;
+            double triangles = 20.0 * std::pow(4.0, depth);
+            runner.run("mesh.icosphere/depth=" + std::to_string(depth), triangles, "triangles", [&]()
+                {
+                    buildIcosphere(1.0f, depth, mesh);
+                });
+        }
+    }
+
+    void benchGrid(BenchmarkRunner& runner)
+    {
+        for (int divisions : { 50, 100, 200, 400 })
+        {
+            double lines = 2.0 * (2 * divisions + 1) * (2 * divisions);
+            runner.run("grid.lines/divisions=" + std::to_string(divisions), lines, "lines", [&]()
+                {
+                    std::vector<glm::vec3> points;
+                    std::vector<float> vertices = buildGridLines(10000.0f, divisions, 0.0f, &points);
+                    if (vertices.empty())
+                        std::abort();
+                });
+        }
+    }
+
+    // Grid warp for the default Grid(10000, 200): 401 x 401 texels.
+    void benchField(BenchmarkRunner& runner)
+    {
+        for (size_t n : { 9, 100, 1000 })
+        {
+            for (bool tree : { false, true })
+            {
+                std::string name = std::string("grid.field/") + (tree ? "tree" : "direct") + "/bodies=" + std::to_string(n);
+                if (!runner.enabled(name))
+                    continue;
+
+                std::mt19937 rng(11);
+                std::uniform_real_distribution<float> coord(-4000.0f, 4000.0f);
+                std::vector<glm::vec3> positions(n);
+                std::vector<float> masses(n, 1.0f);
+                for (size_t i = 0; i < n; ++i)
+                    positions[i] = glm::vec3(coord(rng), 0.0f, coord(rng));
+                masses[0] = 333000.0f;
+
+                PotentialField field;
+                field.configure(10000.0f, 401);
+                field.pool = &ThreadPool::global();
+                field.useTree = tree;
+
+                runner.run(name, 401.0 * 401.0, "texels", [&]()
+                    {
+                        field.compute(positions, masses);
+                    });
+            }
+        }
+    }
+
+    // The hover test in UIManager::renderPlanetPopup: nearest sphere hit by the mouse ray.
+    void benchPicking(BenchmarkRunner& runner)
+    {
+        for (size_t n : { 10, 100, 1000, 10000 })
+        {
+            std::string name = "pick.ray/bodies=" + std::to_string(n);
+            if (!runner.enabled(name))
+                continue;
+
+            std::mt19937 rng(7);
+            std::uniform_real_distribution<float> coord(-5000.0f, 5000.0f);
+            std::vector<glm::vec3> centers(n);
+            std::vector<float> radii(n);
+            for (size_t i = 0; i < n; ++i)
+            {
+                centers[i] = glm::vec3(coord(rng), coord(rng) * 0.05f, coord(rng));
+                radii[i] = std::max(0.5f + (rng() % 100) * 0.1f, 18.0f);
+            }
+
+            glm::vec3 origin(0.0f, 800.0f, 6000.0f);
+            glm::vec3 direction = glm::normalize(centers[n / 2] - origin);
+            int hovered = -1;
+
+            runner.run(name, static_cast<double>(n), "bodies", [&]()
+                {
+                    hovered = -1;
+                    float minDist2 = std::numeric_limits<float>::max();
+                    for (size_t i = 0; i < n; ++i)
+                    {
+                        if (raySphereHit(origin, direction, centers[i], radii[i]))
+                        {
+                            glm::vec3 d = centers[i] - origin;
+                            float d2 = glm::dot(d, d);
+                            if (d2 < minDist2)
+                            {
+                                minDist2 = d2;
+                                hovered = static_cast<int>(i);
+                            }
+                        }
+                    }
+                });
+
+            if (hovered < 0)
+                std::cerr << "pick.ray: expected a hit" << std::endl;
+        }
+    }
+
+    // The same scene through the Bvh: refit to moved positions, the hover
+    // ray, and the view frustum cull of main.cpp.
+    void benchBvh(BenchmarkRunner& runner)
+    {
+        for (size_t n : { 10000, 100000, 1000000 })
+        {
+            std::string suffix = "/bodies=" + std::to_string(n);
+            if (!runner.enabled("bvh.refit" + suffix) && !runner.enabled("bvh.pick" + suffix) && !runner.enabled("bvh.cull" + suffix))
+                continue;
+
+            std::mt19937 rng(7);
+            std::uniform_real_distribution<float> coord(-5000.0f, 5000.0f);
+            std::vector<glm::vec3> centers(n);
+            std::vector<float> pickRadii(n), drawRadii(n);
+            for (size_t i = 0; i < n; ++i)
+            {
+                centers[i] = glm::vec3(coord(rng), coord(rng) * 0.05f, coord(rng));
+                drawRadii[i] = 0.5f + (rng() % 100) * 0.1f;
+                pickRadii[i] = std::max(drawRadii[i], 18.0f);
+            }
+
+            Bvh bvh;
+            bvh.pool = &ThreadPool::global();
+            bvh.update(centers, pickRadii, drawRadii);
+
+            float drift = 0.01f;
+            runner.run("bvh.refit" + suffix, static_cast<double>(n), "bodies", [&]()
+                {
+                    centers[0].x += drift;
+                    drift = -drift;
+                    bvh.update(centers, pickRadii, drawRadii);
+                });
+
+            glm::vec3 origin(0.0f, 800.0f, 6000.0f);
+            glm::vec3 direction = glm::normalize(centers[n / 2] - origin);
+            uint32_t hovered = Bvh::NONE;
+            runner.run("bvh.pick" + suffix, 1.0, "rays", [&]()
+                {
+                    hovered = bvh.raycast(origin, direction);
+                });
+            if (hovered == Bvh::NONE)
+                std::cerr << "bvh.pick: expected a hit" << std::endl;
+
+            glm::mat4 viewProjection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.01f, 10000.0f) *
+                glm::lookAt(origin, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+            Frustum frustum = Frustum::fromMatrix(viewProjection);
+            std::vector<uint32_t> visible;
+            runner.run("bvh.cull" + suffix, static_cast<double>(n), "bodies", [&]()
+                {
+                    bvh.cull(frustum, visible);
+                });
+        }
+    }
+
+    // The per-frame copy in main.cpp: blend the snapshot, convert to world
+    // units and write each position into the registry by id.
+    void benchSync(BenchmarkRunner& runner)
+    {
+        for (size_t n : { 9, 1000, 100000 })
+        {
+            std::vector<BodyState> bodies = makeDisc(n, 3);
+            BodyRegistry registry;
+            BodySnapshot snapshot;
+            for (const BodyState& b : bodies)
+            {
+                snapshot.previous_m.push_back(b.pos_m);
+                snapshot.current_m.push_back(b.pos_m + b.vel_m * 3600.0);
+                snapshot.ids.push_back(registry.add("body", b, glm::vec3(1.0f)));
+            }
+
+            runner.run("sync.interpolate/bodies=" + std::to_string(n), static_cast<double>(n), "bodies", [&]()
+                {
+                    interpolatePositions(snapshot, 0.37, registry);
+                });
+        }
+    }
+
+    void printUsage()
+    {
+        std::cout <<
+            "Usage: solarsim_bench [options]\n"
+            "  --json <file>        write results as JSON\n"
+            "  --baseline <file>    compare medians against a previous --json run\n"
+            "  --tolerance <frac>   allowed slowdown before a case fails (default 0.10)\n"
+            "  --filter <text>      run only cases whose name contains text\n"
+            "  --samples <n>        samples per case (default 30)\n"
+            "  --threads <n>        thread pool size for physics cases\n";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    BenchmarkRunner::Settings settings;
+    std::string jsonPath, baselinePath;
+    double tolerance = 0.10;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h" || i + 1 >= argc)
+        {
+            printUsage();
+            return arg == "--help" || arg == "-h" ? 0 : 1;
+        }
+
+        std::string value = argv[++i];
+        if (arg == "--json")
+            jsonPath = value;
+        else if (arg == "--baseline")
+            baselinePath = value;
+        else if (arg == "--tolerance")
+            tolerance = std::atof(value.c_str());
+        else if (arg == "--filter")
+            settings.filter = value;
+        else if (arg == "--samples")
+            settings.samples = std::max(1, std::atoi(value.c_str()));
+        else if (arg == "--threads")
+            ThreadPool::global().setThreadCount(static_cast<unsigned>(std::atoi(value.c_str())));
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    BenchmarkRunner runner(settings);
+    benchPhysics(runner);
+    benchParticles(runner);
+    benchKepler(runner);
+    benchCollisions(runner);
+    benchMeshes(runner);
+    benchGrid(runner);
+    benchField(runner);
+    benchPicking(runner);
+    benchBvh(runner);
+    benchSync(runner);
+
+    std::string error;
+    if (!jsonPath.empty() && !writeResultsJson(jsonPath, runner.results(), error))
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+
+    if (!baselinePath.empty())
+    {
+        std::vector<BenchResult> baseline;
+        if (!readResultsJson(baselinePath, baseline, error))
+        {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+
+        std::cout << "\nAgainst " << baselinePath << " (tolerance " << tolerance * 100.0 << "%):" << std::endl;
+        int regressions = compareWithBaseline(runner.results(), baseline, tolerance);
+        if (regressions > 0)
+        {
+            std::cout << regressions << " case(s) slower than the baseline" << std::endl;
+            return 2;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,118 @@
+#include "core/BodyRegistry.h"
+#include "core/Constants.h"
+#include <algorithm>
+
+BodyId BodyRegistry::add(const std::string& name, const BodyState& body, const glm::vec3& color, int subdivisionCount)
+{
+    uint32_t slot;
+    if (!freeSlots.empty())
+    {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    else
+    {
+        slot = static_cast<uint32_t>(generations.size());
+        generations.push_back(0);
+        denseOfSlot.push_back(0);
+    }
+
+    constexpr double PI = 3.14159265358979323846;
+    double volume = 4.0 / 3.0 * PI * body.radius_m * body.radius_m * body.radius_m;
+
+    BodyId id = (static_cast<uint32_t>(generations[slot]) << SLOT_BITS) | slot;
+    denseOfSlot[slot] = static_cast<uint32_t>(ids.size());
+
+    ids.push_back(id);
+    names.push_back(name);
+    positions.push_back(glm::vec3(body.pos_m / METERS_PER_WU));
+    colors.push_back(color);
+    masses.push_back(body.mass_kg);
+    densities.push_back(volume > 0.0 ? body.mass_kg / volume : 0.0);
+    visualScales.push_back(1.0f);
+    drawRadii.push_back(0.0f);
+    pickRadii.push_back(0.0f);
+    subdivisions.push_back(subdivisionCount);
+
+    setName(ids.size() - 1, name);
+    return id;
+}
+
+bool BodyRegistry::remove(BodyId id)
+{
+    size_t i = indexOf(id);
+    if (i == NPOS)
+        return false;
+
+    size_t last = ids.size() - 1;
+    if (i != last)
+    {
+        ids[i] = ids[last];
+        names[i] = std::move(names[last]);
+        positions[i] = positions[last];
+        colors[i] = colors[last];
+        masses[i] = masses[last];
+        densities[i] = densities[last];
+        visualScales[i] = visualScales[last];
+        drawRadii[i] = drawRadii[last];
+        pickRadii[i] = pickRadii[last];
+        subdivisions[i] = subdivisions[last];
+        denseOfSlot[ids[i] & SLOT_MASK] = static_cast<uint32_t>(i);
+    }
+
+    ids.pop_back();
+    names.pop_back();
+    positions.pop_back();
+    colors.pop_back();
+    masses.pop_back();
+    densities.pop_back();
+    visualScales.pop_back();
+    drawRadii.pop_back();
+    pickRadii.pop_back();
+    subdivisions.pop_back();
+
+    uint32_t slot = id & SLOT_MASK;
+    if (generations[slot] < MAX_GENERATION)
+    {
+        ++generations[slot];
+        freeSlots.push_back(slot);
+    }
+    return true;
+}
+
+void BodyRegistry::clear()
+{
+    while (!ids.empty())
+        remove(ids.back());
+}
+
+size_t BodyRegistry::indexOf(BodyId id) const
+{
+    uint32_t slot = id & SLOT_MASK;
+    if (slot >= generations.size() || generations[slot] != (id >> SLOT_BITS))
+        return NPOS;
+
+    size_t i = denseOfSlot[slot];
+    return i < ids.size() && ids[i] == id ? i : NPOS;
+}
+
+void BodyRegistry::setName(size_t i, const std::string& name)
+{
+    names[i] = name;
+    visualScales[i] = (name == "Sun") ? 0.4f : 1.0f;
+    updateRadii(i);
+}
+
+void BodyRegistry::setMass(size_t i, double mass_kg, double density_kg_m3)
+{
+    masses[i] = mass_kg;
+    densities[i] = density_kg_m3;
+    updateRadii(i);
+}
+
+void BodyRegistry::updateRadii(size_t i)
+{
+    float radius = getRadius(i);
+    drawRadii[i] = radius * visualScales[i];
+    pickRadii[i] = std::max(radius, MIN_PICK_RADIUS);
+}
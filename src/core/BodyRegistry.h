@@ -0,0 +1,76 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "physics/BodyState.h"
+
+// The render thread's record of every body: one column per attribute, in
+// dense order, read directly by the renderer, the BVH, the grid and the UI.
+// The physics thread keeps the double-precision state in BodySoA and refers
+// to the same bodies by id, so neither side depends on the other's order.
+//
+// An id packs a slot (low SLOT_BITS bits) with the slot's generation, which
+// is bumped when the body is removed, so the id of a removed body stops
+// resolving. A slot whose generation would wrap is retired rather than
+// reused, so an old id never names a new body. Adding and removing are O(1);
+// removal moves the last body into the hole, so dense indices are only valid
+// until the next remove.
+class BodyRegistry
+{
+public:
+    static constexpr uint32_t SLOT_BITS = BODY_SLOT_BITS;
+    static constexpr uint32_t SLOT_MASK = BODY_SLOT_MASK;
+    static constexpr uint32_t MAX_GENERATION = (1u << (32 - SLOT_BITS)) - 1;
+    static constexpr BodyId   NONE = 0xffffffffu;   // never resolves
+    static constexpr size_t   NPOS = ~size_t(0);
+    static constexpr float    MIN_PICK_RADIUS = 18.0f;
+    static constexpr double   RADIUS_SCALE = 1e-7;   // drawn world units per metre of radius
+
+    // The position is taken from the state, in world units; the density
+    // from its mass and radius.
+    BodyId add(const std::string& name, const BodyState& body, const glm::vec3& color, int subdivisions = 3);
+    bool   remove(BodyId id);
+    void   clear();
+
+    size_t size() const { return ids.size(); }
+    bool   contains(BodyId id) const { return indexOf(id) != NPOS; }
+    size_t indexOf(BodyId id) const;   // NPOS once removed
+
+    void setName(size_t i, const std::string& name);
+    void setMass(size_t i, double mass_kg, double density_kg_m3);
+
+    const std::vector<BodyId>&      getIds() const          { return ids; }
+    const std::vector<std::string>& getNames() const        { return names; }
+    const std::vector<glm::vec3>&   getPositions() const    { return positions; }
+    std::vector<glm::vec3>&         getPositions()          { return positions; }
+    const std::vector<glm::vec3>&   getColors() const       { return colors; }
+    const std::vector<double>&      getMasses() const       { return masses; }
+    const std::vector<double>&      getDensities() const    { return densities; }
+    const std::vector<float>&       getDrawRadii() const    { return drawRadii; }   // visual scale applied
+    const std::vector<float>&       getPickRadii() const    { return pickRadii; }   // never below MIN_PICK_RADIUS
+    const std::vector<int>&         getSubdivisions() const { return subdivisions; }
+
+    // Unscaled radius in world units, and the physical one.
+    float  getRadius(size_t i) const   { return static_cast<float>(getRadius_m(i) * RADIUS_SCALE); }
+    double getRadius_m(size_t i) const { return sphereRadius_m(masses[i], densities[i]); }
+
+private:
+    std::vector<BodyId>      ids;
+    std::vector<std::string> names;
+    std::vector<glm::vec3>   positions;
+    std::vector<glm::vec3>   colors;
+    std::vector<double>      masses;
+    std::vector<double>      densities;
+    std::vector<float>       visualScales;   // drawn size relative to radius
+    std::vector<float>       drawRadii;
+    std::vector<float>       pickRadii;
+    std::vector<int>         subdivisions;
+
+    std::vector<uint32_t> denseOfSlot;   // meaningful only while the slot is live
+    std::vector<uint8_t>  generations;
+    std::vector<uint32_t> freeSlots;
+
+    void updateRadii(size_t i);
+};
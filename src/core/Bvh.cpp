@@ -0,0 +1,390 @@
+#include "core/Bvh.h"
+#include "core/Geometry.h"
+#include "core/Profiler.h"
+#include "core/ThreadPool.h"
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+    constexpr size_t REFIT_GRAIN = 4096;
+    constexpr int    MAX_STACK = 64;
+
+    glm::vec4 row(const glm::mat4& m, int i)
+    {
+        return glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+    }
+
+    glm::vec4 normalizePlane(const glm::vec4& plane)
+    {
+        float length = glm::length(glm::vec3(plane));
+        return length > 0.0f ? plane / length : plane;
+    }
+
+    float surfaceArea(const glm::vec3& min, const glm::vec3& max)
+    {
+        glm::vec3 e = glm::max(max - min, glm::vec3(0.0f));
+        return 2.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+    }
+
+    // Slab test against the whole line, both directions from the origin,
+    // like raySphereHit.
+    bool lineHitsBox(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3& inverse,
+        const glm::vec3& min, const glm::vec3& max)
+    {
+        float tNear = -std::numeric_limits<float>::infinity();
+        float tFar = std::numeric_limits<float>::infinity();
+        for (int a = 0; a < 3; ++a)
+        {
+            if (direction[a] == 0.0f)
+            {
+                if (origin[a] < min[a] || origin[a] > max[a])
+                    return false;
+                continue;
+            }
+            float t0 = (min[a] - origin[a]) * inverse[a];
+            float t1 = (max[a] - origin[a]) * inverse[a];
+            tNear = std::max(tNear, std::min(t0, t1));
+            tFar = std::min(tFar, std::max(t0, t1));
+            if (tNear > tFar)
+                return false;
+        }
+        return true;
+    }
+
+    float boxDistance2(const glm::vec3& p, const glm::vec3& min, const glm::vec3& max)
+    {
+        glm::vec3 d = glm::max(glm::max(min - p, p - max), glm::vec3(0.0f));
+        return glm::dot(d, d);
+    }
+
+    bool insidePolygon(const glm::vec2& p, const std::vector<glm::vec2>& polygon)
+    {
+        bool inside = false;
+        for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++)
+        {
+            const glm::vec2& a = polygon[i];
+            const glm::vec2& b = polygon[j];
+            if ((a.y > p.y) != (b.y > p.y) && p.x < (b.x - a.x) * (p.y - a.y) / (b.y - a.y) + a.x)
+                inside = !inside;
+        }
+        return inside;
+    }
+}
+
+Frustum Frustum::fromMatrix(const glm::mat4& viewProjection)
+{
+    return fromRect(viewProjection, glm::vec2(-1.0f), glm::vec2(1.0f));
+}
+
+Frustum Frustum::fromRect(const glm::mat4& viewProjection, const glm::vec2& ndcMin, const glm::vec2& ndcMax)
+{
+    glm::vec4 x = row(viewProjection, 0);
+    glm::vec4 y = row(viewProjection, 1);
+    glm::vec4 z = row(viewProjection, 2);
+    glm::vec4 w = row(viewProjection, 3);
+
+    Frustum f;
+    f.planes[0] = normalizePlane(x - ndcMin.x * w);
+    f.planes[1] = normalizePlane(ndcMax.x * w - x);
+    f.planes[2] = normalizePlane(y - ndcMin.y * w);
+    f.planes[3] = normalizePlane(ndcMax.y * w - y);
+    f.planes[4] = normalizePlane(w + z);
+    f.planes[5] = normalizePlane(w - z);
+    return f;
+}
+
+bool Frustum::intersectsSphere(const glm::vec3& center, float radius) const
+{
+    for (const glm::vec4& plane : planes)
+    {
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+            return false;
+    }
+    return true;
+}
+
+void Bvh::update(const std::vector<glm::vec3>& centers, const std::vector<float>& pickRadii,
+    const std::vector<float>& drawRadii)
+{
+    PROFILE_SCOPE("bvh.update");
+
+    bool rebuild = centers.size() != order.size();
+    if (rebuild)
+        build(centers);
+
+    double area = refit(centers, pickRadii, drawRadii);
+
+    if (!rebuild && area > REBUILD_GROWTH * builtArea)
+    {
+        build(centers);
+        area = refit(centers, pickRadii, drawRadii);
+        rebuild = true;
+    }
+    if (rebuild)
+        builtArea = area;
+}
+
+// Partitions copies of the centres rather than indices into them, so the
+// median splits run over contiguous memory.
+void Bvh::build(const std::vector<glm::vec3>& centers)
+{
+    uint32_t count = static_cast<uint32_t>(centers.size());
+    items.resize(count);
+    for (uint32_t i = 0; i < count; ++i)
+        items[i] = { centers[i], i };
+
+    nodes.clear();
+    nodes.reserve(count > 0 ? 2 * ((count + LEAF_SIZE - 1) / LEAF_SIZE) : 0);
+    if (count > 0)
+        buildNode(0, count);
+
+    order.resize(count);
+    for (uint32_t i = 0; i < count; ++i)
+        order[i] = items[i].body;
+    ++rebuilds;
+}
+
+uint32_t Bvh::buildNode(uint32_t first, uint32_t count)
+{
+    uint32_t index = static_cast<uint32_t>(nodes.size());
+    nodes.push_back({ glm::vec3(0.0f), first, glm::vec3(0.0f), count, 0 });
+    if (count <= LEAF_SIZE)
+        return index;
+
+    glm::vec3 lo(std::numeric_limits<float>::max());
+    glm::vec3 hi(-std::numeric_limits<float>::max());
+    for (uint32_t i = first; i < first + count; ++i)
+    {
+        lo = glm::min(lo, items[i].center);
+        hi = glm::max(hi, items[i].center);
+    }
+    glm::vec3 extent = hi - lo;
+    int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+
+    uint32_t half = count / 2;
+    std::nth_element(items.begin() + first, items.begin() + first + half, items.begin() + first + count,
+        [axis](const BuildItem& a, const BuildItem& b) { return a.center[axis] < b.center[axis]; });
+
+    buildNode(first, half);
+    uint32_t right = buildNode(first + half, count - half);
+    nodes[index].right = right;
+    return index;
+}
+
+// Leaves copy their bodies into leaf order and take their boxes from them
+// (in parallel), then every inner node from its children. Children always
+// follow their parent, so one pass from the back does the inner nodes.
+// Returns the summed surface area.
+double Bvh::refit(const std::vector<glm::vec3>& centers, const std::vector<float>& pickRadii,
+    const std::vector<float>& drawRadii)
+{
+    spheres.resize(order.size());
+    this->drawRadii.resize(order.size());
+
+    auto fitLeaves = [&](size_t begin, size_t end)
+        {
+            for (size_t n = begin; n < end; ++n)
+            {
+                Node& node = nodes[n];
+                if (node.count > LEAF_SIZE)
+                    continue;
+
+                glm::vec3 lo(std::numeric_limits<float>::max());
+                glm::vec3 hi(-std::numeric_limits<float>::max());
+                for (uint32_t slot = node.first; slot < node.first + node.count; ++slot)
+                {
+                    uint32_t body = order[slot];
+                    spheres[slot] = glm::vec4(centers[body], pickRadii[body]);
+                    this->drawRadii[slot] = drawRadii[body];
+
+                    float radius = std::max(pickRadii[body], drawRadii[body]);
+                    lo = glm::min(lo, centers[body] - radius);
+                    hi = glm::max(hi, centers[body] + radius);
+                }
+                node.min = lo;
+                node.max = hi;
+            }
+        };
+
+    if (pool)
+        pool->parallelFor(nodes.size(), REFIT_GRAIN, fitLeaves);
+    else
+        fitLeaves(0, nodes.size());
+
+    double area = 0.0;
+    for (size_t n = nodes.size(); n-- > 0;)
+    {
+        Node& node = nodes[n];
+        if (node.count > LEAF_SIZE)
+        {
+            const Node& left = nodes[n + 1];
+            const Node& right = nodes[node.right];
+            node.min = glm::min(left.min, right.min);
+            node.max = glm::max(left.max, right.max);
+        }
+        area += surfaceArea(node.min, node.max);
+    }
+    return area;
+}
+
+// Nodes are visited nearest first, and skipped once their box is farther
+// from the origin than the best centre so far: every centre lies inside its
+// node's box, so nothing in them can be nearer.
+uint32_t Bvh::raycast(const glm::vec3& origin, const glm::vec3& direction) const
+{
+    PROFILE_SCOPE("bvh.raycast");
+
+    if (nodes.empty())
+        return NONE;
+
+    glm::vec3 inverse(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+    float    best = std::numeric_limits<float>::max();
+    uint32_t hit = NONE;
+
+    struct Entry { uint32_t node; float distance2; };
+    Entry stack[MAX_STACK];
+    int top = 0;
+
+    if (lineHitsBox(origin, direction, inverse, nodes[0].min, nodes[0].max))
+        stack[top++] = { 0, boxDistance2(origin, nodes[0].min, nodes[0].max) };
+
+    while (top > 0)
+    {
+        Entry entry = stack[--top];
+        if (entry.distance2 > best)
+            continue;
+
+        const Node& node = nodes[entry.node];
+        if (node.count <= LEAF_SIZE)
+        {
+            for (uint32_t slot = node.first; slot < node.first + node.count; ++slot)
+            {
+                glm::vec3 center(spheres[slot]);
+                if (!raySphereHit(origin, direction, center, spheres[slot].w))
+                    continue;
+
+                glm::vec3 d = center - origin;
+                float d2 = glm::dot(d, d);
+                uint32_t body = order[slot];
+                if (d2 < best || (d2 == best && body < hit))
+                {
+                    best = d2;
+                    hit = body;
+                }
+            }
+            continue;
+        }
+
+        Entry children[2];
+        int found = 0;
+        for (uint32_t child : { entry.node + 1, node.right })
+        {
+            const Node& c = nodes[child];
+            if (lineHitsBox(origin, direction, inverse, c.min, c.max))
+                children[found++] = { child, boxDistance2(origin, c.min, c.max) };
+        }
+        if (found == 2 && children[0].distance2 < children[1].distance2)
+            std::swap(children[0], children[1]);
+        for (int i = 0; i < found; ++i)
+            stack[top++] = children[i];
+    }
+    return hit;
+}
+
+// Calls visit(slot) for every body that passes; whole subtrees inside all
+// six planes are taken without testing their bodies.
+template <typename Visit>
+void Bvh::collect(const Frustum& frustum, bool centersOnly, Visit&& visit) const
+{
+    if (nodes.empty())
+        return;
+
+    uint32_t stack[MAX_STACK];
+    int top = 0;
+    stack[top++] = 0;
+
+    while (top > 0)
+    {
+        const Node& node = nodes[stack[--top]];
+        uint32_t index = static_cast<uint32_t>(&node - nodes.data());
+
+        bool outside = false;
+        bool inside = true;
+        for (const glm::vec4& plane : frustum.planes)
+        {
+            glm::vec3 n(plane);
+            glm::vec3 outer(n.x >= 0.0f ? node.max.x : node.min.x, n.y >= 0.0f ? node.max.y : node.min.y, n.z >= 0.0f ? node.max.z : node.min.z);
+            glm::vec3 inner(n.x >= 0.0f ? node.min.x : node.max.x, n.y >= 0.0f ? node.min.y : node.max.y, n.z >= 0.0f ? node.min.z : node.max.z);
+            if (glm::dot(n, outer) + plane.w < 0.0f)
+            {
+                outside = true;
+                break;
+            }
+            inside = inside && glm::dot(n, inner) + plane.w >= 0.0f;
+        }
+        if (outside)
+            continue;
+
+        if (inside)
+        {
+            for (uint32_t slot = node.first; slot < node.first + node.count; ++slot)
+                visit(slot);
+        }
+        else if (node.count <= LEAF_SIZE)
+        {
+            for (uint32_t slot = node.first; slot < node.first + node.count; ++slot)
+            {
+                if (frustum.intersectsSphere(glm::vec3(spheres[slot]), centersOnly ? 0.0f : drawRadii[slot]))
+                    visit(slot);
+            }
+        }
+        else
+        {
+            stack[top++] = node.right;
+            stack[top++] = index + 1;
+        }
+    }
+}
+
+void Bvh::cull(const Frustum& frustum, std::vector<uint32_t>& out) const
+{
+    PROFILE_SCOPE("bvh.cull");
+
+    out.clear();
+    collect(frustum, false, [&](uint32_t slot) { out.push_back(order[slot]); });
+}
+
+void Bvh::selectCenters(const Frustum& frustum, std::vector<uint32_t>& out) const
+{
+    out.clear();
+    collect(frustum, true, [&](uint32_t slot) { out.push_back(order[slot]); });
+}
+
+// The polygon's bounding rectangle narrows the candidates through the tree;
+// only those are projected and tested against the polygon itself.
+void Bvh::selectPolygon(const glm::mat4& viewProjection, const std::vector<glm::vec2>& polygon_ndc,
+    std::vector<uint32_t>& out) const
+{
+    PROFILE_SCOPE("bvh.select");
+
+    out.clear();
+    if (polygon_ndc.size() < 3)
+        return;
+
+    glm::vec2 lo = polygon_ndc[0];
+    glm::vec2 hi = polygon_ndc[0];
+    for (const glm::vec2& p : polygon_ndc)
+    {
+        lo = glm::min(lo, p);
+        hi = glm::max(hi, p);
+    }
+
+    Frustum frustum = Frustum::fromRect(viewProjection, glm::max(lo, glm::vec2(-1.0f)), glm::min(hi, glm::vec2(1.0f)));
+    collect(frustum, true, [&](uint32_t slot)
+        {
+            glm::vec4 clip = viewProjection * glm::vec4(glm::vec3(spheres[slot]), 1.0f);
+            if (clip.w > 0.0f && insidePolygon(glm::vec2(clip) / clip.w, polygon_ndc))
+                out.push_back(order[slot]);
+        });
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+class ThreadPool;
+
+// Planes (a, b, c, d) of a view volume with unit normals pointing inwards:
+// a point p is inside a plane when dot(plane.xyz, p) + plane.w >= 0.
+struct Frustum
+{
+    glm::vec4 planes[6];
+
+    // Clip planes of a view-projection matrix (Gribb and Hartmann).
+    static Frustum fromMatrix(const glm::mat4& viewProjection);
+
+    // The part of the view volume that projects into [ndcMin, ndcMax].
+    static Frustum fromRect(const glm::mat4& viewProjection, const glm::vec2& ndcMin, const glm::vec2& ndcMax);
+
+    bool intersectsSphere(const glm::vec3& center, float radius) const;
+};
+
+// Bounding volume hierarchy over body spheres for the per-frame queries of
+// the renderer and the UI. Every body has a pick radius (never below
+// BodyRegistry::MIN_PICK_RADIUS) and a drawn radius; node boxes enclose the
+// larger of the two, so the same tree answers ray picks and frustum culls.
+//
+// update() refits the boxes to new positions bottom-up. The tree is rebuilt
+// from scratch (median split along the widest axis) only when the body count
+// changes or the refitted boxes have grown to REBUILD_GROWTH times the
+// surface area they had when built. Bodies are stored in leaf order, and
+// every subtree covers a contiguous range of them. Nothing here touches OpenGL.
+class Bvh
+{
+public:
+    static constexpr uint32_t NONE = 0xffffffffu;
+    static constexpr uint32_t LEAF_SIZE = 4;
+    static constexpr float    REBUILD_GROWTH = 2.0f;
+
+    ThreadPool* pool = nullptr;   // refits serially when null
+
+    void update(const std::vector<glm::vec3>& centers, const std::vector<float>& pickRadii,
+        const std::vector<float>& drawRadii);
+
+    // Body whose pick sphere the line through origin along direction touches
+    // with the smallest centre distance from origin, or NONE. The same answer
+    // as testing raySphereHit on every pick sphere, ties going to the lower
+    // index.
+    uint32_t raycast(const glm::vec3& origin, const glm::vec3& direction) const;
+
+    // Bodies whose drawn sphere touches the frustum, in leaf order.
+    void cull(const Frustum& frustum, std::vector<uint32_t>& out) const;
+
+    // Bodies whose centre lies inside the frustum, in leaf order.
+    void selectCenters(const Frustum& frustum, std::vector<uint32_t>& out) const;
+
+    // Bodies in front of the camera whose centre projects inside the closed
+    // polygon, given in normalized device coordinates.
+    void selectPolygon(const glm::mat4& viewProjection, const std::vector<glm::vec2>& polygon_ndc,
+        std::vector<uint32_t>& out) const;
+
+    size_t size() const { return order.size(); }
+    size_t nodeCount() const { return nodes.size(); }
+    uint32_t rebuildCount() const { return rebuilds; }
+
+private:
+    struct Node
+    {
+        glm::vec3 min;
+        uint32_t  first;   // first body in leaf order
+        glm::vec3 max;
+        uint32_t  count;   // bodies in the subtree; a leaf when <= LEAF_SIZE
+        uint32_t  right;   // right child; the left child is the next node
+    };
+
+    std::vector<Node> nodes;
+    std::vector<uint32_t> order;       // body index of each leaf slot
+    std::vector<glm::vec4> spheres;    // leaf order: centre, pick radius
+    std::vector<float> drawRadii;      // leaf order
+    double builtArea = 0.0;
+    uint32_t rebuilds = 0;
+
+    struct BuildItem
+    {
+        glm::vec3 center;
+        uint32_t  body;
+    };
+    std::vector<BuildItem> items;   // build scratch
+
+    void build(const std::vector<glm::vec3>& centers);
+    uint32_t buildNode(uint32_t first, uint32_t count);
+    double refit(const std::vector<glm::vec3>& centers, const std::vector<float>& pickRadii,
+        const std::vector<float>& drawRadii);
+
+    template <typename Visit>
+    void collect(const Frustum& frustum, bool centersOnly, Visit&& visit) const;
+};
@@ -7,14 +7,14 @@ Camera::Camera(glm::vec3 startPosition)
 }
 
 glm::mat4 Camera::getViewMatrix() {
-    if (mode == CameraMode::ORBITAL && orbitalTarget != nullptr) {
-        float camX = orbitalTarget->x + orbitalDistance * cos(glm::radians(pitch)) * cos(glm::radians(yaw));
-        float camY = orbitalTarget->y + orbitalDistance * sin(glm::radians(pitch));
-        float camZ = orbitalTarget->z + orbitalDistance * cos(glm::radians(pitch)) * sin(glm::radians(yaw));
+    if (mode == CameraMode::ORBITAL && hasTarget) {
+        float camX = orbitalTarget.x + orbitalDistance * cos(glm::radians(pitch)) * cos(glm::radians(yaw));
+        float camY = orbitalTarget.y + orbitalDistance * sin(glm::radians(pitch));
+        float camZ = orbitalTarget.z + orbitalDistance * cos(glm::radians(pitch)) * sin(glm::radians(yaw));
 
         this->position = glm::vec3(camX, camY, camZ);
 
-        return glm::lookAt(this->position, *orbitalTarget, this->up);
+        return glm::lookAt(this->position, orbitalTarget, this->up);
     }
 
     return glm::lookAt(position, position + front, up);
@@ -71,7 +71,7 @@ void Camera::setMode(CameraMode newMode)
 
     if (mode == CameraMode::FREE) 
     {
-        orbitalTarget = nullptr; 
+        hasTarget = false;
     }
 }
 
@@ -80,10 +80,16 @@ CameraMode Camera::getMode() const
     return mode;
 }
 
-void Camera::setOrbitalTarget(const glm::vec3* targetPosition, float initialDistance) 
+void Camera::setOrbitalTarget(const glm::vec3& targetPosition, float initialDistance) 
 {
     orbitalTarget = targetPosition;
     orbitalDistance = initialDistance;
+    hasTarget = true;
+}
+
+void Camera::moveOrbitalTarget(const glm::vec3& targetPosition)
+{
+    orbitalTarget = targetPosition;
 }
 
 glm::vec3 Camera::getRayFromMouse(double mouseX, double mouseY, int screenWidth, int screenHeight, const glm::mat4 &view, const glm::mat4 &projection)
@@ -142,6 +148,6 @@ void Camera::update(float dt)
     position += step;
 }
 
-const glm::vec3 *Camera::getOrbitalTarget() const {
-    return orbitalTarget;
+bool Camera::hasOrbitalTarget() const {
+    return hasTarget;
 }
\ No newline at end of file
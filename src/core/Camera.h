@@ -27,8 +27,10 @@ public:
     glm::vec2 worldToScreen(const glm::vec3 &worldPos, const glm::mat4 &view, const glm::mat4 &projection, int screenWidth, int screenHeight);
     CameraMode getMode() const;
     void setMode(CameraMode newMode);
-    const glm::vec3* getOrbitalTarget() const;
-    void setOrbitalTarget(const glm::vec3 *targetPosition, float initialDistance);
+    bool hasOrbitalTarget() const;
+    void setOrbitalTarget(const glm::vec3 &targetPosition, float initialDistance);
+    // Follows a moving target without changing the orbit distance.
+    void moveOrbitalTarget(const glm::vec3 &targetPosition);
     void processMouseScroll(float yoffset);
 
     void processKeyboard(int key, float deltaTime);
@@ -43,6 +45,7 @@ private:
     float travelSpeed = 3000.0f;
 
     CameraMode mode = CameraMode::FREE;
-    const glm::vec3* orbitalTarget = nullptr;
+    bool hasTarget = false;
+    glm::vec3 orbitalTarget = glm::vec3(0.0f);
     float orbitalDistance = 100.0f;
 };
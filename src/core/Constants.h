@@ -1,3 +1,6 @@
 #pragma once
 
-constexpr double L_SCALE = 1.495978707e11;
\ No newline at end of file
+constexpr double L_SCALE = 1.495978707e11;
+
+// Simulation metres per render world unit.
+constexpr double METERS_PER_WU = 1.0e9;
\ No newline at end of file
@@ -0,0 +1,25 @@
+#include "core/FrameUniforms.h"
+#include "core/Shader.h"
+
+static_assert(sizeof(FrameData) == 3 * 64 + 3 * 16, "FrameData must match the std140 Frame block");
+
+FrameUniforms::FrameUniforms()
+{
+    glGenBuffers(1, &UBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORM_BINDING, UBO);
+}
+
+FrameUniforms::~FrameUniforms()
+{
+    glDeleteBuffers(1, &UBO);
+}
+
+void FrameUniforms::update(const FrameData& data)
+{
+    glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameData), &data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
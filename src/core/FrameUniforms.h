@@ -0,0 +1,36 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// CPU mirror of the std140 block every shader declares as
+//
+//     layout(std140) uniform Frame { mat4 view; mat4 projection;
+//         mat4 viewProjection; vec4 cameraPosition; vec4 time; vec4 viewport; };
+//
+// Only mat4 and vec4 members, so the C++ layout matches std140 exactly.
+struct FrameData
+{
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 viewProjection;
+    glm::vec4 cameraPosition;   // xyz in world units
+    glm::vec4 time;             // x: seconds since start, y: frame delta
+    glm::vec4 viewport;         // xy: size in pixels, z: pixels per world unit at distance 1
+};
+
+// The uniform buffer behind the Frame block, bound at FRAME_UNIFORM_BINDING.
+// Written once per frame; every program linked by Shader reads from it.
+class FrameUniforms
+{
+public:
+    FrameUniforms();
+    ~FrameUniforms();
+
+    FrameUniforms(const FrameUniforms&) = delete;
+    FrameUniforms& operator=(const FrameUniforms&) = delete;
+
+    void update(const FrameData& data);
+
+private:
+    GLuint UBO = 0;
+};
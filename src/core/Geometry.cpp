@@ -0,0 +1,148 @@
+#include "core/Geometry.h"
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+
+void buildIcosphere(float radius, int depth, MeshData& mesh)
+{
+    std::vector<glm::vec3>& vertices = mesh.vertices;
+    std::vector<unsigned int>& indices = mesh.indices;
+
+    float t = (1.0f + std::sqrt(5.0f)) / 2.0f;
+
+    vertices = {
+        glm::vec3(-1.0f,  t,  0.0f), glm::vec3(1.0f,  t,  0.0f),
+        glm::vec3(-1.0f, -t,  0.0f), glm::vec3(1.0f, -t,  0.0f),
+        glm::vec3(0.0f, -1.0f,  t), glm::vec3(0.0f,  1.0f,  t),
+        glm::vec3(0.0f, -1.0f, -t), glm::vec3(0.0f,  1.0f, -t),
+        glm::vec3(t,  0.0f, -1.0f), glm::vec3(t,  0.0f,  1.0f),
+        glm::vec3(-t,  0.0f, -1.0f), glm::vec3(-t,  0.0f,  1.0f)
+    };
+
+    for (auto& v : vertices)
+    {
+        v = glm::normalize(v) * radius;
+    }
+
+    indices = {
+        0u, 11u, 5u,  0u, 5u, 1u,  0u, 1u, 7u,  0u, 7u, 10u,  0u, 10u, 11u,
+        1u, 5u, 9u,  5u, 11u, 4u,  11u, 10u, 2u,  10u, 7u, 6u,  7u, 1u, 8u,
+        3u, 9u, 4u,  3u, 4u, 2u,  3u, 2u, 6u,  3u, 6u, 8u,  3u, 8u, 9u,
+        4u, 9u, 5u,  2u, 4u, 11u,  6u, 2u, 10u,  8u, 6u, 7u,  9u, 8u, 1u
+    };
+
+    // Each level quadruples the triangles; an edge is shared by two of them,
+    // so its midpoint is looked up by the packed (low, high) vertex pair.
+    size_t finalTriangles = indices.size() / 3;
+    for (int i = 0; i < depth; i++)
+        finalTriangles *= 4;
+    vertices.reserve(finalTriangles / 2 + 2);
+
+    std::unordered_map<uint64_t, unsigned int> midpoints;
+    std::vector<unsigned int> newIndices;
+
+    for (int i = 0; i < depth; i++)
+    {
+        size_t triangles = indices.size() / 3;
+        midpoints.clear();
+        midpoints.reserve(triangles * 3 / 2);
+        newIndices.clear();
+        newIndices.reserve(indices.size() * 4);
+
+        auto getMidpoint = [&](unsigned int v1, unsigned int v2) -> unsigned int
+            {
+                uint64_t key = v1 < v2
+                    ? (uint64_t(v1) << 32) | v2
+                    : (uint64_t(v2) << 32) | v1;
+
+                auto found = midpoints.try_emplace(key, static_cast<unsigned int>(vertices.size()));
+                if (found.second)
+                    vertices.push_back(glm::normalize((vertices[v1] + vertices[v2]) * 0.5f) * radius);
+
+                return found.first->second;
+            };
+
+        for (size_t j = 0; j < indices.size(); j += 3)
+        {
+            unsigned int v1 = indices[j];
+            unsigned int v2 = indices[j + 1];
+            unsigned int v3 = indices[j + 2];
+
+            unsigned int a = getMidpoint(v1, v2);
+            unsigned int b = getMidpoint(v2, v3);
+            unsigned int c = getMidpoint(v3, v1);
+
+            newIndices.insert(newIndices.end(), { v1, a, c, v2, b, a, v3, c, b, a, b, c });
+        }
+
+        indices.swap(newIndices);
+    }
+}
+
+std::vector<float> buildGridLines(float size, int divisions, float height, std::vector<glm::vec3>* points)
+{
+    int actualDivisions = divisions * 2;
+    std::vector<float> vertices;
+    float step = size / actualDivisions;
+    float half = size / 2.0f;
+    std::vector<glm::vec3> gridPoints;
+
+    for (int i = 0; i <= actualDivisions; i++)
+    {
+        for (int j = 0; j <= actualDivisions; j++)
+        {
+            float x = -half + j * step;
+            float z = -half + i * step;
+            gridPoints.push_back(glm::vec3(x, height, z));
+        }
+    }
+
+    for (int i = 0; i <= actualDivisions; i++)
+    {
+        for (int j = 0; j < actualDivisions; j++)
+        {
+            int index = i * (actualDivisions + 1) + j;
+            vertices.push_back(gridPoints[index].x);
+            vertices.push_back(gridPoints[index].y);
+            vertices.push_back(gridPoints[index].z);
+            vertices.push_back(gridPoints[index + 1].x);
+            vertices.push_back(gridPoints[index + 1].y);
+            vertices.push_back(gridPoints[index + 1].z);
+        }
+    }
+
+    for (int j = 0; j <= actualDivisions; j++)
+    {
+        for (int i = 0; i < actualDivisions; i++)
+        {
+            int index = i * (actualDivisions + 1) + j;
+            int nextIndex = (i + 1) * (actualDivisions + 1) + j;
+            vertices.push_back(gridPoints[index].x);
+            vertices.push_back(gridPoints[index].y);
+            vertices.push_back(gridPoints[index].z);
+            vertices.push_back(gridPoints[nextIndex].x);
+            vertices.push_back(gridPoints[nextIndex].y);
+            vertices.push_back(gridPoints[nextIndex].z);
+        }
+    }
+
+    if (points)
+        *points = std::move(gridPoints);
+
+    return vertices;
+}
+
+bool raySphereHit(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3& center, float radius)
+{
+    glm::vec3 originToCtr = origin - center;
+
+    float dirLenSq = glm::dot(direction, direction);
+    float twiceProj = 2.0f * glm::dot(originToCtr, direction);
+    float centerDistSq = glm::dot(originToCtr, originToCtr) -
+        radius * radius;
+
+    float discriminant = twiceProj * twiceProj -
+        4.0f * dirLenSq * centerDistSq;
+
+    return discriminant >= 0.0f;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+
+// CPU-side geometry shared by the renderer and the benchmarks. Nothing here
+// touches OpenGL.
+
+struct MeshData
+{
+    std::vector<glm::vec3>    vertices;
+    std::vector<unsigned int> indices;
+};
+
+// Icosahedron of the given radius, split depth times (4^depth x 20 triangles).
+void buildIcosphere(float radius, int depth, MeshData& mesh);
+
+// Line-list vertices (x, y, z per vertex) of a size x size grid with
+// 2 * divisions cells per side. points receives the lattice when not null.
+std::vector<float> buildGridLines(float size, int divisions, float height, std::vector<glm::vec3>* points = nullptr);
+
+// True if the line through origin along direction passes within radius of center.
+bool raySphereHit(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3& center, float radius);
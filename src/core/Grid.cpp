@@ -1,6 +1,8 @@
 #include <glad/glad.h>
 #include "core/Grid.h"
-#include <algorithm>
+#include "core/Geometry.h"
+#include "core/Profiler.h"
+#include <chrono>
 
 Grid::Grid(float size, int divisions, float height)
 {
@@ -11,56 +13,39 @@ Grid::~Grid()
 {
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
+    glDeleteVertexArrays(1, &planeVAO);
+    glDeleteTextures(1, &heightTexture);
 }
 
-void Grid::setupGrid(float size, int divisions, float height)
+// The line buffer is only built the first time Lines mode is drawn.
+void Grid::setupGrid(float newSize, int newDivisions, float newHeight)
 {
-    int actualDivisions = divisions * 2;
-    std::vector<GLfloat> vertices;
-    float step = size / actualDivisions;
-    float half = size / 2.0f;
-    std::vector<glm::vec3> gridPoints;
-
-    for (int i = 0; i <= actualDivisions; i++)
-    {
-        for (int j = 0; j <= actualDivisions; j++)
-        {
-            float x = -half + j * step;
-            float z = -half + i * step;
-            gridPoints.push_back(glm::vec3(x, 0.0f, z));
-        }
-    }
+    size = newSize;
+    divisions = newDivisions;
+    height = newHeight;
+    lineSpacing = size / (2 * divisions);
 
-    originalPoints = gridPoints;
-
-    for (int i = 0; i <= actualDivisions; i++)
-    {
-        for (int j = 0; j < actualDivisions; j++)
-        {
-            int index = i * (actualDivisions + 1) + j;
-            vertices.push_back(gridPoints[index].x);
-            vertices.push_back(gridPoints[index].y);
-            vertices.push_back(gridPoints[index].z);
-            vertices.push_back(gridPoints[index + 1].x);
-            vertices.push_back(gridPoints[index + 1].y);
-            vertices.push_back(gridPoints[index + 1].z);
-        }
-    }
+    // The procedural plane generates its vertices from gl_VertexID, but core
+    // profile still needs a vertex array bound to draw.
+    glGenVertexArrays(1, &planeVAO);
 
-    for (int j = 0; j <= actualDivisions; j++)
-    {
-        for (int i = 0; i < actualDivisions; i++)
-        {
-            int index = i * (actualDivisions + 1) + j;
-            int nextIndex = (i + 1) * (actualDivisions + 1) + j;
-            vertices.push_back(gridPoints[index].x);
-            vertices.push_back(gridPoints[index].y);
-            vertices.push_back(gridPoints[index].z);
-            vertices.push_back(gridPoints[nextIndex].x);
-            vertices.push_back(gridPoints[nextIndex].y);
-            vertices.push_back(gridPoints[nextIndex].z);
-        }
-    }
+    // One texel per lattice point, so every grid vertex samples a texel center.
+    field.configure(size, 2 * divisions + 1);
+    int resolution = field.getResolution();
+
+    glGenTextures(1, &heightTexture);
+    glBindTexture(GL_TEXTURE_2D, heightTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, resolution, resolution, 0, GL_RED, GL_FLOAT, field.getDepths().data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Grid::setupLines()
+{
+    std::vector<GLfloat> vertices = buildGridLines(size, divisions, height);
 
     lineCount = (int)vertices.size() / 3;
     glGenVertexArrays(1, &VAO);
@@ -74,24 +59,88 @@ void Grid::setupGrid(float size, int divisions, float height)
     glBindVertexArray(0);
 }
 
-void Grid::draw(Shader& shader, const std::vector<std::shared_ptr<Planet>>& planets) const 
+void Grid::update(const BodyRegistry& bodies)
 {
-    shader.use();
+    PROFILE_SCOPE("grid.update");
 
-    int count = std::min((int)planets.size(), 10);
-    std::vector<glm::vec3> positions(count);
-    std::vector<float> masses(count);
+    if (mode == GridMode::Lines && !VAO)
+        setupLines();
 
-    for (int i = 0; i < count; ++i) {
-        positions[i] = planets[i]->getPosition();
-        masses[i] = planets[i]->getMass() / 5.97e24f; // normalize as antes
+    auto start = std::chrono::steady_clock::now();
+
+    const std::vector<double>& bodyMasses = bodies.getMasses();
+    masses.resize(bodyMasses.size());
+    for (size_t i = 0; i < bodyMasses.size(); ++i) {
+        masses[i] = static_cast<float>(bodyMasses[i] / PotentialField::EARTH_MASS_KG);
     }
+    field.compute(bodies.getPositions(), masses);
+
+    int resolution = field.getResolution();
+    glBindTexture(GL_TEXTURE_2D, heightTexture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, resolution, resolution, GL_RED, GL_FLOAT, field.getDepths().data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    fieldTime_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
 
-    shader.setInt("planetCount", count);
-    shader.setVec3Array("planetPositions", positions);
-    shader.setFloatArray("planetMasses", masses);
+// Maps world x/z to texture coordinates at texel centers.
+glm::vec4 Grid::fieldTransform() const
+{
+    float resolution = static_cast<float>(field.getResolution());
+    float scale = 1.0f / (field.getStep() * resolution);
+    float offset = (field.getSize() * 0.5f / field.getStep() + 0.5f) / resolution;
+    return glm::vec4(scale, scale, offset, offset);
+}
+
+void Grid::draw(Shader& lineShader, Shader& planeShader) const 
+{
+    PROFILE_SCOPE("grid.draw");
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, heightTexture);
+
+    if (mode == GridMode::Lines && VAO)
+        drawLines(lineShader);
+    else if (mode == GridMode::Procedural)
+        drawPlane(planeShader);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Grid::drawLines(Shader& shader) const
+{
+    static const UniformKey HEIGHT_FIELD("heightField");
+    static const UniformKey FIELD_TRANSFORM("fieldTransform");
+
+    shader.use();
+    shader.set(HEIGHT_FIELD, 0);
+    shader.set(FIELD_TRANSFORM, fieldTransform());
 
     glBindVertexArray(VAO);
     glDrawArrays(GL_LINES, 0, lineCount);
     glBindVertexArray(0);
 }
+
+void Grid::drawPlane(Shader& shader) const
+{
+    static const UniformKey HEIGHT_FIELD("heightField");
+    static const UniformKey FIELD_TRANSFORM("fieldTransform");
+    static const UniformKey CELLS("planeCells");
+    static const UniformKey EXTENT("planeExtent");
+    static const UniformKey BASE_HEIGHT("planeHeight");
+    static const UniformKey LINE_SPACING("lineSpacing");
+    static const UniformKey FADE("fadeDistance");
+
+    shader.use();
+    shader.set(HEIGHT_FIELD, 0);
+    shader.set(FIELD_TRANSFORM, fieldTransform());
+    shader.set(CELLS, PLANE_CELLS);
+    shader.set(EXTENT, PLANE_EXTENT);
+    shader.set(BASE_HEIGHT, height);
+    shader.set(LINE_SPACING, lineSpacing);
+    shader.set(FADE, FADE_DISTANCE);
+
+    glBindVertexArray(planeVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 6 * PLANE_CELLS * PLANE_CELLS);
+    glBindVertexArray(0);
+}
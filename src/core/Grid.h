@@ -2,8 +2,15 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <vector>
-#include "objects/Planet.h"
-#include <memory>
+#include "core/PotentialField.h"
+#include "core/Shader.h"
+#include "core/BodyRegistry.h"
+
+enum class GridMode
+{
+    Lines,        // GL_LINES buffer, GridVertexShader/GridFragmentShader
+    Procedural    // no vertex buffer, GridPlaneVertexShader/GridPlaneFragmentShader
+};
 
 class Grid {
 public:
@@ -11,11 +18,44 @@ public:
     ~Grid();
 
     void setupGrid(float size, int divisions, float height);
-    void draw(Shader &shader, const std::vector<std::shared_ptr<Planet>> &planets) const;
+
+    // Recomputes the warp from every body and uploads it to the height texture.
+    void update(const BodyRegistry &bodies);
+
+    // lineShader is used in Lines mode, planeShader in Procedural mode.
+    void draw(Shader &lineShader, Shader &planeShader) const;
+
+    GridMode getMode() const { return mode; }
+    void setMode(GridMode newMode) { mode = newMode; }
+
+    PotentialField& getField() { return field; }
+    double getFieldTime() const { return fieldTime_ms; }
+
+    // Half width of the procedural plane and its vertex lattice. Vertices are
+    // spread as sign(u) u^2, so they are densest at the origin.
+    static constexpr float PLANE_EXTENT = 20000.0f;
+    static constexpr int PLANE_CELLS = 320;
+
+    // Camera distance at which procedural lines have faded out completely;
+    // the far plane in main.cpp.
+    static constexpr float FADE_DISTANCE = 10000.0f;
 
 private:
-    GLuint VAO, VBO;
-    int lineCount;
-    std::vector<glm::vec3> originalPoints;
-};
+    GridMode mode = GridMode::Procedural;
+    float size, height, lineSpacing;
+    int divisions;
 
+    GLuint VAO = 0, VBO = 0;
+    GLuint planeVAO = 0;
+    GLuint heightTexture = 0;
+    int lineCount = 0;
+
+    PotentialField field;
+    double fieldTime_ms = 0.0;
+    std::vector<float> masses;
+
+    void setupLines();
+    void drawLines(Shader &shader) const;
+    void drawPlane(Shader &shader) const;
+    glm::vec4 fieldTransform() const;
+};
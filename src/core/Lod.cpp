@@ -0,0 +1,45 @@
+#include "core/Lod.h"
+#include <algorithm>
+
+namespace
+{
+    // Largest distance between the unit sphere and a face of buildIcosphere's
+    // mesh at each subdivision depth, measured at the face centroids.
+    constexpr float FACET_DEVIATION[LOD_MAX_LEVEL + 1] = {
+        0.205346f, 0.065828f, 0.017753f, 0.004528f, 0.001138f, 0.000285f, 0.000071f
+    };
+
+    // Ideal level for the radius, without hysteresis.
+    int levelFor(const LodSettings& settings, float radius_px)
+    {
+        if (radius_px < settings.impostorRadius_px)
+            return LOD_IMPOSTOR;
+
+        int level = 0;
+        while (level < settings.maxLevel && radius_px > lodUpperRadius(settings, level))
+            ++level;
+        return level;
+    }
+}
+
+float lodUpperRadius(const LodSettings& settings, int level)
+{
+    if (level < 0)
+        return settings.impostorRadius_px;
+    if (level >= std::min(settings.maxLevel, LOD_MAX_LEVEL))
+        return 1.0e9f;
+    return settings.maxError_px / FACET_DEVIATION[level];
+}
+
+int selectLod(const LodSettings& settings, int previous, float radius_px)
+{
+    int target = levelFor(settings, radius_px);
+    if (previous < LOD_IMPOSTOR || previous > settings.maxLevel || target == previous)
+        return target;
+
+    // Finer: the radius must exceed the current level's limit by the band.
+    // Coarser: it must drop below the next coarser level's limit by the band.
+    if (target > previous)
+        return radius_px > lodUpperRadius(settings, previous) * (1.0f + settings.hysteresis) ? target : previous;
+    return radius_px < lodUpperRadius(settings, previous - 1) * (1.0f - settings.hysteresis) ? target : previous;
+}
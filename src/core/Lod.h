@@ -0,0 +1,33 @@
+#pragma once
+
+// Screen-space level of detail for the unit icospheres in MeshCache. Levels
+// are subdivision depths; LOD_IMPOSTOR means the body is drawn as a point
+// sprite. Nothing here touches OpenGL.
+
+constexpr int LOD_IMPOSTOR = -1;
+constexpr int LOD_MAX_LEVEL = 6;
+
+struct LodSettings
+{
+    float impostorRadius_px = 1.5f;   // smaller bodies become point sprites
+    float maxError_px = 0.5f;         // allowed gap between sphere and mesh silhouette
+    float hysteresis = 0.15f;         // fractional band around each threshold
+    int   maxLevel = LOD_MAX_LEVEL;
+};
+
+// Radius in pixels of a sphere at the given distance from the camera.
+// pixelScale is viewport height / (2 tan(fovy / 2)).
+inline float projectedRadius(float radius, float distance, float pixelScale)
+{
+    return distance > radius ? radius * pixelScale / distance : 1.0e9f;
+}
+
+// Largest projected radius, in pixels, at which a level keeps the mesh
+// within maxError_px of the true sphere.
+float lodUpperRadius(const LodSettings& settings, int level);
+
+// Level for a sphere of the given projected radius, starting from the level
+// it had last frame. The level only changes once the radius is past the
+// threshold by the hysteresis band, so bodies near a threshold do not switch
+// back and forth every frame.
+int selectLod(const LodSettings& settings, int previous, float radius_px);
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Read-only memory map of a whole file (mmap, or a file mapping on Windows).
+// The pages are loaded on first touch, so opening is O(1) in the file size.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path, std::string& error);
+    void close();
+
+    bool           isOpen() const { return bytes != nullptr; }
+    const uint8_t* data() const   { return bytes; }
+    size_t         size() const   { return length; }
+
+private:
+    const uint8_t* bytes = nullptr;
+    size_t         length = 0;
+#if defined(_WIN32)
+    void* file = nullptr;
+    void* mapping = nullptr;
+#endif
+};
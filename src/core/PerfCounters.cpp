@@ -0,0 +1,218 @@
+#include "core/PerfCounters.h"
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <dirent.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+#if defined(__linux__)
+    // FP_ASSIST.ANY (event 0xCA, umask 0x1E). The raw code means something
+    // else on other vendors, so it is only opened on Intel.
+    constexpr uint64_t INTEL_FP_ASSIST_ANY = 0x1eca;
+
+    bool isIntel()
+    {
+        std::ifstream cpuinfo("/proc/cpuinfo");
+        std::string line;
+        while (std::getline(cpuinfo, line))
+        {
+            if (line.compare(0, 9, "vendor_id") == 0)
+                return line.find("GenuineIntel") != std::string::npos;
+        }
+        return false;
+    }
+
+    int openEvent(PerfEvent event, int tid, int groupFd)
+    {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+
+        switch (event)
+        {
+        case PerfEvent::Cycles:       attr.config = PERF_COUNT_HW_CPU_CYCLES; break;
+        case PerfEvent::Instructions: attr.config = PERF_COUNT_HW_INSTRUCTIONS; break;
+        case PerfEvent::CacheMisses:  attr.config = PERF_COUNT_HW_CACHE_MISSES; break;
+        case PerfEvent::BranchMisses: attr.config = PERF_COUNT_HW_BRANCH_MISSES; break;
+        case PerfEvent::FpAssists:
+            attr.type = PERF_TYPE_RAW;
+            attr.config = INTEL_FP_ASSIST_ANY;
+            break;
+        }
+
+        // The leader starts disabled; the whole group is enabled at once.
+        attr.disabled = groupFd < 0 ? 1 : 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, tid, -1, groupFd, 0));
+    }
+#endif
+}
+
+const char* perfEventName(PerfEvent event)
+{
+    switch (event)
+    {
+    case PerfEvent::Cycles:       return "Cycles";
+    case PerfEvent::Instructions: return "Instructions";
+    case PerfEvent::CacheMisses:  return "Cache misses";
+    case PerfEvent::BranchMisses: return "Branch misses";
+    case PerfEvent::FpAssists:    return "FP assists";
+    }
+    return "Unknown";
+}
+
+PerfReading PerfReading::operator-(const PerfReading& start) const
+{
+    PerfReading delta;
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e)
+    {
+        delta.valid[e] = valid[e] && start.valid[e];
+        delta.value[e] = delta.valid[e] ? value[e] - start.value[e] : 0.0;
+    }
+    return delta;
+}
+
+PerfReading PerfReading::scaled(double factor) const
+{
+    PerfReading result = *this;
+    for (double& v : result.value)
+        v *= factor;
+    return result;
+}
+
+PerfCounters::~PerfCounters()
+{
+    close();
+}
+
+bool PerfCounters::attachCurrentThread()
+{
+    return attach(0);
+}
+
+bool PerfCounters::attachProcess(bool includeMainThread)
+{
+#if defined(__linux__)
+    DIR* tasks = opendir("/proc/self/task");
+    if (!tasks)
+    {
+        lastError = "cannot list /proc/self/task";
+        return false;
+    }
+
+    int self = static_cast<int>(getpid());
+    while (dirent* entry = readdir(tasks))
+    {
+        int tid = std::atoi(entry->d_name);
+        if (tid > 0 && (includeMainThread || tid != self))
+            attach(tid);
+    }
+    closedir(tasks);
+    return available();
+#else
+    (void)includeMainThread;
+    return attach(0);
+#endif
+}
+
+void PerfCounters::close()
+{
+#if defined(__linux__)
+    for (const Group& group : groups)
+    {
+        for (int fd : group.fds)
+        {
+            if (fd >= 0)
+                ::close(fd);
+        }
+    }
+#endif
+    groups.clear();
+}
+
+PerfReading PerfCounters::read() const
+{
+    PerfReading total;
+
+#if defined(__linux__)
+    for (const Group& group : groups)
+    {
+        // nr, time enabled, time running, then one value per member.
+        uint64_t buffer[3 + PERF_EVENT_COUNT];
+        ssize_t size = ::read(group.fds[0], buffer, sizeof(buffer));
+        if (size < static_cast<ssize_t>((3 + group.members) * sizeof(uint64_t)) || buffer[2] == 0)
+            continue;
+
+        double scale = static_cast<double>(buffer[1]) / static_cast<double>(buffer[2]);
+        for (int e = 0; e < PERF_EVENT_COUNT; ++e)
+        {
+            if (group.slot[e] < 0)
+                continue;
+            total.value[e] += static_cast<double>(buffer[3 + group.slot[e]]) * scale;
+            total.valid[e] = true;
+        }
+    }
+#endif
+
+    return total;
+}
+
+bool PerfCounters::attach(int tid)
+{
+#if defined(__linux__)
+    Group group;
+    group.fds.fill(-1);
+    group.slot.fill(-1);
+
+    int leader = openEvent(PerfEvent::Cycles, tid, -1);
+    if (leader < 0)
+    {
+        lastError = std::string("perf_event_open: ") + std::strerror(errno);
+        if (errno == EACCES || errno == EPERM)
+            lastError += " (see /proc/sys/kernel/perf_event_paranoid)";
+        else if (errno == ENOENT || errno == ENODEV || errno == EOPNOTSUPP)
+            lastError += " (no hardware PMU, as in many VMs)";
+        return false;
+    }
+    group.fds[0] = leader;
+    group.slot[0] = group.members++;
+
+    static const bool intel = isIntel();
+    for (int e = 1; e < PERF_EVENT_COUNT; ++e)
+    {
+        PerfEvent event = static_cast<PerfEvent>(e);
+        if (event == PerfEvent::FpAssists && !intel)
+            continue;
+
+        // Events the CPU lacks are left out rather than failing the group.
+        int fd = openEvent(event, tid, leader);
+        if (fd >= 0)
+        {
+            group.fds[e] = fd;
+            group.slot[e] = group.members++;
+        }
+    }
+
+    ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    groups.push_back(group);
+    return true;
+#else
+    (void)tid;
+    lastError = "hardware counters need Linux perf_event_open";
+    return false;
+#endif
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class PerfEvent
+{
+    Cycles,
+    Instructions,
+    CacheMisses,    // last-level cache
+    BranchMisses,
+    FpAssists,      // Intel FP_ASSIST.ANY; microcode assists for denormals and the like
+};
+
+constexpr int PERF_EVENT_COUNT = 5;
+
+const char* perfEventName(PerfEvent event);
+
+// Counts per event; an event the CPU or kernel did not provide is not valid.
+struct PerfReading
+{
+    std::array<double, PERF_EVENT_COUNT> value{};
+    std::array<bool, PERF_EVENT_COUNT>   valid{};
+
+    double get(PerfEvent event) const { return value[static_cast<int>(event)]; }
+    bool   has(PerfEvent event) const { return valid[static_cast<int>(event)]; }
+
+    PerfReading operator-(const PerfReading& start) const;
+    PerfReading scaled(double factor) const;
+};
+
+// Hardware counters through Linux perf_event_open, one group per thread so
+// that a region run by several threads is counted as a whole. User-space
+// only. Counts are scaled up when the kernel had to multiplex the PMU.
+//
+// Elsewhere, or when the kernel refuses (perf_event_paranoid, containers,
+// VMs without a virtual PMU), attach fails, error() says why, and read()
+// returns an empty reading, so callers only need to check available().
+class PerfCounters
+{
+public:
+    PerfCounters() = default;
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    // Adds the calling thread.
+    bool attachCurrentThread();
+
+    // Adds every thread of the process that exists now, optionally leaving
+    // out the main thread (the render thread in the app).
+    bool attachProcess(bool includeMainThread);
+
+    void close();
+
+    bool available() const { return !groups.empty(); }
+    const std::string& error() const { return lastError; }
+
+    // Summed over the attached threads since they were attached.
+    PerfReading read() const;
+
+private:
+    struct Group
+    {
+        std::array<int, PERF_EVENT_COUNT> fds;
+        std::array<int, PERF_EVENT_COUNT> slot;   // position in the group read, or -1
+        int members = 0;
+    };
+
+    std::vector<Group> groups;
+    std::string lastError;
+
+    bool attach(int tid);
+};
@@ -0,0 +1,138 @@
+#include "core/PotentialField.h"
+#include "core/ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+namespace
+{
+    constexpr float INV_SMOOTHING2 = 1.0f / (PotentialField::SMOOTHING * PotentialField::SMOOTHING);
+    constexpr size_t ROW_GRAIN = 8;
+}
+
+void PotentialField::configure(float newSize, int newResolution)
+{
+    size = newSize;
+    resolution = std::max(newResolution, 2);
+    step = size / (resolution - 1);
+
+    depths.assign(static_cast<size_t>(resolution) * resolution, 0.0f);
+    lattice.resize(resolution);
+    for (int i = 0; i < resolution; ++i)
+        lattice[i] = -size * 0.5f + i * step;
+}
+
+void PotentialField::compute(const std::vector<glm::vec3>& positions, const std::vector<float>& masses_earth)
+{
+    size_t rows = static_cast<size_t>(resolution);
+    if (rows == 0)
+        return;
+
+    size_t count = rows;
+    size_t grain = ROW_GRAIN;
+    std::function<void(size_t, size_t)> body;
+    if (useTree)
+    {
+        sources.resize(positions.size());
+        for (size_t i = 0; i < positions.size(); ++i)
+        {
+            sources.x[i] = positions[i].x;
+            sources.y[i] = 0.0;
+            sources.z[i] = positions[i].z;
+            sources.mass[i] = masses_earth[i];
+        }
+        tree.build(sources);
+
+        count = (rows + TILE - 1) / TILE;
+        grain = 1;
+        body = [this](size_t begin, size_t end)
+            {
+                for (size_t tileRow = begin; tileRow < end; ++tileRow)
+                    computeTilesTree(tileRow);
+            };
+    }
+    else
+    {
+        body = [&](size_t begin, size_t end) { computeRowsDirect(begin, end, positions, masses_earth); };
+    }
+
+    if (pool)
+    {
+        pool->parallelFor(count, grain, body);
+        return;
+    }
+    body(0, count);
+}
+
+// Bodies in the outer loop and columns in the inner one, so the inner loop
+// is a straight float stream the compiler vectorizes.
+void PotentialField::computeRowsDirect(size_t begin, size_t end, const std::vector<glm::vec3>& positions, const std::vector<float>& masses_earth)
+{
+    size_t n = static_cast<size_t>(resolution);
+
+    for (size_t row = begin; row < end; ++row)
+    {
+        float* out = depths.data() + row * n;
+        std::fill(out, out + n, 0.0f);
+
+        float z = lattice[row];
+        for (size_t b = 0; b < positions.size(); ++b)
+        {
+            float dz = z - positions[b].z;
+            float bx = positions[b].x;
+            float strength = STRENGTH * masses_earth[b];
+            float base = 1.0f + dz * dz * INV_SMOOTHING2;
+
+            for (size_t col = 0; col < n; ++col)
+            {
+                float dx = lattice[col] - bx;
+                out[col] += std::min(strength / (base + dx * dx * INV_SMOOTHING2), MAX_DEPTH);
+            }
+        }
+    }
+}
+
+void PotentialField::computeTilesTree(size_t tileRow)
+{
+    size_t n = static_cast<size_t>(resolution);
+    size_t rowBegin = tileRow * TILE;
+    size_t rowEnd = std::min(rowBegin + TILE, n);
+
+    struct Source { float x, z, strength; };
+    std::vector<Source> accepted;
+
+    for (size_t colBegin = 0; colBegin < n; colBegin += TILE)
+    {
+        size_t colEnd = std::min(colBegin + TILE, n);
+
+        float x0 = lattice[colBegin], x1 = lattice[colEnd - 1];
+        float z0 = lattice[rowBegin], z1 = lattice[rowEnd - 1];
+        glm::dvec3 center((x0 + x1) * 0.5, 0.0, (z0 + z1) * 0.5);
+        double reach = 0.5 * std::sqrt(double(x1 - x0) * (x1 - x0) + double(z1 - z0) * (z1 - z0));
+
+        accepted.clear();
+        tree.walk(center, reach, theta, [&](const glm::dvec3& source, double mass)
+            {
+                accepted.push_back({ static_cast<float>(source.x), static_cast<float>(source.z), static_cast<float>(STRENGTH * mass) });
+            });
+
+        for (size_t row = rowBegin; row < rowEnd; ++row)
+        {
+            float* out = depths.data() + row * n;
+            std::fill(out + colBegin, out + colEnd, 0.0f);
+
+            float z = lattice[row];
+            for (const Source& s : accepted)
+            {
+                float dz = z - s.z;
+                float base = 1.0f + dz * dz * INV_SMOOTHING2;
+
+                for (size_t col = colBegin; col < colEnd; ++col)
+                {
+                    float dx = lattice[col] - s.x;
+                    out[col] += std::min(s.strength / (base + dx * dx * INV_SMOOTHING2), MAX_DEPTH);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+#include "physics/BarnesHutTree.h"
+#include "physics/BodySoA.h"
+
+class ThreadPool;
+
+// Depth of the grid warp, sampled on a resolution x resolution lattice that
+// covers [-size/2, size/2] in x and z. Each body adds
+//
+//     min(STRENGTH * mass / (1 + r^2 / SMOOTHING^2), MAX_DEPTH)
+//
+// with mass in Earth masses and r the distance in the XZ plane. This is the
+// formula GridVertexShader.glsl used to evaluate per vertex for at most ten
+// bodies; here it runs once per texel for every body, in parallel rows, and
+// the renderer samples the result as a height texture. With useTree, each
+// TILE x TILE block of texels walks the Barnes-Hut tree once and applies the
+// accepted cells to all of its texels. Nothing here touches OpenGL.
+class PotentialField
+{
+public:
+    static constexpr float STRENGTH = 0.008f;
+    static constexpr float SMOOTHING = 2.0f;
+    static constexpr float MAX_DEPTH = 38.0f;
+    static constexpr float EARTH_MASS_KG = 5.97e24f;
+    static constexpr int   TILE = 16;
+
+    ThreadPool* pool = nullptr;   // rows run serially when null
+    bool   useTree = false;       // Barnes-Hut approximation for many bodies
+    double theta = 0.7;
+
+    void configure(float size, int resolution);
+
+    void compute(const std::vector<glm::vec3>& positions, const std::vector<float>& masses_earth);
+
+    int   getResolution() const { return resolution; }
+    float getSize() const { return size; }
+    float getStep() const { return step; }
+    const std::vector<float>& getDepths() const { return depths; }
+
+private:
+    float size = 0.0f;
+    float step = 0.0f;
+    int   resolution = 0;
+    std::vector<float> depths;
+    std::vector<float> lattice;   // x (and z) coordinate of each column
+
+    BodySoA       sources;
+    BarnesHutTree tree;
+
+    void computeRowsDirect(size_t begin, size_t end, const std::vector<glm::vec3>& positions, const std::vector<float>& masses_earth);
+    void computeTilesTree(size_t tileRow);
+};
@@ -0,0 +1,136 @@
+#include "core/Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+
+Profiler& Profiler::global()
+{
+    static Profiler profiler;
+    return profiler;
+}
+
+uint64_t Profiler::now()
+{
+    using namespace std::chrono;
+    return static_cast<uint64_t>(duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count());
+}
+
+void Profiler::setThreadName(const std::string& name)
+{
+    Ring& ring = localRing();
+    std::lock_guard<std::mutex> lock(ringMutex);
+    ring.name = name;
+}
+
+void Profiler::record(const char* name, uint64_t start_ns, uint64_t end_ns, uint16_t depth)
+{
+    Ring& ring = localRing();
+    uint64_t index = ring.written.load(std::memory_order_relaxed);
+
+    ProfileEvent& event = ring.events[index & (RING_CAPACITY - 1)];
+    event.name = name;
+    event.start_ns = start_ns;
+    event.end_ns = end_ns;
+    event.depth = depth;
+
+    ring.written.store(index + 1, std::memory_order_release);
+}
+
+void Profiler::drain(std::vector<ProfileEvent>& out)
+{
+    std::lock_guard<std::mutex> lock(ringMutex);
+
+    for (size_t t = 0; t < rings.size(); ++t)
+    {
+        Ring& ring = *rings[t];
+        uint64_t written = ring.written.load(std::memory_order_acquire);
+        uint64_t first = std::max(ring.read, written > RING_CAPACITY ? written - RING_CAPACITY : 0);
+
+        size_t base = out.size();
+        for (uint64_t k = first; k < written; ++k)
+        {
+            out.push_back(ring.events[k & (RING_CAPACITY - 1)]);
+            out.back().thread = static_cast<uint16_t>(t);
+        }
+
+        // The writer may have reused the oldest slots while they were being
+        // copied, including the one it is filling now.
+        uint64_t after = ring.written.load(std::memory_order_acquire);
+        uint64_t valid = after + 1 > RING_CAPACITY ? after + 1 - RING_CAPACITY : 0;
+        if (valid > first)
+        {
+            uint64_t torn = std::min(valid, written) - first;
+            out.erase(out.begin() + base, out.begin() + base + static_cast<size_t>(torn));
+            first += torn;
+        }
+
+        droppedEvents += first - ring.read;
+        ring.read = written;
+    }
+}
+
+std::vector<std::string> Profiler::threadNames() const
+{
+    std::lock_guard<std::mutex> lock(ringMutex);
+
+    std::vector<std::string> names;
+    for (size_t t = 0; t < rings.size(); ++t)
+        names.push_back(rings[t]->name.empty() ? "thread " + std::to_string(t) : rings[t]->name);
+    return names;
+}
+
+Profiler::Ring& Profiler::localRing()
+{
+    thread_local Ring* local = nullptr;
+    if (!local)
+    {
+        std::lock_guard<std::mutex> lock(ringMutex);
+        rings.push_back(std::make_unique<Ring>());
+        local = rings.back().get();
+    }
+    return *local;
+}
+
+bool writeChromeTrace(const std::string& path, const std::vector<ProfileEvent>& events,
+    const std::vector<std::string>& threadNames, std::string& error)
+{
+    std::ofstream out(path);
+    if (!out)
+    {
+        error = "cannot write " + path;
+        return false;
+    }
+
+    uint64_t origin = UINT64_MAX;
+    for (const ProfileEvent& e : events)
+        origin = std::min(origin, e.start_ns);
+
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    bool first = true;
+    for (size_t t = 0; t < threadNames.size(); ++t)
+    {
+        out << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << t
+            << ", \"args\": {\"name\": \"" << threadNames[t] << "\"}}";
+        first = false;
+    }
+
+    char line[96];
+    for (const ProfileEvent& e : events)
+    {
+        // Microseconds, as the format expects.
+        std::snprintf(line, sizeof(line), "\"ts\": %.3f, \"dur\": %.3f}",
+            (e.start_ns - origin) * 1e-3, (e.end_ns - e.start_ns) * 1e-3);
+        out << (first ? "" : ",\n") << "{\"name\": \"" << e.name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << e.thread
+            << ", " << line;
+        first = false;
+    }
+    out << "\n]}\n";
+
+    if (!out)
+    {
+        error = "cannot write " + path;
+        return false;
+    }
+    return true;
+}
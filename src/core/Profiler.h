@@ -0,0 +1,103 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Scoped wall-clock timers for the hot paths. PROFILE_SCOPE("name") records
+// one event when the scope closes, into a ring owned by the calling thread,
+// so writers never lock or contend. A reader drains all rings, typically once
+// a frame. Without SOLARSIM_PROFILE the macros expand to nothing and the
+// instrumented code is unchanged.
+//
+// Names are stored by pointer and must be string literals.
+struct ProfileEvent
+{
+    const char* name = nullptr;
+    uint64_t    start_ns = 0;   // Profiler::now()
+    uint64_t    end_ns = 0;
+    uint16_t    thread = 0;     // index into Profiler::threadNames()
+    uint16_t    depth = 0;      // nesting on that thread, 0 outermost
+};
+
+class Profiler
+{
+public:
+    static constexpr size_t RING_CAPACITY = size_t(1) << 14;   // events per thread, a power of two
+
+    static Profiler& global();
+    static uint64_t now();   // steady clock, nanoseconds
+
+    // Names the calling thread in the panel and in traces.
+    void setThreadName(const std::string& name);
+    void record(const char* name, uint64_t start_ns, uint64_t end_ns, uint16_t depth);
+
+    // Appends the events closed since the last drain, oldest first per
+    // thread. Events a thread overwrote before they were drained are lost
+    // and counted in dropped().
+    void drain(std::vector<ProfileEvent>& out);
+
+    std::vector<std::string> threadNames() const;
+    uint64_t dropped() const { return droppedEvents.load(); }
+
+private:
+    // Written by its thread only. The reader copies a range and then checks
+    // that the writer has not lapped it in the meantime.
+    struct Ring
+    {
+        std::vector<ProfileEvent> events = std::vector<ProfileEvent>(RING_CAPACITY);
+        std::atomic<uint64_t> written{ 0 };
+        uint64_t read = 0;   // under ringMutex
+        std::string name;    // under ringMutex
+    };
+
+    mutable std::mutex ringMutex;
+    std::vector<std::unique_ptr<Ring>> rings;
+    std::atomic<uint64_t> droppedEvents{ 0 };
+
+    Ring& localRing();
+};
+
+class ProfileScope
+{
+public:
+    explicit ProfileScope(const char* name)
+        : name(name), depth(currentDepth++), start(Profiler::now()) {}
+
+    ~ProfileScope()
+    {
+        --currentDepth;
+        Profiler::global().record(name, start, Profiler::now(), depth);
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    static inline thread_local uint16_t currentDepth = 0;
+
+    const char* name;
+    uint16_t    depth;
+    uint64_t    start;
+};
+
+// Writes events as a Chrome trace ("X" complete events plus thread names),
+// which chrome://tracing and ui.perfetto.dev both open.
+bool writeChromeTrace(const std::string& path, const std::vector<ProfileEvent>& events,
+    const std::vector<std::string>& threadNames, std::string& error);
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#if defined(SOLARSIM_PROFILE)
+constexpr bool PROFILE_ENABLED = true;
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_THREAD(name) Profiler::global().setThreadName(name)
+#else
+constexpr bool PROFILE_ENABLED = false;
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
+#endif
@@ -1,8 +1,47 @@
 #include "core/Shader.h"
 #include <glad/glad.h>
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <unordered_map>
+
+namespace
+{
+    std::unordered_map<std::string, uint32_t>& uniformIds()
+    {
+        static std::unordered_map<std::string, uint32_t> ids;
+        return ids;
+    }
+}
+
+UniformKey::UniformKey(const char* name)
+    : index(intern(name))
+{
+}
+
+uint32_t UniformKey::intern(const std::string& name)
+{
+    auto& ids = uniformIds();
+    auto it = ids.find(name);
+    if (it != ids.end())
+        return it->second;
+
+    uint32_t id = static_cast<uint32_t>(ids.size());
+    ids.emplace(name, id);
+    return id;
+}
+
+bool UniformKey::find(const std::string& name, uint32_t& id)
+{
+    auto& ids = uniformIds();
+    auto it = ids.find(name);
+    if (it == ids.end())
+        return false;
+
+    id = it->second;
+    return true;
+}
 
 Shader::Shader(const std::string &vertexPath, const std::string &fragmentPath)
 {
@@ -75,6 +114,7 @@ bool Shader::compileShader(const std::string &vertexCode, const std::string &fra
     glDeleteShader(vertex);
     glDeleteShader(fragment);
 
+    reflectUniforms();
     return true;
 }
 
@@ -86,30 +126,112 @@ std::string Shader::readFile(const std::string &filePath)
     return buffer.str();
 }
 
+// Caches the location of every active uniform under its interned name, and
+// points the "Frame" block, if the program uses it, at the shared binding.
+void Shader::reflectUniforms()
+{
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+    std::vector<char> buffer(std::max(maxLength, 1));
+    for (GLint i = 0; i < count; ++i)
+    {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(ID, static_cast<GLuint>(i), maxLength, &length, &size, &type, buffer.data());
+
+        // Block members have no location; arrays are reported as "name[0]".
+        std::string name(buffer.data(), length);
+        GLint loc = glGetUniformLocation(ID, name.c_str());
+        if (loc < 0)
+            continue;
+        if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+            name.resize(name.size() - 3);
+
+        uint32_t id = UniformKey::intern(name);
+        if (id >= locations.size())
+            locations.resize(id + 1, -1);
+        locations[id] = loc;
+    }
+
+    GLuint frameBlock = glGetUniformBlockIndex(ID, "Frame");
+    if (frameBlock != GL_INVALID_INDEX)
+        glUniformBlockBinding(ID, frameBlock, FRAME_UNIFORM_BINDING);
+}
+
+int Shader::location(const UniformKey& key) const
+{
+    return key.id() < locations.size() ? locations[key.id()] : -1;
+}
+
+int Shader::location(const std::string& name) const
+{
+    uint32_t id;
+    return UniformKey::find(name, id) && id < locations.size() ? locations[id] : -1;
+}
+
+void Shader::set(const UniformKey& key, const glm::mat4& mat)
+{
+    glUniformMatrix4fv(location(key), 1, GL_FALSE, glm::value_ptr(mat));
+}
+
+void Shader::set(const UniformKey& key, const glm::vec3& vec)
+{
+    glUniform3fv(location(key), 1, glm::value_ptr(vec));
+}
+
+void Shader::set(const UniformKey& key, const glm::vec4& vec)
+{
+    glUniform4fv(location(key), 1, glm::value_ptr(vec));
+}
+
+void Shader::set(const UniformKey& key, int value)
+{
+    glUniform1i(location(key), value);
+}
+
+void Shader::set(const UniformKey& key, float value)
+{
+    glUniform1f(location(key), value);
+}
+
+void Shader::set(const UniformKey& key, const glm::vec3* values, size_t count)
+{
+    if (count > 0)
+        glUniform3fv(location(key), static_cast<GLsizei>(count), glm::value_ptr(values[0]));
+}
+
+void Shader::set(const UniformKey& key, const float* values, size_t count)
+{
+    if (count > 0)
+        glUniform1fv(location(key), static_cast<GLsizei>(count), values);
+}
+
 void Shader::setMat4(const std::string &name, const glm::mat4 &mat) 
 {
-    glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
+    glUniformMatrix4fv(location(name), 1, GL_FALSE, glm::value_ptr(mat));
 }
 
 void Shader::setVec3(const std::string &name, const glm::vec3 &value) 
 {
-    glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    glUniform3fv(location(name), 1, &value[0]);
 }
 
 void Shader::setVec3Array(const std::string &name, const std::vector<glm::vec3> &values) 
 {
-    int location = glGetUniformLocation(ID, name.c_str());
-    glUniform3fv(location, static_cast<GLsizei>(values.size()), glm::value_ptr(values[0]));
+    if (!values.empty())
+        glUniform3fv(location(name), static_cast<GLsizei>(values.size()), glm::value_ptr(values[0]));
 }
 
 void Shader::setFloatArray(const std::string &name, const std::vector<float> &values) 
 {
-    int location = glGetUniformLocation(ID, name.c_str());
-    glUniform1fv(location, static_cast<GLsizei>(values.size()), values.data());
+    if (!values.empty())
+        glUniform1fv(location(name), static_cast<GLsizei>(values.size()), values.data());
 }
 
 void Shader::setInt(const std::string &name, int value) 
 {
-    int location = glGetUniformLocation(ID, name.c_str());
-    glUniform1i(location, value);
+    glUniform1i(location(name), value);
 }
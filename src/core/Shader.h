@@ -1,8 +1,28 @@
 #pragma once
+#include <cstdint>
 #include <string>
 #include <glm/gtc/type_ptr.hpp>
 #include <vector>
 
+// Binding point of the std140 "Frame" block shared by every program.
+constexpr unsigned int FRAME_UNIFORM_BINDING = 0;
+
+// Interned uniform name. Create keys once (usually as statics) and set
+// uniforms through them: the lookup is an index into the location table
+// the Shader filled at link time, with no string work or driver call.
+class UniformKey
+{
+public:
+    explicit UniformKey(const char* name);
+
+    uint32_t id() const { return index; }
+
+    static uint32_t intern(const std::string& name);
+    static bool find(const std::string& name, uint32_t& id);
+
+private:
+    uint32_t index;
+};
 
 class Shader
 {
@@ -11,6 +31,19 @@ public:
     ~Shader();
     void use();
     unsigned int getID() const;
+
+    // -1 when the uniform is not active in this program.
+    int location(const UniformKey& key) const;
+
+    void set(const UniformKey& key, const glm::mat4& mat);
+    void set(const UniformKey& key, const glm::vec3& vec);
+    void set(const UniformKey& key, const glm::vec4& vec);
+    void set(const UniformKey& key, int value);
+    void set(const UniformKey& key, float value);
+    void set(const UniformKey& key, const glm::vec3* values, size_t count);
+    void set(const UniformKey& key, const float* values, size_t count);
+
+    // Name-based setters; resolved through the same cache.
     void setMat4(const std::string &name, const glm::mat4 &mat);
 	void setVec3(const std::string &name, const glm::vec3 &vec);
     void setVec3Array(const std::string &name, const std::vector<glm::vec3> &values);
@@ -18,7 +51,11 @@ public:
     void setInt(const std::string &name, int value);
 
 private:
-    unsigned int ID;
+    unsigned int ID = 0;
+    std::vector<int> locations;   // by UniformKey id
+
     bool compileShader(const std::string &vertexCode, const std::string &fragmentCode);
+    void reflectUniforms();
+    int location(const std::string& name) const;
     std::string readFile(const std::string &filePath);
 };
@@ -0,0 +1,178 @@
+#include "core/ThreadPool.h"
+#include "core/Profiler.h"
+#include <algorithm>
+
+namespace
+{
+    thread_local const ThreadPool* currentPool = nullptr;
+    thread_local int currentWorker = -1;
+}
+
+ThreadPool::ThreadPool(unsigned maxThreads)
+{
+    if (maxThreads == 0)
+        maxThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    unsigned workerCount = maxThreads - 1;
+    for (unsigned i = 0; i < workerCount; ++i)
+        queues.push_back(std::make_unique<Queue>());
+
+    activeWorkers = workerCount;
+
+    for (unsigned i = 0; i < workerCount; ++i)
+        workers.emplace_back(&ThreadPool::workerLoop, this, static_cast<int>(i));
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (auto& worker : workers)
+        worker.join();
+}
+
+void ThreadPool::setThreadCount(unsigned threads)
+{
+    threads = std::clamp(threads, 1u, getMaxThreads());
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        activeWorkers = threads - 1;
+    }
+    wake.notify_all();
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    unsigned active = activeWorkers.load();
+    if (active == 0)
+    {
+        task();
+        return;
+    }
+
+    size_t queue = (currentPool == this && currentWorker >= 0)
+        ? static_cast<size_t>(currentWorker)
+        : nextQueue.fetch_add(1) % active;
+
+    push(queue, std::move(task));
+}
+
+void ThreadPool::parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body)
+{
+    grain = std::max<size_t>(grain, 1);
+    size_t   chunks = (count + grain - 1) / grain;
+    unsigned active = activeWorkers.load();
+
+    if (active == 0 || chunks <= 1)
+    {
+        for (size_t begin = 0; begin < count; begin += grain)
+            body(begin, std::min(begin + grain, count));
+        return;
+    }
+
+    std::atomic<size_t> remaining(chunks);
+
+    // Hand each worker a contiguous run of chunks; idle workers steal the rest.
+    for (size_t c = 0; c < chunks; ++c)
+    {
+        size_t begin = c * grain;
+        size_t end = std::min(begin + grain, count);
+        size_t queue = c * active / chunks;
+
+        push(queue, [&body, &remaining, begin, end]()
+            {
+                body(begin, end);
+                remaining.fetch_sub(1);
+            });
+    }
+
+    int self = (currentPool == this) ? currentWorker : -1;
+    while (remaining.load() > 0)
+    {
+        if (!tryRun(self))
+            std::this_thread::yield();
+    }
+}
+
+ThreadPool& ThreadPool::global()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::push(size_t queue, std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(queues[queue]->mutex);
+        queues[queue]->tasks.push_back(std::move(task));
+    }
+    queued.fetch_add(1);
+
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wake.notify_one();
+}
+
+bool ThreadPool::tryRun(int self)
+{
+    std::function<void()> task;
+    size_t count = queues.size();
+
+    if (self >= 0)
+    {
+        Queue& own = *queues[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty())
+        {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+        }
+    }
+
+    size_t start = self >= 0 ? static_cast<size_t>(self) + 1 : nextQueue.load();
+    for (size_t k = 0; !task && k < count; ++k)
+    {
+        Queue& victim = *queues[(start + k) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+        }
+    }
+
+    if (!task)
+        return false;
+
+    queued.fetch_sub(1);
+    PROFILE_SCOPE("pool.task");
+    task();
+    return true;
+}
+
+void ThreadPool::workerLoop(int index)
+{
+    currentPool = this;
+    currentWorker = index;
+    PROFILE_THREAD("worker " + std::to_string(index));
+
+    for (;;)
+    {
+        if (static_cast<unsigned>(index) < activeWorkers.load() && tryRun(index))
+            continue;
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [&]()
+            {
+                return stopping || (queued.load() > 0 && static_cast<unsigned>(index) < activeWorkers.load());
+            });
+
+        if (stopping)
+            return;
+    }
+}
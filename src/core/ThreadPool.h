@@ -0,0 +1,58 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing task pool. Each worker owns a deque: it pops its own tasks from
+// the back and steals from the front of the others when it runs dry. Threads
+// that wait on a parallelFor help execute queued tasks instead of blocking.
+class ThreadPool
+{
+public:
+    // maxThreads counts the calling thread; 0 uses the hardware concurrency.
+    explicit ThreadPool(unsigned maxThreads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Number of threads taking part in parallelFor, clamped to [1, maxThreads].
+    void setThreadCount(unsigned threads);
+    unsigned getThreadCount() const { return activeWorkers.load() + 1; }
+    unsigned getMaxThreads() const { return static_cast<unsigned>(queues.size()) + 1; }
+
+    void submit(std::function<void()> task);
+
+    // Calls body(begin, end) for consecutive chunks of at most `grain` items
+    // covering [0, count) and returns once all of them have run. Chunk bounds
+    // depend only on count and grain, never on the thread count.
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body);
+
+    static ThreadPool& global();
+
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::atomic<size_t> queued{ 0 };
+    std::atomic<unsigned> activeWorkers{ 0 };
+    std::atomic<unsigned> nextQueue{ 0 };
+    bool stopping = false;
+
+    void push(size_t queue, std::function<void()> task);
+    bool tryRun(int self);
+    void workerLoop(int index);
+};
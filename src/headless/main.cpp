@@ -0,0 +1,434 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "core/PerfCounters.h"
+#include "core/Profiler.h"
+#include "core/ThreadPool.h"
+#include "physics/Checkpoint.h"
+#include "physics/Collisions.h"
+#include "physics/PhysicsSystem.h"
+#include "physics/Scenario.h"
+#include "physics/TestParticles.h"
+#include "physics/Trajectory.h"
+
+namespace
+{
+    // Steps between drains of the profiler rings, and the most events kept.
+    constexpr uint64_t TRACE_DRAIN_STEPS = 1024;
+    constexpr size_t   MAX_TRACE_EVENTS = size_t(1) << 21;
+
+    struct Options
+    {
+        std::string scenarioPath;
+        std::string outputPath;
+        std::string snapshotPath;
+        std::string tracePath;
+        std::string recordPath;
+        std::string resumePath;
+        std::string checkpointPath;
+        TrajectoryOptions trajectory;
+        double duration_s = 365.25 * 86400.0;
+        double step_s = 3600.0;
+        double snapshotEvery_s = 0.0;
+        unsigned threads = 0;
+        size_t beltParticles = 0;
+        bool collisions = false;
+        bool counters = false;
+        PhysicsSystem physics;
+    };
+
+    void printUsage()
+    {
+        std::cout <<
+            "Usage: solarsim_headless [options]\n"
+            "  --scenario <file>     initial bodies (default: built-in solar system)\n"
+            "  --resume <file>       continue from a checkpoint, with its integrator, solver and step\n"
+            "  --days <d>            simulated duration in days (default 365.25)\n"
+            "  --years <y>           simulated duration in Julian years\n"
+            "  --step <hours>        fixed step (default 1)\n"
+            "  --integrator <name>   euler, kdk, yoshida4, yoshida6, wh, block, kepler\n"
+            "                        (default wh)\n"
+            "  --solver <name>       direct or barnes-hut (default direct)\n"
+            "  --theta <value>       Barnes-Hut opening angle (default 0.5)\n"
+            "  --threads <n>         worker threads including the main one (default: all cores)\n"
+            "  --belt <n>            add n massless asteroid-belt particles around the heaviest body\n"
+            "  --collisions <on|off> merge bodies whose radii touch (default off)\n"
+            "  --counters <on|off>   report hardware counters per step and per pair (Linux, default off)\n"
+            "  --output <file>       write the final states in scenario format\n"
+            "  --checkpoint <file>   write the final state as a checkpoint\n"
+            "  --snapshots <file>    write CSV snapshots of every body\n"
+            "  --trace <file>        write a Chrome trace of the profiled scopes (SOLARSIM_PROFILE builds)\n"
+            "  --record <file>       write a binary trajectory of the body positions\n"
+            "  --quantum <m>         trajectory position quantum, 0 for exact doubles (default 1000)\n"
+            "  --every <days>        snapshot and trajectory interval (default: every step)\n";
+    }
+
+    bool parseIntegrator(const std::string& name, IntegratorType& type)
+    {
+        static const struct { const char* name; IntegratorType type; } names[] = {
+            { "euler", IntegratorType::SemiImplicitEuler },
+            { "kdk", IntegratorType::LeapfrogKDK },
+            { "yoshida4", IntegratorType::Yoshida4 },
+            { "yoshida6", IntegratorType::Yoshida6 },
+            { "wh", IntegratorType::WisdomHolman },
+            { "block", IntegratorType::BlockTimestep },
+            { "kepler", IntegratorType::Kepler },
+        };
+
+        for (const auto& entry : names)
+        {
+            if (name == entry.name)
+            {
+                type = entry.type;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool parseArguments(int argc, char** argv, Options& options)
+    {
+        options.physics.integrator = IntegratorType::WisdomHolman;
+
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            if (arg == "--help" || arg == "-h")
+            {
+                printUsage();
+                std::exit(0);
+            }
+
+            if (i + 1 >= argc)
+            {
+                std::cerr << "Missing value for " << arg << std::endl;
+                return false;
+            }
+            std::string value = argv[++i];
+
+            if (arg == "--scenario")
+                options.scenarioPath = value;
+            else if (arg == "--days")
+                options.duration_s = std::atof(value.c_str()) * 86400.0;
+            else if (arg == "--years")
+                options.duration_s = std::atof(value.c_str()) * 365.25 * 86400.0;
+            else if (arg == "--step")
+                options.step_s = std::atof(value.c_str()) * 3600.0;
+            else if (arg == "--theta")
+                options.physics.theta = std::atof(value.c_str());
+            else if (arg == "--threads")
+                options.threads = static_cast<unsigned>(std::atoi(value.c_str()));
+            else if (arg == "--belt")
+                options.beltParticles = static_cast<size_t>(std::atoll(value.c_str()));
+            else if (arg == "--resume")
+                options.resumePath = value;
+            else if (arg == "--output")
+                options.outputPath = value;
+            else if (arg == "--checkpoint")
+                options.checkpointPath = value;
+            else if (arg == "--snapshots")
+                options.snapshotPath = value;
+            else if (arg == "--trace")
+                options.tracePath = value;
+            else if (arg == "--record")
+                options.recordPath = value;
+            else if (arg == "--quantum")
+            {
+                options.trajectory.quantum_m = std::atof(value.c_str());
+                options.trajectory.encoding = options.trajectory.quantum_m > 0.0 ? TrajectoryEncoding::Quantized : TrajectoryEncoding::Raw;
+            }
+            else if (arg == "--every")
+                options.snapshotEvery_s = std::atof(value.c_str()) * 86400.0;
+            else if (arg == "--collisions" && (value == "on" || value == "off"))
+                options.collisions = value == "on";
+            else if (arg == "--counters" && (value == "on" || value == "off"))
+                options.counters = value == "on";
+            else if (arg == "--solver" && (value == "direct" || value == "barnes-hut"))
+                options.physics.solver = value == "direct" ? GravitySolver::Direct : GravitySolver::BarnesHut;
+            else if (arg != "--integrator" || !parseIntegrator(value, options.physics.integrator))
+            {
+                std::cerr << "Unknown option or value: " << arg << " " << value << std::endl;
+                return false;
+            }
+        }
+
+        if (options.step_s <= 0.0 || options.duration_s < 0.0)
+        {
+            std::cerr << "Step and duration must be positive" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Body-body pairs of the direct sum plus particle-body interactions.
+    double pairInteractions(uint64_t evaluations, size_t bodies, uint64_t particleInteractions)
+    {
+        return evaluations * (bodies > 1 ? (bodies - 1) / 2.0 : 0.0) + particleInteractions;
+    }
+
+    void printCounters(const PerfReading& counted, uint64_t steps, double pairs)
+    {
+        std::cout << "Counters:   per step, per pair\n";
+        for (int e = 0; e < PERF_EVENT_COUNT; ++e)
+        {
+            PerfEvent event = static_cast<PerfEvent>(e);
+            if (!counted.has(event))
+                continue;
+
+            std::string label = std::string("  ") + perfEventName(event) + ":";
+            std::cout << std::left << std::setw(18) << label << std::right
+                      << (steps > 0 ? counted.get(event) / steps : 0.0) << ", "
+                      << (pairs > 0.0 ? counted.get(event) / pairs : 0.0) << "\n";
+        }
+        if (counted.has(PerfEvent::Cycles) && counted.has(PerfEvent::Instructions) && counted.get(PerfEvent::Cycles) > 0.0)
+            std::cout << "  IPC:            " << counted.get(PerfEvent::Instructions) / counted.get(PerfEvent::Cycles) << "\n";
+        std::cout << std::flush;
+    }
+
+    void writeSnapshot(std::ofstream& out, const Scenario& scenario, const BodySoA& bodies, double time_s)
+    {
+        for (size_t i = 0; i < bodies.size(); ++i)
+        {
+            out << time_s << ',' << scenario.names[i] << ','
+                << bodies.x[i] << ',' << bodies.y[i] << ',' << bodies.z[i] << ','
+                << bodies.vx[i] << ',' << bodies.vy[i] << ',' << bodies.vz[i] << '\n';
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    PROFILE_THREAD("main");
+    Options options;
+    if (!parseArguments(argc, argv, options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    Scenario scenario = builtinSolarSystem();
+    std::string error;
+    if (!options.scenarioPath.empty() && !loadScenario(options.scenarioPath, scenario, error))
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+
+    // A resumed run continues with the checkpoint's settings and step.
+    Checkpoint resumed;
+    double start_s = 0.0;
+    if (!options.resumePath.empty())
+    {
+        if (!loadCheckpoint(options.resumePath, resumed, error))
+        {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+        resumed.bodies.store(scenario.bodies);
+        scenario.names = resumed.names;
+        for (size_t i = scenario.names.size(); i < scenario.bodies.size(); ++i)
+            scenario.names.push_back("body" + std::to_string(i));
+        options.step_s = resumed.step_s;
+        options.collisions = resumed.collisions;
+        start_s = resumed.time_s;
+    }
+
+    std::vector<ProfileEvent> trace;
+    if (!options.tracePath.empty() && !PROFILE_ENABLED)
+        std::cerr << "Built without SOLARSIM_PROFILE, the trace will be empty" << std::endl;
+
+    ThreadPool& pool = ThreadPool::global();
+    if (options.threads > 0)
+        pool.setThreadCount(options.threads);
+
+    PhysicsSystem& physics = options.physics;
+    physics.pool = &pool;
+
+    BodySoA bodies;
+    bodies.assign(scenario.bodies);
+
+    TestParticles particles;
+    particles.pool = &pool;
+    particles.simdLevel = physics.simdLevel;
+    particles.G = PhysicsSystem::G;
+    particles.soften = PhysicsSystem::SOFTEN;
+    if (!options.resumePath.empty() && !resumed.apply(physics, particles))
+    {
+        std::cerr << options.resumePath << ": integrator state does not match" << std::endl;
+        return 1;
+    }
+    if (options.beltParticles > 0 && !scenario.bodies.empty())
+    {
+        size_t central = 0;
+        for (size_t i = 1; i < scenario.bodies.size(); ++i)
+        {
+            if (scenario.bodies[i].mass_kg > scenario.bodies[central].mass_kg)
+                central = i;
+        }
+        generateBelt(mainAsteroidBelt(options.beltParticles), scenario.bodies[central], PhysicsSystem::G, particles.particles);
+    }
+
+    CollisionSystem collisions;
+    collisions.enabled = options.collisions;
+    collisions.pool = &pool;
+    std::vector<MergeEvent> merges;
+
+    std::ofstream snapshots;
+    if (!options.snapshotPath.empty())
+    {
+        snapshots.open(options.snapshotPath);
+        if (!snapshots)
+        {
+            std::cerr << "cannot write " << options.snapshotPath << std::endl;
+            return 1;
+        }
+        snapshots << std::setprecision(17) << "time_s,name,x_m,y_m,z_m,vx_m_s,vy_m_s,vz_m_s\n";
+        writeSnapshot(snapshots, scenario, bodies, start_s);
+    }
+
+    TrajectoryWriter recorder;
+    if (!options.recordPath.empty())
+    {
+        if (!recorder.open(options.recordPath, options.trajectory, error))
+        {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+        recorder.append(start_s, bodies);
+    }
+
+    // The last step is shortened to land on the duration, so a resumed run
+    // steps like an uninterrupted one.
+    uint64_t steps = static_cast<uint64_t>(std::ceil(options.duration_s / options.step_s - 1e-9));
+    double   step = options.step_s;
+    double   lastStep = steps > 0 ? options.duration_s - (steps - 1) * step : step;
+    if (std::abs(lastStep - step) <= 1e-9 * step)
+        lastStep = step;
+    double   energy0 = physics.totalEnergy(bodies);
+    double   nextSnapshot = start_s + options.snapshotEvery_s;
+
+    std::cout << "Bodies:     " << bodies.size() << "\n"
+              << "Particles:  " << particles.size() << "\n"
+              << "Integrator: " << integratorName(physics.integrator) << "\n"
+              << "Solver:     " << (physics.solver == GravitySolver::BarnesHut ? "Barnes-Hut" : "Direct") << "\n"
+              << "Kernel:     " << simdLevelName(physics.simdLevel) << "\n"
+              << "Threads:    " << pool.getThreadCount() << "\n"
+              << "Steps:      " << steps << " x " << step / 3600.0 << " h" << std::endl;
+
+    bool analytic = physics.integrator == IntegratorType::Kepler;
+    // Every thread, the pool workers included, takes part in a step.
+    PerfCounters counters;
+    if (options.counters && !counters.attachProcess(true))
+        std::cerr << "Counters unavailable: " << counters.error() << std::endl;
+    PerfReading counters0 = counters.read();
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint64_t k = 1; k <= steps; ++k)
+    {
+        double dt = k == steps ? lastStep : step;
+        if (analytic)
+        {
+            particles.keplerStep(bodies, dt);
+            physics.step(bodies, dt);
+        }
+        else
+        {
+            particles.beginStep(bodies, dt);
+            physics.step(bodies, dt);
+            particles.endStep(bodies, dt);
+        }
+
+        size_t before = merges.size();
+        if (!analytic && collisions.resolve(bodies, dt, start_s + (k - 1) * step, merges) > 0)
+        {
+            particles.invalidate();
+            for (size_t m = before; m < merges.size(); ++m)
+                scenario.names.erase(scenario.names.begin() + merges[m].absorbed);
+        }
+
+        if (!options.tracePath.empty() && k % TRACE_DRAIN_STEPS == 0 && trace.size() < MAX_TRACE_EVENTS)
+            Profiler::global().drain(trace);
+
+        double time_s = start_s + (k - 1) * step + dt;
+        if ((snapshots.is_open() || recorder.isOpen()) && (time_s >= nextSnapshot - 1e-6 * step || k == steps))
+        {
+            if (snapshots.is_open())
+                writeSnapshot(snapshots, scenario, bodies, time_s);
+            recorder.append(time_s, bodies);
+            if (options.snapshotEvery_s > 0.0)
+                nextSnapshot = (std::floor(time_s / options.snapshotEvery_s + 1e-6) + 1.0) * options.snapshotEvery_s;
+        }
+    }
+
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    PerfReading counted = counters.read() - counters0;
+    double energy1 = physics.totalEnergy(bodies);
+
+    std::cout << std::setprecision(4)
+              << "Wall time:  " << wall << " s\n"
+              << "Steps/s:    " << (wall > 0.0 ? steps / wall : 0.0) << "\n"
+              << "Days/s:     " << (wall > 0.0 ? options.duration_s / 86400.0 / wall : 0.0) << "\n"
+              << "Evals:      " << physics.forceEvaluations() << "\n"
+              << "Merges:     " << merges.size() << "\n"
+              << "Particle interactions/s: " << (wall > 0.0 ? particles.interactions() / wall : 0.0) << "\n"
+              << "dE/E:       " << (energy0 != 0.0 ? (energy1 - energy0) / std::abs(energy0) : 0.0) << std::endl;
+
+    if (recorder.isOpen())
+    {
+        uint64_t frames = recorder.framesAppended();
+        if (!recorder.close(error))
+        {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+        std::cout << "Recorded:   " << frames << " frames to " << options.recordPath << std::endl;
+    }
+
+    if (counters.available())
+        printCounters(counted, steps, pairInteractions(physics.forceEvaluations(), bodies.size(), particles.interactions()));
+
+    if (!options.tracePath.empty())
+    {
+        if (trace.size() < MAX_TRACE_EVENTS)
+            Profiler::global().drain(trace);
+        if (!writeChromeTrace(options.tracePath, trace, Profiler::global().threadNames(), error))
+        {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+    }
+
+    if (!options.checkpointPath.empty())
+    {
+        Checkpoint checkpoint;
+        checkpoint.time_s = start_s + (steps > 0 ? (steps - 1) * step + lastStep : 0.0);
+        checkpoint.step_s = step;
+        checkpoint.collisions = collisions.enabled;
+        checkpoint.bodies = bodies;
+        checkpoint.names = scenario.names;
+        checkpoint.capture(physics, particles);
+        if (!saveCheckpoint(options.checkpointPath, checkpoint, error))
+        {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+    }
+
+    if (!options.outputPath.empty())
+    {
+        bodies.store(scenario.bodies);
+        if (!saveScenario(options.outputPath, scenario, error))
+        {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
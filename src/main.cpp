@@ -5,14 +5,26 @@
 
 #include "core/Window.h"
 #include "core/Shader.h"
-#include "objects/Planet.h"
+#include "core/FrameUniforms.h"
+#include "core/BodyRegistry.h"
 #include "core/Camera.h"
 #include "core/Grid.h"
+#include "core/Bvh.h"
 #include "ui/UIManager.h"
+#include "objects/MeshCache.h"
+#include "objects/BodyRenderer.h"
+#include "objects/ParticleRenderer.h"
 #include "core/Constants.h"
 #include "physics/BodyState.h"
+#include "physics/Scenario.h"
 #include "physics/PhysicsSystem.h"
-#include <memory>
+#include "physics/SimulationThread.h"
+#include "core/ThreadPool.h"
+#include "core/Profiler.h"
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <iterator>
 
 void processInput(Window& window, Camera& camera, float deltaTime);
 void mouseCallback(GLFWwindow* window, double xpos, double ypos);
@@ -29,6 +41,7 @@ UIManager uiManager;
 
 int main()
 {
+    PROFILE_THREAD("render");
     Window window(800, 600, "SolarSystemGL");
     glfwSetFramebufferSizeCallback(window.getGLFWwindow(), [](GLFWwindow*, int width, int height) { glViewport(0, 0, width, height); });
     glfwSetCursorPosCallback(window.getGLFWwindow(), mouseCallback);
@@ -40,80 +53,63 @@ int main()
 
     Shader shader("shaders/VertexShader.glsl", "shaders/FragmentShader.glsl");
 	Shader gridShader("shaders/GridVertexShader.glsl", "shaders/GridFragmentShader.glsl");
+    Shader impostorShader("shaders/ImpostorVertexShader.glsl", "shaders/ImpostorFragmentShader.glsl");
+    Shader gridPlaneShader("shaders/GridPlaneVertexShader.glsl", "shaders/GridPlaneFragmentShader.glsl");
+    Shader particleShader("shaders/ParticleVertexShader.glsl", "shaders/ParticleFragmentShader.glsl");
     PhysicsSystem physics;
+    physics.pool = &ThreadPool::global();
+    physics.integrator = IntegratorType::WisdomHolman;
+
+
+    Scenario scenario = builtinSolarSystem();
+    const glm::vec3 colors[] = {
+        glm::vec3(1.0f, 0.9f, 0.3f),     // Sun
+        glm::vec3(0.5f, 0.5f, 0.5f),     // Mercury
+        glm::vec3(0.95f, 0.85f, 0.55f),  // Venus
+        glm::vec3(0.2f, 0.4f, 1.0f),     // Earth
+        glm::vec3(0.8f, 0.3f, 0.1f),     // Mars
+        glm::vec3(0.9f, 0.7f, 0.4f),     // Jupiter
+        glm::vec3(0.95f, 0.85f, 0.5f),   // Saturn
+        glm::vec3(0.6f, 0.85f, 0.9f),    // Uranus
+        glm::vec3(0.3f, 0.4f, 0.85f)     // Neptune
+    };
+
+    // Continue from the last saved checkpoint, if there is one.
+    BodyRegistry bodies;
+    Checkpoint checkpoint;
+    std::string error;
+    bool resumed = std::filesystem::exists(UIManager::CHECKPOINT_PATH)
+        && loadCheckpoint(UIManager::CHECKPOINT_PATH, checkpoint, error);
+    if (!error.empty())
+        std::cerr << error << std::endl;
+
+    if (resumed)
+    {
+        addCheckpointBodies(checkpoint, bodies);
+        checkpoint.bodies.store(scenario.bodies);
+    }
+    else
+    {
+        for (size_t i = 0; i < scenario.bodies.size(); ++i)
+            scenario.bodies[i].id = bodies.add(scenario.names[i], scenario.bodies[i], colors[i % std::size(colors)]);
+    }
 
+    SimulationThread simulation(physics, scenario.bodies);
+    if (resumed)
+        simulation.restoreCheckpoint(std::move(checkpoint));
+    simulation.start();
+    std::vector<MergeEvent> merges;
+    BodyRenderer bodyRenderer;
+    ParticleRenderer particleRenderer;
+    particleRenderer.pool = &ThreadPool::global();
+    FrameUniforms frameUniforms;
 
-    std::vector<std::shared_ptr<Planet>> planets;
-    std::vector<BodyState> bodies;
-
-    constexpr double METERS_PER_WU = 1.0e9;
-    constexpr double AU = 1.495978707e11;
-    constexpr float  AU_WU = static_cast<float>(AU / METERS_PER_WU);
-
-    planets.emplace_back(std::make_shared<Planet>(
-        "Sun", 1.989e30f, 1408.0f,
-        glm::vec3(0.0f), glm::vec3(0.0f),
-        glm::vec3(1.0f, 0.9f, 0.3f)));
-
-    planets.emplace_back(std::make_shared<Planet>(
-        "Mercury", 3.3011e23f, 5427.0f,
-        glm::vec3(0.387f * AU_WU, 0.0f, 0.0f), glm::vec3(0.0f),
-        glm::vec3(0.5f, 0.5f, 0.5f)));
-
-    planets.emplace_back(std::make_shared<Planet>(
-        "Venus", 4.8675e24f, 5243.0f,
-        glm::vec3(0.723f * AU_WU, 0.0f, 0.0f), glm::vec3(0.0f),
-        glm::vec3(0.95f, 0.85f, 0.55f)));
-
-    planets.emplace_back(std::make_shared<Planet>(
-        "Earth", 5.972e24f, 5514.0f,
-        glm::vec3(1.0f * AU_WU, 0.0f, 0.0f), glm::vec3(0.0f),
-        glm::vec3(0.2f, 0.4f, 1.0f)));
-
-    planets.emplace_back(std::make_shared<Planet>(
-        "Mars", 6.417e23f, 3933.0f,
-        glm::vec3(1.524f * AU_WU, 0.0f, 0.0f), glm::vec3(0.0f),
-        glm::vec3(0.8f, 0.3f, 0.1f)));
-
-    planets.emplace_back(std::make_shared<Planet>(
-        "Jupiter", 1.898e27f, 1326.0f,
-        glm::vec3(5.203f * AU_WU, 0.0f, 0.0f), glm::vec3(0.0f),
-        glm::vec3(0.9f, 0.7f, 0.4f)));
-
-    planets.emplace_back(std::make_shared<Planet>(
-        "Saturn", 5.683e26f, 687.0f,
-        glm::vec3(9.537f * AU_WU, 0.0f, 0.0f), glm::vec3(0.0f),
-        glm::vec3(0.95f, 0.85f, 0.5f)));
-
-    planets.emplace_back(std::make_shared<Planet>(
-        "Uranus", 8.681e25f, 1271.0f,
-        glm::vec3(19.191f * AU_WU, 0.0f, 0.0f), glm::vec3(0.0f),
-        glm::vec3(0.6f, 0.85f, 0.9f)));
-
-    planets.emplace_back(std::make_shared<Planet>(
-        "Neptune", 1.024e26f, 1638.0f,
-        glm::vec3(30.07f * AU_WU, 0.0f, 0.0f), glm::vec3(0.0f),
-        glm::vec3(0.3f, 0.4f, 0.85f)));
-
-    auto addBody = [&](double a_au, double v, double m)
-        {
-            bodies.push_back({
-                glm::dvec3(a_au * AU, 0.0, 0.0),
-                glm::dvec3(0.0, 0.0, v),
-                m });
-        };
-
-    addBody(0.000, 0.0, 1.989e30); // Sol
-    addBody(0.387, 47900.0, 3.3011e23); // Mercrio
-    addBody(0.723, 35000.0, 4.8675e24); // Vnus
-    addBody(1.000, 29780.0, 5.9720e24); // Terra
-    addBody(1.524, 24100.0, 6.4171e23); // Marte
-    addBody(5.203, 13070.0, 1.8980e27); // Jpiter
-    addBody(9.537, 9680.0, 5.6834e26); // Saturno
-    addBody(19.191, 6800.0, 8.6810e25); // Urano
-    addBody(30.070, 5430.0, 1.0240e26); // Netuno
+    Bvh bodyBvh;
+    bodyBvh.pool = &ThreadPool::global();
+    std::vector<uint32_t> visibleBodies;
 
     Grid grid(10000.0f, 200, 0.0f);
+    grid.getField().pool = &ThreadPool::global();
 
     ImGui::CreateContext();
     ImGui_ImplGlfw_InitForOpenGL(window.getGLFWwindow(), true);
@@ -129,49 +125,67 @@ int main()
         processInput(window, camera, deltaTime);
 
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        shader.use();
 
         int width, height;
         glfwGetFramebufferSize(window.getGLFWwindow(), &width, &height);
         glm::mat4 view = camera.getViewMatrix();
-        glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)width / std::max(height, 1), 0.01f, 10000.0f);
-        glm::mat4 model = glm::mat4(1.0f);
+        float fovy = glm::radians(45.0f);
+        glm::mat4 projection = glm::perspective(fovy, (float)width / std::max(height, 1), 0.01f, 10000.0f);
+
+        FrameData frame;
+        frame.view = view;
+        frame.projection = projection;
+        frame.viewProjection = projection * view;
+        frame.cameraPosition = glm::vec4(camera.getPosition(), 1.0f);
+        frame.time = glm::vec4(currentFrame, deltaTime, 0.0f, 0.0f);
+        frame.viewport = glm::vec4(width, height, height / (2.0f * std::tan(fovy / 2.0f)), 0.0f);
+        frameUniforms.update(frame);
+
+        const BodySnapshot& snapshot = simulation.acquireSnapshot();
+        double alpha = snapshot.alphaAt(SimulationThread::clock());
+        {
+            PROFILE_SCOPE("frame.sync");
+            simulation.takeMerges(snapshot.mergeCount, merges);
+            for (const MergeEvent& merge : merges)
+                uiManager.applyMerge(merge, bodies, camera);
 
-        shader.setMat4("view", view);
-        shader.setMat4("projection", projection);
-        shader.setMat4("model", model);
+            interpolatePositions(snapshot, alpha, bodies);
+            uiManager.applyPlayback(bodies);
+        }
 
-        physics.update(bodies, deltaTime);
+        bodyBvh.update(bodies.getPositions(), bodies.getPickRadii(), bodies.getDrawRadii());
+        bodyBvh.cull(Frustum::fromMatrix(frame.viewProjection), visibleBodies);
 
-        for (size_t i = 0; i < planets.size(); ++i)
-        {
-            glm::vec3 renderPos = glm::vec3(bodies[i].pos_m / METERS_PER_WU);
-            planets[i]->setPosition(renderPos);
-        }
+        bodyRenderer.update(bodies, frame, visibleBodies);
+        bodyRenderer.upload();
+        bodyRenderer.draw(shader, impostorShader);
 
-        for (size_t i = 0; i < planets.size(); ++i)
-            planets[i]->render(shader, uiManager.isHovered(i));
+        particleRenderer.update(snapshot, alpha, METERS_PER_WU);
+        particleRenderer.draw(particleShader);
 
 
-        gridShader.use();
-        gridShader.setMat4("view", view);
-        gridShader.setMat4("projection", projection);
-        gridShader.setMat4("model", glm::mat4(1.0f));
-        grid.draw(gridShader, planets);
+        grid.update(bodies);
+        grid.draw(gridShader, gridPlaneShader);
 
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
-        ImGui::NewFrame();
+        {
+            PROFILE_SCOPE("frame.imgui");
+            ImGui_ImplOpenGL3_NewFrame();
+            ImGui_ImplGlfw_NewFrame();
+            ImGui::NewFrame();
 
-        uiManager.render(window, camera, deltaTime, planets, grid);
+            uiManager.render(window, camera, deltaTime, bodies, grid, simulation, bodyBvh);
 
-        ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+            ImGui::Render();
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
 
         glfwSwapBuffers(window.getGLFWwindow());
         glfwPollEvents();
     }
 
+    simulation.stop();
+    MeshCache::global().release();
+
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
@@ -0,0 +1,189 @@
+#include "objects/BodyRenderer.h"
+#include "objects/MeshCache.h"
+#include "core/Profiler.h"
+#include <algorithm>
+#include <cstddef>
+
+BodyRenderer::~BodyRenderer()
+{
+    for (auto& entry : batches)
+    {
+        glDeleteVertexArrays(1, &entry.second.VAO);
+        glDeleteBuffers(1, &entry.second.instanceVBO);
+    }
+}
+
+void BodyRenderer::clear()
+{
+    for (auto& entry : batches)
+        entry.second.instances.clear();
+}
+
+void BodyRenderer::add(int level, const BodyInstance& instance)
+{
+    batches[level].instances.push_back(instance);
+}
+
+void BodyRenderer::update(const BodyRegistry& bodies, const FrameData& frame)
+{
+    clear();
+    levels.resize(bodies.size(), static_cast<int8_t>(LOD_IMPOSTOR - 1));
+
+    for (size_t i = 0; i < bodies.size(); ++i)
+        addBody(bodies, i, frame);
+}
+
+void BodyRenderer::update(const BodyRegistry& bodies, const FrameData& frame, const std::vector<uint32_t>& visible)
+{
+    PROFILE_SCOPE("bodies.update");
+
+    clear();
+    levels.resize(bodies.size(), static_cast<int8_t>(LOD_IMPOSTOR - 1));
+
+    for (uint32_t i : visible)
+    {
+        if (i < bodies.size())
+            addBody(bodies, i, frame);
+    }
+}
+
+void BodyRenderer::addBody(const BodyRegistry& bodies, size_t index, const FrameData& frame)
+{
+    BodyInstance instance;
+    instance.position = bodies.getPositions()[index];
+    instance.scale = bodies.getDrawRadii()[index];
+    instance.color = glm::vec4(bodies.getColors()[index], 1.0f);
+
+    int level = bodies.getSubdivisions()[index];
+    if (lodEnabled)
+    {
+        float distance = glm::length(instance.position - glm::vec3(frame.cameraPosition));
+        float radius_px = projectedRadius(instance.scale, distance, frame.viewport.z);
+        level = selectLod(lod, levels[index], radius_px);
+        levels[index] = static_cast<int8_t>(level);
+    }
+    add(level, instance);
+}
+
+// Mesh batches read the sphere from MeshCache and step the instance
+// attributes once per instance. The impostor batch has no mesh: each
+// instance is one point.
+void BodyRenderer::createBatch(int level, Batch& batch)
+{
+    // Fetch the mesh first: uploading it binds its own vertex array.
+    const MeshCache::Mesh* mesh = level != LOD_IMPOSTOR ? &MeshCache::global().sphere(level) : nullptr;
+
+    glGenVertexArrays(1, &batch.VAO);
+    glGenBuffers(1, &batch.instanceVBO);
+
+    glBindVertexArray(batch.VAO);
+
+    GLuint divisor = 0;
+    if (mesh)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, mesh->VBO);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+        glEnableVertexAttribArray(0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->EBO);
+        divisor = 1;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, batch.instanceVBO);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(BodyInstance), (void*)offsetof(BodyInstance, position));
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, divisor);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(BodyInstance), (void*)offsetof(BodyInstance, color));
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, divisor);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void BodyRenderer::upload()
+{
+    PROFILE_SCOPE("bodies.upload");
+
+    for (auto& entry : batches)
+    {
+        Batch& batch = entry.second;
+        if (batch.instances.empty())
+            continue;
+
+        if (!batch.VAO)
+            createBatch(entry.first, batch);
+
+        // Orphan the old storage so the driver never waits on last frame's draw.
+        size_t bytes = batch.instances.size() * sizeof(BodyInstance);
+        batch.capacity = std::max(batch.capacity, batch.instances.size());
+
+        glBindBuffer(GL_ARRAY_BUFFER, batch.instanceVBO);
+        glBufferData(GL_ARRAY_BUFFER, batch.capacity * sizeof(BodyInstance), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, batch.instances.data());
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void BodyRenderer::draw(Shader& meshShader, Shader& impostorShader) const
+{
+    PROFILE_SCOPE("bodies.draw");
+
+    meshShader.use();
+
+    for (const auto& entry : batches)
+    {
+        const Batch& batch = entry.second;
+        if (batch.instances.empty() || !batch.VAO)
+            continue;
+
+        GLsizei count = static_cast<GLsizei>(batch.instances.size());
+        glBindVertexArray(batch.VAO);
+
+        if (entry.first == LOD_IMPOSTOR)
+        {
+            impostorShader.use();
+            glEnable(GL_PROGRAM_POINT_SIZE);
+            glDrawArrays(GL_POINTS, 0, count);
+            glDisable(GL_PROGRAM_POINT_SIZE);
+            meshShader.use();
+            continue;
+        }
+
+        const MeshCache::Mesh& mesh = MeshCache::global().sphere(entry.first);
+        glDrawElementsInstanced(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_INT, nullptr, count);
+    }
+    glBindVertexArray(0);
+}
+
+size_t BodyRenderer::instanceCount() const
+{
+    size_t count = 0;
+    for (const auto& entry : batches)
+        count += entry.second.instances.size();
+    return count;
+}
+
+size_t BodyRenderer::impostorCount() const
+{
+    auto it = batches.find(LOD_IMPOSTOR);
+    return it != batches.end() ? it->second.instances.size() : 0;
+}
+
+size_t BodyRenderer::triangleCount() const
+{
+    size_t triangles = 0;
+    for (const auto& entry : batches)
+    {
+        if (entry.first != LOD_IMPOSTOR)
+            triangles += entry.second.instances.size() * MeshCache::triangleCount(entry.first);
+    }
+    return triangles;
+}
+
+size_t BodyRenderer::drawCalls() const
+{
+    size_t calls = 0;
+    for (const auto& entry : batches)
+        calls += entry.second.instances.empty() ? 0 : 1;
+    return calls;
+}
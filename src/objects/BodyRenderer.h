@@ -0,0 +1,72 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstdint>
+#include <map>
+#include <vector>
+#include <glm/glm.hpp>
+#include "core/FrameUniforms.h"
+#include "core/Lod.h"
+#include "core/Shader.h"
+#include "core/BodyRegistry.h"
+
+// Per-body data streamed to the GPU every frame; matches the instance
+// attributes of VertexShader.glsl.
+struct BodyInstance
+{
+    glm::vec3 position;
+    float     scale;      // world radius of the unit sphere
+    glm::vec4 color;
+};
+
+// Draws every body with one glDrawElementsInstanced per sphere mesh in use,
+// plus one GL_POINTS draw for the impostors. Fill it with add() (or update()
+// from the registry), upload() once per frame, then draw(). Needs only a
+// current GL 3.3 core context.
+//
+// update() picks each body's mesh from its projected radius (see Lod.h)
+// and remembers the choice per registry index for the hysteresis. Given a
+// list of visible bodies (Bvh::cull), only those are submitted; the others
+// keep their last level.
+class BodyRenderer
+{
+public:
+    BodyRenderer() = default;
+    ~BodyRenderer();
+
+    BodyRenderer(const BodyRenderer&) = delete;
+    BodyRenderer& operator=(const BodyRenderer&) = delete;
+
+    LodSettings lod;
+    bool lodEnabled = true;   // otherwise every body uses its own subdivisions
+
+    void clear();
+    void add(int level, const BodyInstance& instance);
+    void update(const BodyRegistry& bodies, const FrameData& frame);
+    void update(const BodyRegistry& bodies, const FrameData& frame, const std::vector<uint32_t>& visible);
+
+    void upload();
+
+    // meshShader draws the spheres (VertexShader.glsl), impostorShader the
+    // point sprites (ImpostorVertexShader.glsl).
+    void draw(Shader& meshShader, Shader& impostorShader) const;
+
+    size_t instanceCount() const;
+    size_t impostorCount() const;
+    size_t triangleCount() const;
+    size_t drawCalls() const;
+
+private:
+    struct Batch
+    {
+        GLuint VAO = 0;
+        GLuint instanceVBO = 0;
+        size_t capacity = 0;
+        std::vector<BodyInstance> instances;
+    };
+
+    std::map<int, Batch> batches;        // by LOD level, LOD_IMPOSTOR first
+    std::vector<int8_t> levels;          // last level of each body
+
+    void addBody(const BodyRegistry& bodies, size_t index, const FrameData& frame);
+    void createBatch(int level, Batch& batch);
+};
@@ -0,0 +1,52 @@
+#include "objects/MeshCache.h"
+#include "core/Geometry.h"
+
+MeshCache& MeshCache::global()
+{
+    static MeshCache cache;
+    return cache;
+}
+
+const MeshCache::Mesh& MeshCache::sphere(int subdivisions)
+{
+    auto found = spheres.find(subdivisions);
+    if (found != spheres.end())
+        return found->second;
+
+    MeshData data;
+    buildIcosphere(1.0f, subdivisions, data);
+
+    Mesh mesh;
+    mesh.indexCount = static_cast<GLsizei>(data.indices.size());
+
+    glGenVertexArrays(1, &mesh.VAO);
+    glGenBuffers(1, &mesh.VBO);
+    glGenBuffers(1, &mesh.EBO);
+
+    glBindVertexArray(mesh.VAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
+    glBufferData(GL_ARRAY_BUFFER, data.vertices.size() * sizeof(glm::vec3), data.vertices.data(), GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, data.indices.size() * sizeof(unsigned int), data.indices.data(), GL_STATIC_DRAW);
+
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    return spheres.emplace(subdivisions, mesh).first->second;
+}
+
+void MeshCache::release()
+{
+    for (auto& entry : spheres)
+    {
+        glDeleteVertexArrays(1, &entry.second.VAO);
+        glDeleteBuffers(1, &entry.second.VBO);
+        glDeleteBuffers(1, &entry.second.EBO);
+    }
+    spheres.clear();
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstddef>
+#include <map>
+
+// GPU meshes shared by every body: one unit icosphere per subdivision level,
+// uploaded on first use and scaled to each body by its instance radius.
+class MeshCache
+{
+public:
+    struct Mesh
+    {
+        GLuint  VAO = 0, VBO = 0, EBO = 0;
+        GLsizei indexCount = 0;
+    };
+
+    static MeshCache& global();
+
+    const Mesh& sphere(int subdivisions);
+
+    static size_t triangleCount(int subdivisions) { return size_t(20) << (2 * subdivisions); }
+
+    // Deletes the GL objects; call while the context is still current.
+    void release();
+
+private:
+    std::map<int, Mesh> spheres;
+};
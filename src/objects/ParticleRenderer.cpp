@@ -0,0 +1,149 @@
+#include "objects/ParticleRenderer.h"
+#include "core/Profiler.h"
+#include "core/ThreadPool.h"
+#include <algorithm>
+
+namespace
+{
+    constexpr size_t WRITE_GRAIN = 16384;
+    constexpr GLuint64 FENCE_TIMEOUT_NS = 100'000'000;
+}
+
+ParticleRenderer::~ParticleRenderer()
+{
+    release();
+}
+
+void ParticleRenderer::release()
+{
+    for (GLsync& fence : fences)
+    {
+        if (fence)
+            glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    if (mapped)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        mapped = nullptr;
+    }
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    VAO = VBO = 0;
+    capacity = 0;
+}
+
+// Buffer storage cannot be resized, so growing means a new buffer. Capacity
+// grows by half again to keep that rare while a belt is being added.
+void ParticleRenderer::allocate(size_t particles)
+{
+    release();
+
+    capacity = std::max(particles, capacity + capacity / 2);
+    persistent = GLAD_GL_VERSION_4_4 || GLAD_GL_ARB_buffer_storage;
+    region = 0;
+
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+
+    if (persistent)
+    {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        GLsizeiptr bytes = static_cast<GLsizeiptr>(REGIONS * capacity * sizeof(glm::vec3));
+        glBufferStorage(GL_ARRAY_BUFFER, bytes, nullptr, flags);
+        mapped = static_cast<glm::vec3*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, bytes, flags));
+        persistent = mapped != nullptr;
+    }
+    if (!persistent)
+    {
+        glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(glm::vec3), nullptr, GL_STREAM_DRAW);
+        staging.resize(capacity);
+    }
+
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void ParticleRenderer::update(const BodySnapshot& snapshot, double alpha, double metersPerUnit)
+{
+    PROFILE_SCOPE("particles.update");
+
+    count = snapshot.particleCurrent_m.size();
+    if (count == 0)
+        return;
+
+    if (count > capacity)
+        allocate(count);
+
+    glm::vec3* out = staging.data();
+    if (persistent)
+    {
+        GLsync& fence = fences[region];
+        if (fence)
+        {
+            while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT_NS) == GL_TIMEOUT_EXPIRED)
+                ;
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+        out = mapped + region * capacity;
+    }
+
+    const glm::vec3* previous = snapshot.particlePrevious_m.data();
+    const glm::vec3* current = snapshot.particleCurrent_m.data();
+    float t = static_cast<float>(alpha);
+    float scale = static_cast<float>(1.0 / metersPerUnit);
+
+    auto write = [=](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+                out[i] = glm::mix(previous[i], current[i], t) * scale;
+        };
+
+    if (pool)
+        pool->parallelFor(count, WRITE_GRAIN, write);
+    else
+        write(0, count);
+
+    if (!persistent)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(glm::vec3), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(glm::vec3), staging.data());
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+}
+
+void ParticleRenderer::draw(Shader& shader)
+{
+    PROFILE_SCOPE("particles.draw");
+
+    if (count == 0 || !VAO)
+        return;
+
+    static const UniformKey COLOR("particleColor");
+    static const UniformKey POINT_SIZE("pointSize");
+
+    shader.use();
+    shader.set(COLOR, color);
+    shader.set(POINT_SIZE, pointSize_px);
+
+    glBindVertexArray(VAO);
+    glEnable(GL_PROGRAM_POINT_SIZE);
+    glDrawArrays(GL_POINTS, static_cast<GLint>(persistent ? region * capacity : 0), static_cast<GLsizei>(count));
+    glDisable(GL_PROGRAM_POINT_SIZE);
+    glBindVertexArray(0);
+
+    if (persistent)
+    {
+        fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        region = (region + 1) % REGIONS;
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <glad/glad.h>
+#include <vector>
+#include <glm/glm.hpp>
+#include "core/Shader.h"
+#include "physics/SimulationThread.h"
+
+class ThreadPool;
+
+// Draws the test particles of a BodySnapshot as GL_POINTS, straight from a
+// persistently mapped vertex buffer (GL 4.4 or ARB_buffer_storage). The
+// buffer holds REGIONS copies of the positions: update() writes one while the
+// GPU may still read the others, and a fence per region makes it wait only
+// if it laps the GPU. Without buffer storage the positions are streamed with
+// glBufferData orphaning instead.
+class ParticleRenderer
+{
+public:
+    static constexpr int REGIONS = 3;
+
+    ThreadPool* pool = nullptr;   // writes serially when null
+    glm::vec4 color = glm::vec4(0.78f, 0.72f, 0.62f, 0.85f);
+    float pointSize_px = 1.5f;
+
+    ParticleRenderer() = default;
+    ~ParticleRenderer();
+
+    ParticleRenderer(const ParticleRenderer&) = delete;
+    ParticleRenderer& operator=(const ParticleRenderer&) = delete;
+
+    // Blends the snapshot's particle positions like interpolatePositions and
+    // writes them, in render units, into the next region.
+    void update(const BodySnapshot& snapshot, double alpha, double metersPerUnit);
+
+    // shader is ParticleVertexShader.glsl; fences the region it reads.
+    void draw(Shader& shader);
+
+    size_t size() const { return count; }
+    bool isPersistent() const { return persistent; }
+
+private:
+    GLuint VAO = 0;
+    GLuint VBO = 0;
+    glm::vec3* mapped = nullptr;
+    size_t capacity = 0;          // particles per region
+    size_t count = 0;
+    int    region = 0;
+    bool   persistent = false;
+    GLsync fences[REGIONS] = {};
+    std::vector<glm::vec3> staging;
+
+    void allocate(size_t particles);
+    void release();
+};
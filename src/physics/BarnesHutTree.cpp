@@ -0,0 +1,143 @@
+#include "BarnesHutTree.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+void BarnesHutTree::build(const BodySoA& bodies)
+{
+    nodes.clear();
+    positions.clear();
+    masses.clear();
+
+    order.resize(bodies.size());
+    scratch.resize(bodies.size());
+    for (size_t i = 0; i < bodies.size(); ++i)
+        order[i] = static_cast<uint32_t>(i);
+
+    if (bodies.size() == 0)
+        return;
+
+    positions.resize(bodies.size());
+    masses.resize(bodies.size());
+    for (size_t i = 0; i < bodies.size(); ++i)
+    {
+        positions[i] = glm::dvec3(bodies.x[i], bodies.y[i], bodies.z[i]);
+        masses[i] = bodies.mass[i];
+    }
+
+    glm::dvec3 lo = positions[0];
+    glm::dvec3 hi = positions[0];
+    for (const auto& p : positions)
+    {
+        lo = glm::min(lo, p);
+        hi = glm::max(hi, p);
+    }
+
+    glm::dvec3 center = (lo + hi) * 0.5;
+    glm::dvec3 extent = hi - lo;
+    double     halfSize = std::max({ extent.x, extent.y, extent.z, 1.0 }) * 0.5 * 1.0001;
+
+    nodes.reserve(bodies.size() * 2);
+    buildNode(0, static_cast<uint32_t>(bodies.size()), center, halfSize, 0);
+
+    // Store leaf bodies in tree order so each leaf reads a contiguous range.
+    std::vector<glm::dvec3> sortedPos(bodies.size());
+    std::vector<double>     sortedMass(bodies.size());
+    for (size_t k = 0; k < order.size(); ++k)
+    {
+        sortedPos[k] = positions[order[k]];
+        sortedMass[k] = masses[order[k]];
+    }
+    positions.swap(sortedPos);
+    masses.swap(sortedMass);
+}
+
+void BarnesHutTree::buildNode(uint32_t begin, uint32_t end, const glm::dvec3& center, double halfSize, int depth)
+{
+    uint32_t index = static_cast<uint32_t>(nodes.size());
+    nodes.push_back({});
+    nodes[index].center_m = center;
+    nodes[index].halfSize_m = halfSize;
+    nodes[index].firstBody = begin;
+    nodes[index].bodyCount = end - begin;
+
+    if (end - begin <= 1 || depth >= MAX_DEPTH)
+    {
+        glm::dvec3 weighted(0.0);
+        double     mass = 0.0;
+        for (uint32_t k = begin; k < end; ++k)
+        {
+            weighted += positions[order[k]] * masses[order[k]];
+            mass += masses[order[k]];
+        }
+
+        Node& node = nodes[index];
+        node.leaf = true;
+        node.mass_kg = mass;
+        node.com_m = mass > 0.0 ? weighted / mass : center;
+        node.next = index + 1;
+        return;
+    }
+
+    auto octant = [&](uint32_t body)
+        {
+            const glm::dvec3& p = positions[body];
+            return (p.x >= center.x ? 1 : 0) | (p.y >= center.y ? 2 : 0) | (p.z >= center.z ? 4 : 0);
+        };
+
+    std::array<uint32_t, 9> start{};
+    for (uint32_t k = begin; k < end; ++k)
+        ++start[octant(order[k]) + 1];
+    for (int o = 0; o < 8; ++o)
+        start[o + 1] += start[o];
+
+    std::array<uint32_t, 8> cursor;
+    std::copy(start.begin(), start.begin() + 8, cursor.begin());
+    for (uint32_t k = begin; k < end; ++k)
+        scratch[begin + cursor[octant(order[k])]++] = order[k];
+    std::copy(scratch.begin() + begin, scratch.begin() + end, order.begin() + begin);
+
+    glm::dvec3 weighted(0.0);
+    double     mass = 0.0;
+    double     childHalf = halfSize * 0.5;
+
+    for (int o = 0; o < 8; ++o)
+    {
+        uint32_t childBegin = begin + start[o];
+        uint32_t childEnd = begin + start[o + 1];
+        if (childBegin == childEnd) continue;
+
+        glm::dvec3 childCenter = center + glm::dvec3(
+            (o & 1) ? childHalf : -childHalf,
+            (o & 2) ? childHalf : -childHalf,
+            (o & 4) ? childHalf : -childHalf);
+
+        uint32_t child = static_cast<uint32_t>(nodes.size());
+        buildNode(childBegin, childEnd, childCenter, childHalf, depth + 1);
+
+        weighted += nodes[child].com_m * nodes[child].mass_kg;
+        mass += nodes[child].mass_kg;
+    }
+
+    Node& node = nodes[index];
+    node.leaf = false;
+    node.mass_kg = mass;
+    node.com_m = mass > 0.0 ? weighted / mass : center;
+    node.next = static_cast<uint32_t>(nodes.size());
+}
+
+glm::dvec3 BarnesHutTree::accelerationAt(const glm::dvec3& pos, double G, double soften, double theta) const
+{
+    glm::dvec3 acc(0.0);
+
+    // A body's own contribution vanishes because r is exactly zero.
+    walk(pos, 0.0, theta, [&](const glm::dvec3& source, double mass)
+        {
+            glm::dvec3 r = source - pos;
+            double     dist2 = glm::dot(r, r) + soften;
+            double     invD = 1.0 / sqrt(dist2);
+            acc += (G * mass * invD * invD) * r * invD;
+        });
+
+    return acc;
+}
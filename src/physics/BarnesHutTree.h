@@ -0,0 +1,89 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "BodySoA.h"
+
+// Octree over body positions, stored as a flat depth-first node array.
+// Each node keeps a "next" index that skips its whole subtree, so the force
+// walk is a single forward loop over the array without a stack.
+class BarnesHutTree
+{
+public:
+    void build(const BodySoA& bodies);
+
+    // Acceleration at pos from every body in the tree; cells whose size/distance
+    // ratio is below theta are replaced by their monopole.
+    glm::dvec3 accelerationAt(const glm::dvec3& pos, double G, double soften, double theta) const;
+
+    // Calls visit(position, mass) for every cell accepted by the opening test
+    // and for every body of the leaves that are reached. The test holds for
+    // every point within reach of pos, so one walk can serve a whole group of
+    // nearby evaluation points.
+    template <typename Visit>
+    void walk(const glm::dvec3& pos, double reach, double theta, Visit&& visit) const;
+
+    size_t nodeCount() const { return nodes.size(); }
+
+private:
+    struct Node
+    {
+        glm::dvec3 com_m;
+        double     mass_kg;
+        glm::dvec3 center_m;
+        double     halfSize_m;
+        uint32_t   next;
+        uint32_t   firstBody;
+        uint32_t   bodyCount;
+        bool       leaf;
+    };
+
+    static constexpr int MAX_DEPTH = 48;
+
+    std::vector<Node>     nodes;
+    std::vector<uint32_t> order;
+    std::vector<uint32_t> scratch;
+    std::vector<glm::dvec3> positions;
+    std::vector<double>   masses;
+
+    void buildNode(uint32_t begin, uint32_t end, const glm::dvec3& center, double halfSize, int depth);
+};
+
+template <typename Visit>
+void BarnesHutTree::walk(const glm::dvec3& pos, double reach, double theta, Visit&& visit) const
+{
+    double   theta2 = theta * theta;
+    uint32_t count = static_cast<uint32_t>(nodes.size());
+    uint32_t i = 0;
+
+    while (i < count)
+    {
+        const Node& node = nodes[i];
+
+        if (!node.leaf)
+        {
+            glm::dvec3 r = node.com_m - pos;
+            double     size = 2.0 * node.halfSize_m;
+            double     bound = node.halfSize_m + reach;
+            glm::dvec3 offset = glm::abs(pos - node.center_m);
+            bool       inside = offset.x <= bound && offset.y <= bound && offset.z <= bound;
+            double     dist = reach > 0.0 ? std::max(glm::length(r) - reach, 0.0) : 0.0;
+            double     dist2 = reach > 0.0 ? dist * dist : glm::dot(r, r);
+
+            if (inside || size * size >= theta2 * dist2)
+            {
+                ++i;
+                continue;
+            }
+
+            visit(node.com_m, node.mass_kg);
+            i = node.next;
+            continue;
+        }
+
+        for (uint32_t k = node.firstBody; k < node.firstBody + node.bodyCount; ++k)
+            visit(positions[k], masses[k]);
+        i = node.next;
+    }
+}
@@ -0,0 +1,95 @@
+#include "BodySoA.h"
+
+void BodySoA::resize(size_t n)
+{
+    x.resize(n);
+    y.resize(n);
+    z.resize(n);
+    vx.resize(n);
+    vy.resize(n);
+    vz.resize(n);
+    mass.resize(n);
+    radius.resize(n);
+    id.resize(n);
+}
+
+void BodySoA::push_back(const BodyState& body)
+{
+    resize(size() + 1);
+    set(size() - 1, body);
+}
+
+BodyState BodySoA::get(size_t i) const
+{
+    return { glm::dvec3(x[i], y[i], z[i]), glm::dvec3(vx[i], vy[i], vz[i]), mass[i], radius[i], id[i] };
+}
+
+void BodySoA::set(size_t i, const BodyState& body)
+{
+    x[i] = body.pos_m.x;
+    y[i] = body.pos_m.y;
+    z[i] = body.pos_m.z;
+    vx[i] = body.vel_m.x;
+    vy[i] = body.vel_m.y;
+    vz[i] = body.vel_m.z;
+    mass[i] = body.mass_kg;
+    radius[i] = body.radius_m;
+    id[i] = body.id;
+
+    uint32_t slot = body.id & BODY_SLOT_MASK;
+    if (slot >= denseOfSlot.size())
+        denseOfSlot.resize(slot + 1, 0);
+    denseOfSlot[slot] = static_cast<uint32_t>(i);
+}
+
+void BodySoA::swapRemove(size_t i)
+{
+    if (i + 1 < size())
+        set(i, get(size() - 1));
+    resize(size() - 1);
+}
+
+size_t BodySoA::find(BodyId body) const
+{
+    uint32_t slot = body & BODY_SLOT_MASK;
+    if (slot >= denseOfSlot.size())
+        return size();
+
+    size_t i = denseOfSlot[slot];
+    return i < size() && id[i] == body ? i : size();
+}
+
+void BodySoA::reindex()
+{
+    denseOfSlot.clear();
+    for (size_t i = 0; i < size(); ++i)
+    {
+        uint32_t slot = id[i] & BODY_SLOT_MASK;
+        if (slot >= denseOfSlot.size())
+            denseOfSlot.resize(slot + 1, 0);
+        denseOfSlot[slot] = static_cast<uint32_t>(i);
+    }
+}
+
+void BodySoA::assign(const std::vector<BodyState>& bodies)
+{
+    resize(bodies.size());
+
+    for (size_t i = 0; i < bodies.size(); ++i)
+        set(i, bodies[i]);
+}
+
+void BodySoA::store(std::vector<BodyState>& bodies) const
+{
+    bodies.resize(size());
+
+    for (size_t i = 0; i < size(); ++i)
+        bodies[i] = get(i);
+}
+
+void AccelerationSoA::reset(size_t n)
+{
+    x.assign(n, 0.0);
+    y.assign(n, 0.0);
+    z.assign(n, 0.0);
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include "BodyState.h"
+
+template <typename T, size_t Alignment>
+struct AlignedAllocator
+{
+    using value_type = T;
+
+    template <typename U>
+    struct rebind { using other = AlignedAllocator<U, Alignment>; };
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+    T* allocate(size_t n)
+    {
+        size_t bytes = (n * sizeof(T) + Alignment - 1) / Alignment * Alignment;
+        void*  p = ::operator new(bytes, std::align_val_t(Alignment));
+        return static_cast<T*>(p);
+    }
+
+    void deallocate(T* p, size_t)
+    {
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+};
+
+template <typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T, 64>>;
+
+// Structure-of-arrays copy of the body states; every column starts on a
+// cache line so the force kernels can stream it with full-width loads.
+struct BodySoA
+{
+    AlignedVector<double> x, y, z;
+    AlignedVector<double> vx, vy, vz;
+    AlignedVector<double> mass;
+    AlignedVector<double> radius;
+    std::vector<BodyId>   id;            // write through set, or reindex after
+    std::vector<uint32_t> denseOfSlot;   // by the id's slot; checked against id on use
+
+    size_t size() const { return x.size(); }
+    void   resize(size_t n);
+
+    void      push_back(const BodyState& body);
+    BodyState get(size_t i) const;
+    void      set(size_t i, const BodyState& body);
+
+    // O(1): the last body takes the place of body i.
+    void   swapRemove(size_t i);
+    size_t find(BodyId body) const;   // O(1); size() when absent
+
+    // Rebuilds denseOfSlot after the id column was rewritten in bulk.
+    void reindex();
+
+    void assign(const std::vector<BodyState>& bodies);
+    void store(std::vector<BodyState>& bodies) const;
+};
+
+struct AccelerationSoA
+{
+    AlignedVector<double> x, y, z;
+
+    size_t size() const { return x.size(); }
+    void   reset(size_t n);
+};
@@ -1,9 +1,27 @@
 #pragma once
+#include <cmath>
+#include <cstdint>
 #include <glm/glm.hpp>
 
+// Stable name of a body shared by the physics and render threads; see BodyRegistry.
+// The low BODY_SLOT_BITS are a slot that no two live bodies share.
+using BodyId = uint32_t;
+
+constexpr uint32_t BODY_SLOT_BITS = 24;
+constexpr uint32_t BODY_SLOT_MASK = (1u << BODY_SLOT_BITS) - 1;
+
 struct BodyState
 {
     glm::dvec3 pos_m;
     glm::dvec3 vel_m;
     double      mass_kg;
+    double      radius_m = 0.0;   // 0: a point mass that never collides
+    BodyId      id = 0;
 };
+
+// Radius of a uniform sphere; BodyRegistry scales the same value for drawing.
+inline double sphereRadius_m(double mass_kg, double density_kg_m3)
+{
+    constexpr double PI = 3.14159265358979323846;
+    return density_kg_m3 > 0.0 ? std::cbrt(3.0 * mass_kg / (4.0 * PI * density_kg_m3)) : 0.0;
+}
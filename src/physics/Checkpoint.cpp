@@ -0,0 +1,282 @@
+#include "Checkpoint.h"
+#include "core/Profiler.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+
+namespace
+{
+    constexpr char MAGIC[8] = { 'S', 'S', 'C', 'K', 'P', 'T', '\0', '\0' };
+
+    static_assert(sizeof(CheckpointHeader) == 112, "checkpoint header layout");
+
+    AlignedVector<double> BodySoA::* const BODY_COLUMNS[] = {
+        &BodySoA::x, &BodySoA::y, &BodySoA::z, &BodySoA::vx, &BodySoA::vy, &BodySoA::vz,
+        &BodySoA::mass, &BodySoA::radius
+    };
+
+    AlignedVector<double> ParticleSoA::* const PARTICLE_COLUMNS[] = {
+        &ParticleSoA::x, &ParticleSoA::y, &ParticleSoA::z, &ParticleSoA::vx, &ParticleSoA::vy, &ParticleSoA::vz
+    };
+
+    size_t padding(size_t bytes)
+    {
+        return (8 - bytes % 8) % 8;
+    }
+
+    class Output
+    {
+    public:
+        explicit Output(std::FILE* file) : file(file) {}
+
+        bool ok() const { return good; }
+
+        void write(const void* data, size_t bytes)
+        {
+            static const uint8_t zeros[8] = {};
+            if (good && bytes > 0)
+                good = std::fwrite(data, 1, bytes, file) == bytes;
+            if (good && padding(bytes) > 0)
+                good = std::fwrite(zeros, 1, padding(bytes), file) == padding(bytes);
+        }
+
+    private:
+        std::FILE* file;
+        bool good = true;
+    };
+
+    class Input
+    {
+    public:
+        explicit Input(std::FILE* file) : file(file) {}
+
+        bool ok() const { return good; }
+
+        void read(void* data, size_t bytes)
+        {
+            uint8_t skipped[8];
+            if (good && bytes > 0)
+                good = std::fread(data, 1, bytes, file) == bytes;
+            if (good && padding(bytes) > 0)
+                good = std::fread(skipped, 1, padding(bytes), file) == padding(bytes);
+        }
+
+    private:
+        std::FILE* file;
+        bool good = true;
+    };
+
+    std::string packNames(const std::vector<std::string>& names)
+    {
+        std::string packed;
+        for (const std::string& name : names)
+        {
+            uint32_t length = static_cast<uint32_t>(name.size());
+            packed.append(reinterpret_cast<const char*>(&length), sizeof(length));
+            packed.append(name);
+        }
+        return packed;
+    }
+
+    bool unpackNames(const std::string& packed, std::vector<std::string>& names)
+    {
+        names.clear();
+        size_t offset = 0;
+        while (offset < packed.size())
+        {
+            uint32_t length = 0;
+            if (packed.size() - offset < sizeof(length))
+                return false;
+            std::memcpy(&length, packed.data() + offset, sizeof(length));
+            offset += sizeof(length);
+            if (packed.size() - offset < length)
+                return false;
+            names.push_back(packed.substr(offset, length));
+            offset += length;
+        }
+        return true;
+    }
+}
+
+void Checkpoint::capture(const PhysicsSystem& physics, const TestParticles& testParticles)
+{
+    particles = testParticles.particles;
+    testParticles.saveState(particleState);
+    timeScale = physics.timeScale;
+    theta = physics.theta;
+    blockEta = physics.blockEta;
+    integrator = physics.integrator;
+    solver = physics.solver;
+    physics.saveIntegratorState(integratorState);
+}
+
+bool Checkpoint::apply(PhysicsSystem& physics, TestParticles& testParticles) const
+{
+    testParticles.particles = particles;
+    bool particlesFit = testParticles.loadState(particleState);
+    physics.timeScale = timeScale;
+    physics.theta = theta;
+    physics.blockEta = blockEta;
+    physics.integrator = integrator;
+    physics.solver = solver;
+    return physics.restoreIntegratorState(integratorState) && particlesFit;
+}
+
+size_t Checkpoint::bytes() const
+{
+    return bodies.size() * (std::size(BODY_COLUMNS) * sizeof(double) + sizeof(BodyId))
+        + particles.size() * std::size(PARTICLE_COLUMNS) * sizeof(double)
+        + integratorState.size() + particleState.size();
+}
+
+bool saveCheckpoint(const std::string& path, const Checkpoint& checkpoint, std::string& error)
+{
+    PROFILE_SCOPE("checkpoint.save");
+
+    const BodySoA& b = checkpoint.bodies;
+    const ParticleSoA& p = checkpoint.particles;
+    std::string names = packNames(checkpoint.names);
+
+    CheckpointHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MAGIC, sizeof(header.magic));
+    header.version = CHECKPOINT_VERSION;
+    header.integrator = static_cast<uint32_t>(checkpoint.integrator);
+    header.solver = static_cast<uint32_t>(checkpoint.solver);
+    header.collisions = checkpoint.collisions ? 1 : 0;
+    header.bodies = b.size();
+    header.particles = p.size();
+    header.integratorBytes = checkpoint.integratorState.size();
+    header.particleStateBytes = checkpoint.particleState.size();
+    header.nameBytes = names.size();
+    header.colors = checkpoint.colors.size();
+    header.time_s = checkpoint.time_s;
+    header.step_s = checkpoint.step_s;
+    header.timeScale = checkpoint.timeScale;
+    header.theta = checkpoint.theta;
+    header.blockEta = checkpoint.blockEta;
+
+    // Written next to the target and renamed, so a crash never leaves a
+    // half-written checkpoint under the real name.
+    std::string partial = path + ".partial";
+    std::FILE* file = std::fopen(partial.c_str(), "wb");
+    if (!file)
+    {
+        error = "cannot write " + path;
+        return false;
+    }
+
+    Output out(file);
+    out.write(&header, sizeof(header));
+    for (auto column : BODY_COLUMNS)
+        out.write((b.*column).data(), b.size() * sizeof(double));
+    out.write(b.id.data(), b.size() * sizeof(BodyId));
+    for (auto column : PARTICLE_COLUMNS)
+        out.write((p.*column).data(), p.size() * sizeof(double));
+    out.write(checkpoint.integratorState.data(), checkpoint.integratorState.size());
+    out.write(checkpoint.particleState.data(), checkpoint.particleState.size());
+    out.write(names.data(), names.size());
+    out.write(checkpoint.colors.data(), checkpoint.colors.size() * sizeof(glm::vec3));
+
+    // rename replaces the target on POSIX but not on Windows.
+    bool written = std::fclose(file) == 0 && out.ok();
+    bool renamed = written && std::rename(partial.c_str(), path.c_str()) == 0;
+    if (written && !renamed)
+    {
+        std::remove(path.c_str());
+        renamed = std::rename(partial.c_str(), path.c_str()) == 0;
+    }
+    if (!renamed)
+    {
+        std::remove(partial.c_str());
+        error = "cannot write " + path;
+        return false;
+    }
+    return true;
+}
+
+bool loadCheckpoint(const std::string& path, Checkpoint& checkpoint, std::string& error)
+{
+    PROFILE_SCOPE("checkpoint.load");
+
+    std::error_code sizeError;
+    uint64_t size = std::filesystem::file_size(path, sizeError);
+    std::FILE* file = sizeError ? nullptr : std::fopen(path.c_str(), "rb");
+    if (!file)
+    {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    CheckpointHeader header;
+    Input in(file);
+    in.read(&header, sizeof(header));
+    if (!in.ok() || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0)
+    {
+        std::fclose(file);
+        error = path + " is not a checkpoint";
+        return false;
+    }
+    if (header.version > CHECKPOINT_VERSION)
+    {
+        std::fclose(file);
+        error = path + ": checkpoint version " + std::to_string(header.version) + " is newer than this build";
+        return false;
+    }
+
+    // Sizes are checked against the file before anything is allocated.
+    auto padded = [](uint64_t bytes) { return bytes + padding(static_cast<size_t>(bytes)); };
+    uint64_t expected = sizeof(header)
+        + std::size(BODY_COLUMNS) * header.bodies * sizeof(double) + padded(header.bodies * sizeof(BodyId))
+        + std::size(PARTICLE_COLUMNS) * header.particles * sizeof(double)
+        + padded(header.integratorBytes) + padded(header.particleStateBytes) + padded(header.nameBytes) + padded(header.colors * sizeof(glm::vec3));
+    bool sane = header.bodies <= size && header.particles <= size && header.integratorBytes <= size
+        && header.particleStateBytes <= size && header.nameBytes <= size && header.colors <= size
+        && header.integrator < static_cast<uint32_t>(INTEGRATOR_COUNT) && header.solver <= 1;
+    if (!sane || expected != size)
+    {
+        std::fclose(file);
+        error = path + " is truncated or damaged";
+        return false;
+    }
+
+    Checkpoint& c = checkpoint;
+    c.time_s = header.time_s;
+    c.step_s = header.step_s;
+    c.timeScale = header.timeScale;
+    c.theta = header.theta;
+    c.blockEta = header.blockEta;
+    c.integrator = static_cast<IntegratorType>(header.integrator);
+    c.solver = static_cast<GravitySolver>(header.solver);
+    c.collisions = header.collisions != 0;
+
+    c.bodies.resize(static_cast<size_t>(header.bodies));
+    for (auto column : BODY_COLUMNS)
+        in.read((c.bodies.*column).data(), c.bodies.size() * sizeof(double));
+    in.read(c.bodies.id.data(), c.bodies.size() * sizeof(BodyId));
+    c.bodies.reindex();
+
+    c.particles.resize(static_cast<size_t>(header.particles));
+    for (auto column : PARTICLE_COLUMNS)
+        in.read((c.particles.*column).data(), c.particles.size() * sizeof(double));
+
+    c.integratorState.resize(static_cast<size_t>(header.integratorBytes));
+    in.read(c.integratorState.data(), c.integratorState.size());
+    c.particleState.resize(static_cast<size_t>(header.particleStateBytes));
+    in.read(c.particleState.data(), c.particleState.size());
+
+    std::string names(static_cast<size_t>(header.nameBytes), '\0');
+    in.read(&names[0], names.size());
+
+    c.colors.resize(static_cast<size_t>(header.colors));
+    in.read(c.colors.data(), c.colors.size() * sizeof(glm::vec3));
+    std::fclose(file);
+
+    if (!in.ok() || !unpackNames(names, c.names))
+    {
+        error = path + " is truncated or damaged";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "BodySoA.h"
+#include "Integrator.h"
+#include "PhysicsSystem.h"
+#include "TestParticles.h"
+
+// Everything needed to continue a run: the bodies and particles, the time,
+// the step and the physics settings, and the integrator's carry-over. All
+// numbers are kept bit for bit, so stepping a restored state gives the same
+// bits as the run it was taken from (on the same force kernel; simdLevel is
+// chosen per machine and not stored).
+struct Checkpoint
+{
+    double time_s = 0.0;
+    double step_s = 3600.0;
+    double timeScale = 0.0;
+    double theta = 0.5;
+    double blockEta = 0.02;
+    IntegratorType integrator = IntegratorType::SemiImplicitEuler;
+    GravitySolver  solver = GravitySolver::Direct;
+    bool           collisions = false;
+
+    BodySoA              bodies;
+    ParticleSoA          particles;
+    std::vector<uint8_t> integratorState;   // see Integrator::saveState
+    std::vector<uint8_t> particleState;     // see TestParticles::saveState
+
+    // For the app, in body order; either may be empty.
+    std::vector<std::string> names;
+    std::vector<glm::vec3>   colors;
+
+    // The physics settings, the particles and both carry-overs, out of and
+    // back into the systems. apply fails when a carry-over does not fit.
+    void capture(const PhysicsSystem& physics, const TestParticles& testParticles);
+    bool apply(PhysicsSystem& physics, TestParticles& testParticles) const;
+
+    // Memory held by the state, names and colors aside.
+    size_t bytes() const;
+};
+
+// Binary file: a CheckpointHeader, then each column as raw little-endian
+// values on 8-byte boundaries, in the order of the struct. Loading reads the
+// columns straight into place. Files of a later VERSION are refused.
+struct CheckpointHeader
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t integrator;
+    uint32_t solver;
+    uint32_t collisions;
+    uint64_t bodies;
+    uint64_t particles;
+    uint64_t integratorBytes;
+    uint64_t particleStateBytes;
+    uint64_t nameBytes;     // names as length-prefixed strings
+    uint64_t colors;
+    double   time_s;
+    double   step_s;
+    double   timeScale;
+    double   theta;
+    double   blockEta;
+};
+
+constexpr uint32_t CHECKPOINT_VERSION = 1;
+
+bool saveCheckpoint(const std::string& path, const Checkpoint& checkpoint, std::string& error);
+bool loadCheckpoint(const std::string& path, Checkpoint& checkpoint, std::string& error);
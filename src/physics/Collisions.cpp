@@ -0,0 +1,427 @@
+#include "Collisions.h"
+#include "core/Profiler.h"
+#include "core/ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace
+{
+    uint32_t bucketOf(int64_t x, int64_t y, int64_t z, uint32_t mask)
+    {
+        uint64_t h = static_cast<uint64_t>(x) * 0x9E3779B97F4A7C15ull
+                   ^ static_cast<uint64_t>(y) * 0xC2B2AE3D27D4EB4Full
+                   ^ static_cast<uint64_t>(z) * 0x165667B19E3779F9ull;
+        return static_cast<uint32_t>(h >> 32) & mask;
+    }
+
+    int64_t cellOf(double coord, double invCell)
+    {
+        return static_cast<int64_t>(std::floor(std::clamp(coord * invCell, -1e15, 1e15)));
+    }
+
+    template <typename Box>
+    bool boxesOverlap(const Box& a, const Box& b)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            if (a.max[k] < b.min[k] || b.max[k] < a.min[k])
+                return false;
+        }
+        return true;
+    }
+
+    // Relative separation u seconds before the end of the step is d - w u.
+    // Returns whether it comes within the summed radii for u in [0, dt], and
+    // the first such moment as time t from the start of the step.
+    bool sweptContact(const BodySoA& b, uint32_t i, uint32_t j, double dt, double& t)
+    {
+        glm::dvec3 d(b.x[i] - b.x[j], b.y[i] - b.y[j], b.z[i] - b.z[j]);
+        glm::dvec3 w(b.vx[i] - b.vx[j], b.vy[i] - b.vy[j], b.vz[i] - b.vz[j]);
+        double R = b.radius[i] + b.radius[j];
+
+        double ww = glm::dot(w, w);
+        double dw = glm::dot(d, w);
+        double c = glm::dot(d, d) - R * R;
+
+        if (c > 0.0)
+        {
+            if (ww <= 0.0 || dw <= 0.0)
+                return false;
+
+            double u = std::min(dw / ww, dt);
+            if ((ww * u - 2.0 * dw) * u + c > 0.0)
+                return false;
+        }
+        else if (ww <= 0.0)
+        {
+            t = 0.0;
+            return true;
+        }
+
+        double enter = (dw + std::sqrt(std::max(dw * dw - ww * c, 0.0))) / ww;
+        t = std::max(0.0, dt - enter);
+        return true;
+    }
+}
+
+void CollisionSystem::forEachChunk(size_t count, const std::function<void(size_t, size_t)>& body)
+{
+    chunkHits.resize((count + GRAIN - 1) / GRAIN);
+    for (auto& list : chunkHits)
+        list.clear();
+
+    if (pool)
+    {
+        pool->parallelFor(count, GRAIN, body);
+        return;
+    }
+
+    for (size_t begin = 0; begin < count; begin += GRAIN)
+        body(begin, std::min(begin + GRAIN, count));
+}
+
+uint32_t CollisionSystem::find(uint32_t i)
+{
+    while (parent[i] != i)
+    {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+size_t CollisionSystem::resolve(BodySoA& bodies, double dt, double time_s, std::vector<MergeEvent>& events)
+{
+    PROFILE_SCOPE("collisions.resolve");
+
+    hits.clear();
+    candidates = 0;
+    if (!enabled || bodies.size() < 2)
+        return 0;
+
+    buildTable(bodies, dt);
+    findHits(bodies, dt);
+    if (hits.empty())
+        return 0;
+
+    return merge(bodies, time_s, events);
+}
+
+void CollisionSystem::buildTable(const BodySoA& bodies, double dt)
+{
+    size_t n = bodies.size();
+    boxes.resize(n);
+    active.clear();
+    large.clear();
+
+    extents.resize(n);
+    forEachChunk(n, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                double r = bodies.radius[i];
+                double to[3] = { bodies.x[i], bodies.y[i], bodies.z[i] };
+                double vel[3] = { bodies.vx[i], bodies.vy[i], bodies.vz[i] };
+                Box& box = boxes[i];
+                extents[i] = 0.0;
+                for (int k = 0; k < 3; ++k)
+                {
+                    double from = to[k] - vel[k] * dt;
+                    box.min[k] = std::min(from, to[k]) - r;
+                    box.max[k] = std::max(from, to[k]) + r;
+                    extents[i] = std::max(extents[i], box.max[k] - box.min[k]);
+                }
+            }
+        });
+
+    size_t withRadius = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (bodies.radius[i] > 0.0)
+        {
+            active.push_back(static_cast<uint32_t>(i));
+            extents[withRadius++] = extents[i];
+        }
+    }
+    extents.resize(withRadius);
+
+    bucketStart.assign(1, 0);
+    entries.clear();
+    if (active.empty())
+        return;
+
+    std::nth_element(extents.begin(), extents.begin() + extents.size() / 2, extents.end());
+    double invCell = 1.0 / (2.0 * extents[extents.size() / 2]);
+
+    size_t kept = 0;
+    for (uint32_t i : active)
+    {
+        Box& box = boxes[i];
+        size_t cells = 1;
+        for (int k = 0; k < 3; ++k)
+        {
+            box.cellMin[k] = cellOf(box.min[k], invCell);
+            box.cellMax[k] = cellOf(box.max[k], invCell);
+            cells *= static_cast<size_t>(std::min<int64_t>(box.cellMax[k] - box.cellMin[k] + 1, MAX_CELLS_PER_BODY + 1));
+        }
+
+        if (cells > MAX_CELLS_PER_BODY)
+            large.push_back(i);
+        else
+            active[kept++] = i;
+    }
+    active.resize(kept);
+
+    // The table has about one bucket per body. Every (bucket, body) entry is
+    // hashed once, then counting-sorted by bucket.
+    size_t tableSize = 16;
+    while (tableSize < active.size())
+        tableSize *= 2;
+    uint32_t mask = static_cast<uint32_t>(tableSize - 1);
+
+    cellEntries.clear();
+    bucketStart.assign(tableSize + 1, 0);
+    for (uint32_t i : active)
+    {
+        const Box& box = boxes[i];
+        for (int64_t cz = box.cellMin[2]; cz <= box.cellMax[2]; ++cz)
+            for (int64_t cy = box.cellMin[1]; cy <= box.cellMax[1]; ++cy)
+                for (int64_t cx = box.cellMin[0]; cx <= box.cellMax[0]; ++cx)
+                {
+                    uint32_t bucket = bucketOf(cx, cy, cz, mask);
+                    cellEntries.push_back({ bucket, i });
+                    ++bucketStart[bucket + 1];
+                }
+    }
+    std::partial_sum(bucketStart.begin(), bucketStart.end(), bucketStart.begin());
+
+    entries.resize(cellEntries.size());
+    cursor.assign(bucketStart.begin(), bucketStart.end() - 1);
+    for (const auto& entry : cellEntries)
+        entries[cursor[entry.first]++] = entry.second;
+}
+
+void CollisionSystem::findHits(const BodySoA& bodies, double dt)
+{
+    size_t buckets = bucketStart.size() - 1;
+    uint32_t mask = static_cast<uint32_t>(buckets - 1);
+    std::vector<uint64_t> chunkCandidates((buckets + GRAIN - 1) / GRAIN, 0);
+
+    auto test = [&](uint32_t a, uint32_t b, std::vector<Hit>& out)
+        {
+            double t;
+            if (boxesOverlap(boxes[a], boxes[b]) && sweptContact(bodies, a, b, dt, t))
+                out.push_back({ t, std::min(a, b), std::max(a, b) });
+        };
+
+    // A pair sharing several cells is tested only in the bucket of the lowest
+    // shared cell; pairs that merely collide in the hash are filtered by the
+    // box test, and a leftover duplicate is removed when the hits are sorted.
+    forEachChunk(buckets, [&](size_t begin, size_t end)
+        {
+            std::vector<Hit>& out = chunkHits[begin / GRAIN];
+            uint64_t tested = 0;
+            for (size_t bucket = begin; bucket < end; ++bucket)
+            {
+                if (bucketStart[bucket + 1] - bucketStart[bucket] < 2)
+                    continue;
+
+                for (uint32_t p = bucketStart[bucket]; p < bucketStart[bucket + 1]; ++p)
+                {
+                    const Box& a = boxes[entries[p]];
+                    for (uint32_t q = p + 1; q < bucketStart[bucket + 1]; ++q)
+                    {
+                        const Box& b = boxes[entries[q]];
+                        if (entries[p] == entries[q])
+                            continue;
+
+                        int64_t shared[3];
+                        bool overlap = true;
+                        for (int k = 0; k < 3; ++k)
+                        {
+                            shared[k] = std::max(a.cellMin[k], b.cellMin[k]);
+                            overlap = overlap && shared[k] <= std::min(a.cellMax[k], b.cellMax[k]);
+                        }
+                        if (!overlap || bucketOf(shared[0], shared[1], shared[2], mask) != bucket)
+                            continue;
+
+                        ++tested;
+                        test(entries[p], entries[q], out);
+                    }
+                }
+            }
+            chunkCandidates[begin / GRAIN] = tested;
+        });
+
+    for (size_t c = 0; c < chunkHits.size(); ++c)
+    {
+        hits.insert(hits.end(), chunkHits[c].begin(), chunkHits[c].end());
+        candidates += chunkCandidates[c];
+    }
+
+    if (!large.empty())
+    {
+        forEachChunk(active.size(), [&](size_t begin, size_t end)
+            {
+                std::vector<Hit>& out = chunkHits[begin / GRAIN];
+                for (size_t k = begin; k < end; ++k)
+                {
+                    for (uint32_t big : large)
+                        test(active[k], big, out);
+                }
+            });
+
+        for (const auto& list : chunkHits)
+            hits.insert(hits.end(), list.begin(), list.end());
+
+        for (size_t p = 0; p < large.size(); ++p)
+        {
+            for (size_t q = p + 1; q < large.size(); ++q)
+                test(large[p], large[q], hits);
+        }
+        candidates += active.size() * large.size() + large.size() * (large.size() - 1) / 2;
+    }
+}
+
+size_t CollisionSystem::merge(BodySoA& bodies, double time_s, std::vector<MergeEvent>& events)
+{
+    std::sort(hits.begin(), hits.end(), [](const Hit& l, const Hit& r)
+        {
+            return l.a != r.a ? l.a < r.a : l.b < r.b;
+        });
+    hits.erase(std::unique(hits.begin(), hits.end(), [](const Hit& l, const Hit& r)
+        {
+            return l.a == r.a && l.b == r.b;
+        }), hits.end());
+
+    // Union-find over the bodies that were hit, in ascending index order.
+    std::vector<uint32_t> members;
+    for (const Hit& h : hits)
+    {
+        members.push_back(h.a);
+        members.push_back(h.b);
+    }
+    std::sort(members.begin(), members.end());
+    members.erase(std::unique(members.begin(), members.end()), members.end());
+
+    auto slotOf = [&](uint32_t body)
+        {
+            return static_cast<uint32_t>(std::lower_bound(members.begin(), members.end(), body) - members.begin());
+        };
+
+    parent.resize(members.size());
+    std::iota(parent.begin(), parent.end(), 0u);
+    std::vector<double> contact(members.size(), std::numeric_limits<double>::max());
+    for (const Hit& h : hits)
+    {
+        uint32_t a = find(slotOf(h.a));
+        uint32_t b = find(slotOf(h.b));
+        double t = std::min({ h.t, contact[a], contact[b] });
+        parent[std::max(a, b)] = std::min(a, b);
+        contact[std::min(a, b)] = t;
+    }
+
+    std::vector<uint32_t> order(members.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::vector<uint32_t> roots(members.size());
+    for (uint32_t s = 0; s < members.size(); ++s)
+        roots[s] = find(s);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t l, uint32_t r) { return roots[l] < roots[r]; });
+
+    struct Absorbed { uint32_t body, survivor; double time_s; };
+    std::vector<Absorbed> absorbed;
+    std::vector<std::pair<uint32_t, BodyState>> merged;
+
+    for (size_t begin = 0; begin < order.size();)
+    {
+        uint32_t root = roots[order[begin]];
+        size_t end = begin;
+        while (end < order.size() && roots[order[end]] == root)
+            ++end;
+
+        uint32_t survivor = members[order[begin]];
+        double mass = 0.0, volume = 0.0;
+        glm::dvec3 momentum(0.0), moment(0.0), sumPos(0.0), sumVel(0.0);
+        for (size_t k = begin; k < end; ++k)
+        {
+            uint32_t i = members[order[k]];
+            if (bodies.mass[i] > bodies.mass[survivor])
+                survivor = i;
+
+            double m = bodies.mass[i];
+            glm::dvec3 pos(bodies.x[i], bodies.y[i], bodies.z[i]);
+            glm::dvec3 vel(bodies.vx[i], bodies.vy[i], bodies.vz[i]);
+            mass += m;
+            momentum += m * vel;
+            moment += m * pos;
+            sumPos += pos;
+            sumVel += vel;
+            volume += bodies.radius[i] * bodies.radius[i] * bodies.radius[i];
+        }
+
+        double count = static_cast<double>(end - begin);
+        BodyState body;
+        body.pos_m = mass > 0.0 ? moment / mass : sumPos / count;
+        body.vel_m = mass > 0.0 ? momentum / mass : sumVel / count;
+        body.mass_kg = mass;
+        body.radius_m = std::cbrt(volume);
+        body.id = bodies.id[survivor];
+        merged.push_back({ survivor, body });
+
+        for (size_t k = begin; k < end; ++k)
+        {
+            uint32_t i = members[order[k]];
+            if (i != survivor)
+                absorbed.push_back({ i, survivor, time_s + contact[root] });
+        }
+        begin = end;
+    }
+
+    for (const auto& m : merged)
+        bodies.set(m.first, m.second);
+
+    // Events erase from the back, so each survivor only shifts by the
+    // absorbed bodies below it that are already gone.
+    std::sort(absorbed.begin(), absorbed.end(), [](const Absorbed& l, const Absorbed& r) { return l.body > r.body; });
+    for (size_t k = 0; k < absorbed.size(); ++k)
+    {
+        uint32_t survivor = absorbed[k].survivor;
+        uint32_t shift = 0;
+        for (size_t e = 0; e < k; ++e)
+            shift += absorbed[e].body < survivor ? 1 : 0;
+
+        events.push_back({ survivor - shift, absorbed[k].body, bodies.id[survivor], bodies.id[absorbed[k].body],
+            absorbed[k].time_s, bodies.mass[survivor], bodies.radius[survivor] });
+    }
+
+    std::vector<uint32_t> gone;
+    for (const Absorbed& a : absorbed)
+        gone.push_back(a.body);
+    std::sort(gone.begin(), gone.end());
+
+    auto compact = [&](auto& column)
+        {
+            size_t out = gone.front();
+            size_t next = 0;
+            for (size_t i = gone.front(); i < column.size(); ++i)
+            {
+                if (next < gone.size() && gone[next] == i)
+                {
+                    ++next;
+                    continue;
+                }
+                column[out++] = column[i];
+            }
+            column.resize(out);
+        };
+
+    for (AlignedVector<double>* column : { &bodies.x, &bodies.y, &bodies.z, &bodies.vx, &bodies.vy, &bodies.vz,
+        &bodies.mass, &bodies.radius })
+        compact(*column);
+    compact(bodies.id);
+    bodies.reindex();
+
+    return absorbed.size();
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+#include "BodySoA.h"
+
+class ThreadPool;
+
+// One body swallowed by another. Replaying the events of a pass in order,
+// erasing `absorbed` each time, turns the old body list into the new one, so
+// survivor and absorbed are indices at the moment the event is applied.
+// The ids name the same bodies independently of order.
+struct MergeEvent
+{
+    uint32_t survivor;
+    uint32_t absorbed;
+    BodyId   survivorId;
+    BodyId   absorbedId;
+    double   time_s;     // simulation time of first contact
+    double   mass_kg;    // survivor after the pass
+    double   radius_m;
+};
+
+// Finds bodies that touched during the step that just ended and merges them.
+//
+// Broad phase: the box swept by each sphere over the step goes into a
+// uniform spatial hash whose cell edge is twice the median box size. The
+// table is rebuilt every pass with a counting sort, so it costs O(N) with no
+// per-cell allocations. Boxes spanning more than MAX_CELLS_PER_BODY cells
+// (the Sun, fast bodies) are kept aside and tested against every box.
+//
+// Narrow phase: each body moves on a straight line from its end position
+// back along its end velocity, and two spheres touch when their relative
+// path comes within the sum of the radii during the step.
+//
+// Bodies that touch are merged transitively into the heaviest of the group
+// (lowest index on ties): masses and momenta add, the position is the centre
+// of mass and the volume is kept. Bodies with a zero radius never collide.
+// The result does not depend on the thread count.
+class CollisionSystem
+{
+public:
+    static constexpr size_t MAX_CELLS_PER_BODY = 64;
+    static constexpr size_t GRAIN = 1024;
+
+    bool enabled = true;
+    ThreadPool* pool = nullptr;   // serial when null
+
+    // Appends one event per absorbed body and returns how many there were.
+    size_t resolve(BodySoA& bodies, double dt, double time_s, std::vector<MergeEvent>& events);
+
+    // Box pairs that shared a hash bucket in the last pass.
+    uint64_t candidatePairs() const { return candidates; }
+
+private:
+    struct Box
+    {
+        double  min[3];
+        double  max[3];
+        int64_t cellMin[3];
+        int64_t cellMax[3];
+    };
+
+    struct Hit
+    {
+        double   t;   // contact time from the start of the step
+        uint32_t a, b;
+    };
+
+    std::vector<Box>      boxes;
+    std::vector<uint32_t> active;      // bodies with a radius, in the table
+    std::vector<uint32_t> large;       // bodies too big for the table
+    std::vector<double>   extents;
+    std::vector<std::pair<uint32_t, uint32_t>> cellEntries;   // bucket, body
+    std::vector<uint32_t> bucketStart;
+    std::vector<uint32_t> cursor;
+    std::vector<uint32_t> entries;     // bodies, grouped by bucket
+    std::vector<std::vector<Hit>> chunkHits;
+    std::vector<Hit>      hits;
+    std::vector<uint32_t> parent;
+    uint64_t candidates = 0;
+
+    uint32_t find(uint32_t i);
+    void forEachChunk(size_t count, const std::function<void(size_t, size_t)>& body);
+    void buildTable(const BodySoA& bodies, double dt);
+    void findHits(const BodySoA& bodies, double dt);
+    size_t merge(BodySoA& bodies, double time_s, std::vector<MergeEvent>& events);
+};
@@ -0,0 +1,529 @@
+#include "ForceKernels.h"
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SOLARSIM_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(SOLARSIM_X86) && (defined(__GNUC__) || defined(__clang__))
+#define SOLARSIM_TARGET(isa) __attribute__((target(isa)))
+#else
+#define SOLARSIM_TARGET(isa)
+#endif
+
+// GCC's AVX-512 headers leave the pass-through operand of unmasked
+// intrinsics undefined on purpose, which -Wmaybe-uninitialized reports at
+// every inlined use.
+#if defined(__GNUC__) && !defined(__clang__)
+#define SOLARSIM_AVX512_BEGIN _Pragma("GCC diagnostic push") _Pragma("GCC diagnostic ignored \"-Wmaybe-uninitialized\"")
+#define SOLARSIM_AVX512_END   _Pragma("GCC diagnostic pop")
+#else
+#define SOLARSIM_AVX512_BEGIN
+#define SOLARSIM_AVX512_END
+#endif
+
+namespace
+{
+    void pairwiseScalar(const BodySoA& b, size_t firstRow, size_t rowStride, double G, double soften, AccelerationSoA& acc)
+    {
+        size_t n = b.size();
+
+        for (size_t i = firstRow; i < n; i += rowStride)
+        {
+            double axi = 0.0, ayi = 0.0, azi = 0.0;
+            double gmi = G * b.mass[i];
+
+            for (size_t j = i + 1; j < n; ++j)
+            {
+                double dx = b.x[j] - b.x[i];
+                double dy = b.y[j] - b.y[i];
+                double dz = b.z[j] - b.z[i];
+                double dist2 = dx * dx + dy * dy + dz * dz + soften;
+                double inv3 = 1.0 / (dist2 * std::sqrt(dist2));
+
+                double fj = G * b.mass[j] * inv3;
+                axi += fj * dx;
+                ayi += fj * dy;
+                azi += fj * dz;
+
+                double fi = gmi * inv3;
+                acc.x[j] -= fi * dx;
+                acc.y[j] -= fi * dy;
+                acc.z[j] -= fi * dz;
+            }
+
+            acc.x[i] += axi;
+            acc.y[i] += ayi;
+            acc.z[i] += azi;
+        }
+    }
+
+    // The self term has dx = dv = 0 and adds nothing, so no i != j test is needed.
+    void targetsScalar(const BodySoA& b, const uint32_t* targets, size_t count, double G, double soften,
+        AccelerationSoA& acc, AccelerationSoA& jerk)
+    {
+        size_t n = b.size();
+
+        for (size_t t = 0; t < count; ++t)
+        {
+            size_t i = targets[t];
+            double ax = 0.0, ay = 0.0, az = 0.0;
+            double jx = 0.0, jy = 0.0, jz = 0.0;
+
+            for (size_t j = 0; j < n; ++j)
+            {
+                double dx = b.x[j] - b.x[i];
+                double dy = b.y[j] - b.y[i];
+                double dz = b.z[j] - b.z[i];
+                double dvx = b.vx[j] - b.vx[i];
+                double dvy = b.vy[j] - b.vy[i];
+                double dvz = b.vz[j] - b.vz[i];
+                double dist2 = dx * dx + dy * dy + dz * dz + soften;
+                double inv3 = 1.0 / (dist2 * std::sqrt(dist2));
+
+                double f = G * b.mass[j] * inv3;
+                double rv = 3.0 * (dx * dvx + dy * dvy + dz * dvz) / dist2;
+                ax += f * dx;
+                ay += f * dy;
+                az += f * dz;
+                jx += f * (dvx - rv * dx);
+                jy += f * (dvy - rv * dy);
+                jz += f * (dvz - rv * dz);
+            }
+
+            acc.x[i] = ax;
+            acc.y[i] = ay;
+            acc.z[i] = az;
+            jerk.x[i] = jx;
+            jerk.y[i] = jy;
+            jerk.z[i] = jz;
+        }
+    }
+
+    void sourcesScalar(const BodySoA& b, const double* x, const double* y, const double* z, size_t begin, size_t count,
+        double G, double soften, double* ax, double* ay, double* az)
+    {
+        size_t n = b.size();
+
+        for (size_t i = begin; i < count; ++i)
+        {
+            double sx = 0.0, sy = 0.0, sz = 0.0;
+
+            for (size_t j = 0; j < n; ++j)
+            {
+                double dx = b.x[j] - x[i];
+                double dy = b.y[j] - y[i];
+                double dz = b.z[j] - z[i];
+                double dist2 = dx * dx + dy * dy + dz * dz + soften;
+                double f = G * b.mass[j] / (dist2 * std::sqrt(dist2));
+
+                sx += f * dx;
+                sy += f * dy;
+                sz += f * dz;
+            }
+
+            ax[i] = sx;
+            ay[i] = sy;
+            az[i] = sz;
+        }
+    }
+
+#if defined(SOLARSIM_X86)
+    SOLARSIM_TARGET("avx2")
+    double horizontalSum(__m256d v)
+    {
+        __m128d lo = _mm256_castpd256_pd128(v);
+        __m128d hi = _mm256_extractf128_pd(v, 1);
+        lo = _mm_add_pd(lo, hi);
+        return _mm_cvtsd_f64(_mm_add_sd(lo, _mm_unpackhi_pd(lo, lo)));
+    }
+
+    SOLARSIM_TARGET("avx2")
+    void pairwiseAvx2(const BodySoA& b, size_t firstRow, size_t rowStride, double G, double soften, AccelerationSoA& acc)
+    {
+        size_t n = b.size();
+        const __m256d vG = _mm256_set1_pd(G);
+        const __m256d vSoft = _mm256_set1_pd(soften);
+        const __m256d one = _mm256_set1_pd(1.0);
+
+        for (size_t i = firstRow; i < n; i += rowStride)
+        {
+            const __m256d xi = _mm256_set1_pd(b.x[i]);
+            const __m256d yi = _mm256_set1_pd(b.y[i]);
+            const __m256d zi = _mm256_set1_pd(b.z[i]);
+            const __m256d gmi = _mm256_set1_pd(G * b.mass[i]);
+            __m256d axi = _mm256_setzero_pd();
+            __m256d ayi = _mm256_setzero_pd();
+            __m256d azi = _mm256_setzero_pd();
+
+            size_t j = i + 1;
+            for (; j + 4 <= n; j += 4)
+            {
+                __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(&b.x[j]), xi);
+                __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(&b.y[j]), yi);
+                __m256d dz = _mm256_sub_pd(_mm256_loadu_pd(&b.z[j]), zi);
+                __m256d dist2 = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)),
+                                              _mm256_add_pd(_mm256_mul_pd(dz, dz), vSoft));
+                __m256d inv3 = _mm256_div_pd(one, _mm256_mul_pd(dist2, _mm256_sqrt_pd(dist2)));
+
+                __m256d fj = _mm256_mul_pd(_mm256_mul_pd(vG, _mm256_loadu_pd(&b.mass[j])), inv3);
+                axi = _mm256_add_pd(axi, _mm256_mul_pd(fj, dx));
+                ayi = _mm256_add_pd(ayi, _mm256_mul_pd(fj, dy));
+                azi = _mm256_add_pd(azi, _mm256_mul_pd(fj, dz));
+
+                __m256d fi = _mm256_mul_pd(gmi, inv3);
+                _mm256_storeu_pd(&acc.x[j], _mm256_sub_pd(_mm256_loadu_pd(&acc.x[j]), _mm256_mul_pd(fi, dx)));
+                _mm256_storeu_pd(&acc.y[j], _mm256_sub_pd(_mm256_loadu_pd(&acc.y[j]), _mm256_mul_pd(fi, dy)));
+                _mm256_storeu_pd(&acc.z[j], _mm256_sub_pd(_mm256_loadu_pd(&acc.z[j]), _mm256_mul_pd(fi, dz)));
+            }
+
+            double sx = horizontalSum(axi), sy = horizontalSum(ayi), sz = horizontalSum(azi);
+            double gm = G * b.mass[i];
+
+            for (; j < n; ++j)
+            {
+                double dx = b.x[j] - b.x[i];
+                double dy = b.y[j] - b.y[i];
+                double dz = b.z[j] - b.z[i];
+                double dist2 = dx * dx + dy * dy + dz * dz + soften;
+                double inv3 = 1.0 / (dist2 * std::sqrt(dist2));
+
+                double fj = G * b.mass[j] * inv3;
+                sx += fj * dx;
+                sy += fj * dy;
+                sz += fj * dz;
+
+                double fi = gm * inv3;
+                acc.x[j] -= fi * dx;
+                acc.y[j] -= fi * dy;
+                acc.z[j] -= fi * dz;
+            }
+
+            acc.x[i] += sx;
+            acc.y[i] += sy;
+            acc.z[i] += sz;
+        }
+    }
+
+SOLARSIM_AVX512_BEGIN
+    SOLARSIM_TARGET("avx512f")
+    void pairwiseAvx512(const BodySoA& b, size_t firstRow, size_t rowStride, double G, double soften, AccelerationSoA& acc)
+    {
+        size_t n = b.size();
+        const __m512d vG = _mm512_set1_pd(G);
+        const __m512d vSoft = _mm512_set1_pd(soften);
+        const __m512d one = _mm512_set1_pd(1.0);
+
+        for (size_t i = firstRow; i < n; i += rowStride)
+        {
+            const __m512d xi = _mm512_set1_pd(b.x[i]);
+            const __m512d yi = _mm512_set1_pd(b.y[i]);
+            const __m512d zi = _mm512_set1_pd(b.z[i]);
+            const __m512d gmi = _mm512_set1_pd(G * b.mass[i]);
+            __m512d axi = _mm512_setzero_pd();
+            __m512d ayi = _mm512_setzero_pd();
+            __m512d azi = _mm512_setzero_pd();
+
+            size_t j = i + 1;
+            for (; j < n; j += 8)
+            {
+                // The tail is handled with a lane mask instead of a scalar loop.
+                __mmask8 m = j + 8 <= n ? __mmask8(0xFF) : __mmask8((1u << (n - j)) - 1u);
+
+                __m512d dx = _mm512_sub_pd(_mm512_maskz_loadu_pd(m, &b.x[j]), xi);
+                __m512d dy = _mm512_sub_pd(_mm512_maskz_loadu_pd(m, &b.y[j]), yi);
+                __m512d dz = _mm512_sub_pd(_mm512_maskz_loadu_pd(m, &b.z[j]), zi);
+                __m512d dist2 = _mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(dx, dx), _mm512_mul_pd(dy, dy)),
+                                              _mm512_add_pd(_mm512_mul_pd(dz, dz), vSoft));
+                __m512d inv3 = _mm512_div_pd(one, _mm512_mul_pd(dist2, _mm512_sqrt_pd(dist2)));
+
+                __m512d fj = _mm512_mul_pd(_mm512_mul_pd(vG, _mm512_maskz_loadu_pd(m, &b.mass[j])), inv3);
+                axi = _mm512_add_pd(axi, _mm512_mul_pd(fj, dx));
+                ayi = _mm512_add_pd(ayi, _mm512_mul_pd(fj, dy));
+                azi = _mm512_add_pd(azi, _mm512_mul_pd(fj, dz));
+
+                __m512d fi = _mm512_mul_pd(gmi, inv3);
+                _mm512_mask_storeu_pd(&acc.x[j], m, _mm512_sub_pd(_mm512_maskz_loadu_pd(m, &acc.x[j]), _mm512_mul_pd(fi, dx)));
+                _mm512_mask_storeu_pd(&acc.y[j], m, _mm512_sub_pd(_mm512_maskz_loadu_pd(m, &acc.y[j]), _mm512_mul_pd(fi, dy)));
+                _mm512_mask_storeu_pd(&acc.z[j], m, _mm512_sub_pd(_mm512_maskz_loadu_pd(m, &acc.z[j]), _mm512_mul_pd(fi, dz)));
+            }
+
+            acc.x[i] += _mm512_reduce_add_pd(axi);
+            acc.y[i] += _mm512_reduce_add_pd(ayi);
+            acc.z[i] += _mm512_reduce_add_pd(azi);
+        }
+    }
+SOLARSIM_AVX512_END
+
+    SOLARSIM_TARGET("avx2")
+    void targetsAvx2(const BodySoA& b, const uint32_t* targets, size_t count, double G, double soften,
+        AccelerationSoA& acc, AccelerationSoA& jerk)
+    {
+        size_t n = b.size();
+        const __m256d vG = _mm256_set1_pd(G);
+        const __m256d vSoft = _mm256_set1_pd(soften);
+        const __m256d one = _mm256_set1_pd(1.0);
+        const __m256d three = _mm256_set1_pd(3.0);
+
+        for (size_t t = 0; t < count; ++t)
+        {
+            size_t i = targets[t];
+            const __m256d xi = _mm256_set1_pd(b.x[i]);
+            const __m256d yi = _mm256_set1_pd(b.y[i]);
+            const __m256d zi = _mm256_set1_pd(b.z[i]);
+            const __m256d vxi = _mm256_set1_pd(b.vx[i]);
+            const __m256d vyi = _mm256_set1_pd(b.vy[i]);
+            const __m256d vzi = _mm256_set1_pd(b.vz[i]);
+            __m256d ax = _mm256_setzero_pd(), ay = _mm256_setzero_pd(), az = _mm256_setzero_pd();
+            __m256d jx = _mm256_setzero_pd(), jy = _mm256_setzero_pd(), jz = _mm256_setzero_pd();
+
+            size_t j = 0;
+            for (; j + 4 <= n; j += 4)
+            {
+                __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(&b.x[j]), xi);
+                __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(&b.y[j]), yi);
+                __m256d dz = _mm256_sub_pd(_mm256_loadu_pd(&b.z[j]), zi);
+                __m256d dvx = _mm256_sub_pd(_mm256_loadu_pd(&b.vx[j]), vxi);
+                __m256d dvy = _mm256_sub_pd(_mm256_loadu_pd(&b.vy[j]), vyi);
+                __m256d dvz = _mm256_sub_pd(_mm256_loadu_pd(&b.vz[j]), vzi);
+                __m256d dist2 = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)),
+                                              _mm256_add_pd(_mm256_mul_pd(dz, dz), vSoft));
+                __m256d inv3 = _mm256_div_pd(one, _mm256_mul_pd(dist2, _mm256_sqrt_pd(dist2)));
+
+                __m256d f = _mm256_mul_pd(_mm256_mul_pd(vG, _mm256_loadu_pd(&b.mass[j])), inv3);
+                __m256d rv = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx, dvx), _mm256_mul_pd(dy, dvy)), _mm256_mul_pd(dz, dvz));
+                rv = _mm256_div_pd(_mm256_mul_pd(three, rv), dist2);
+
+                ax = _mm256_add_pd(ax, _mm256_mul_pd(f, dx));
+                ay = _mm256_add_pd(ay, _mm256_mul_pd(f, dy));
+                az = _mm256_add_pd(az, _mm256_mul_pd(f, dz));
+                jx = _mm256_add_pd(jx, _mm256_mul_pd(f, _mm256_sub_pd(dvx, _mm256_mul_pd(rv, dx))));
+                jy = _mm256_add_pd(jy, _mm256_mul_pd(f, _mm256_sub_pd(dvy, _mm256_mul_pd(rv, dy))));
+                jz = _mm256_add_pd(jz, _mm256_mul_pd(f, _mm256_sub_pd(dvz, _mm256_mul_pd(rv, dz))));
+            }
+
+            double sx = horizontalSum(ax), sy = horizontalSum(ay), sz = horizontalSum(az);
+            double tx = horizontalSum(jx), ty = horizontalSum(jy), tz = horizontalSum(jz);
+
+            for (; j < n; ++j)
+            {
+                double dx = b.x[j] - b.x[i];
+                double dy = b.y[j] - b.y[i];
+                double dz = b.z[j] - b.z[i];
+                double dvx = b.vx[j] - b.vx[i];
+                double dvy = b.vy[j] - b.vy[i];
+                double dvz = b.vz[j] - b.vz[i];
+                double dist2 = dx * dx + dy * dy + dz * dz + soften;
+                double inv3 = 1.0 / (dist2 * std::sqrt(dist2));
+
+                double f = G * b.mass[j] * inv3;
+                double rv = 3.0 * (dx * dvx + dy * dvy + dz * dvz) / dist2;
+                sx += f * dx;
+                sy += f * dy;
+                sz += f * dz;
+                tx += f * (dvx - rv * dx);
+                ty += f * (dvy - rv * dy);
+                tz += f * (dvz - rv * dz);
+            }
+
+            acc.x[i] = sx;
+            acc.y[i] = sy;
+            acc.z[i] = sz;
+            jerk.x[i] = tx;
+            jerk.y[i] = ty;
+            jerk.z[i] = tz;
+        }
+    }
+
+    SOLARSIM_TARGET("avx2")
+    size_t sourcesAvx2(const BodySoA& b, const double* x, const double* y, const double* z, size_t count,
+        double G, double soften, double* ax, double* ay, double* az)
+    {
+        size_t n = b.size();
+        const __m256d vSoft = _mm256_set1_pd(soften);
+        const __m256d one = _mm256_set1_pd(1.0);
+
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m256d xi = _mm256_loadu_pd(x + i);
+            const __m256d yi = _mm256_loadu_pd(y + i);
+            const __m256d zi = _mm256_loadu_pd(z + i);
+            __m256d sx = _mm256_setzero_pd(), sy = _mm256_setzero_pd(), sz = _mm256_setzero_pd();
+
+            for (size_t j = 0; j < n; ++j)
+            {
+                __m256d dx = _mm256_sub_pd(_mm256_set1_pd(b.x[j]), xi);
+                __m256d dy = _mm256_sub_pd(_mm256_set1_pd(b.y[j]), yi);
+                __m256d dz = _mm256_sub_pd(_mm256_set1_pd(b.z[j]), zi);
+                __m256d dist2 = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)),
+                                              _mm256_add_pd(_mm256_mul_pd(dz, dz), vSoft));
+                __m256d inv3 = _mm256_div_pd(one, _mm256_mul_pd(dist2, _mm256_sqrt_pd(dist2)));
+
+                __m256d f = _mm256_mul_pd(_mm256_set1_pd(G * b.mass[j]), inv3);
+                sx = _mm256_add_pd(sx, _mm256_mul_pd(f, dx));
+                sy = _mm256_add_pd(sy, _mm256_mul_pd(f, dy));
+                sz = _mm256_add_pd(sz, _mm256_mul_pd(f, dz));
+            }
+
+            _mm256_storeu_pd(ax + i, sx);
+            _mm256_storeu_pd(ay + i, sy);
+            _mm256_storeu_pd(az + i, sz);
+        }
+        return i;
+    }
+
+SOLARSIM_AVX512_BEGIN
+    SOLARSIM_TARGET("avx512f")
+    void sourcesAvx512(const BodySoA& b, const double* x, const double* y, const double* z, size_t count,
+        double G, double soften, double* ax, double* ay, double* az)
+    {
+        size_t n = b.size();
+        const __m512d vSoft = _mm512_set1_pd(soften);
+        const __m512d one = _mm512_set1_pd(1.0);
+
+        for (size_t i = 0; i < count; i += 8)
+        {
+            __mmask8 m = i + 8 <= count ? __mmask8(0xFF) : __mmask8((1u << (count - i)) - 1u);
+
+            const __m512d xi = _mm512_maskz_loadu_pd(m, x + i);
+            const __m512d yi = _mm512_maskz_loadu_pd(m, y + i);
+            const __m512d zi = _mm512_maskz_loadu_pd(m, z + i);
+            __m512d sx = _mm512_setzero_pd(), sy = _mm512_setzero_pd(), sz = _mm512_setzero_pd();
+
+            for (size_t j = 0; j < n; ++j)
+            {
+                __m512d dx = _mm512_sub_pd(_mm512_set1_pd(b.x[j]), xi);
+                __m512d dy = _mm512_sub_pd(_mm512_set1_pd(b.y[j]), yi);
+                __m512d dz = _mm512_sub_pd(_mm512_set1_pd(b.z[j]), zi);
+                __m512d dist2 = _mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(dx, dx), _mm512_mul_pd(dy, dy)),
+                                              _mm512_add_pd(_mm512_mul_pd(dz, dz), vSoft));
+                __m512d inv3 = _mm512_div_pd(one, _mm512_mul_pd(dist2, _mm512_sqrt_pd(dist2)));
+
+                __m512d f = _mm512_mul_pd(_mm512_set1_pd(G * b.mass[j]), inv3);
+                sx = _mm512_add_pd(sx, _mm512_mul_pd(f, dx));
+                sy = _mm512_add_pd(sy, _mm512_mul_pd(f, dy));
+                sz = _mm512_add_pd(sz, _mm512_mul_pd(f, dz));
+            }
+
+            _mm512_mask_storeu_pd(ax + i, m, sx);
+            _mm512_mask_storeu_pd(ay + i, m, sy);
+            _mm512_mask_storeu_pd(az + i, m, sz);
+        }
+    }
+SOLARSIM_AVX512_END
+#endif
+}
+
+SimdLevel detectSimdLevel()
+{
+#if defined(SOLARSIM_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || maxLeaf < 7)
+        return SimdLevel::Scalar;
+
+    unsigned long long xcr0 = _xgetbv(0);
+    __cpuidex(info, 7, 0);
+    bool avx2 = (info[1] & (1 << 5)) != 0 && (xcr0 & 0x6) == 0x6;
+    bool avx512 = (info[1] & (1 << 16)) != 0 && (xcr0 & 0xE6) == 0xE6;
+
+    if (avx512) return SimdLevel::Avx512;
+    if (avx2) return SimdLevel::Avx2;
+    return SimdLevel::Scalar;
+#elif defined(SOLARSIM_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return SimdLevel::Avx512;
+    if (__builtin_cpu_supports("avx2")) return SimdLevel::Avx2;
+    return SimdLevel::Scalar;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+const char* simdLevelName(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::Avx512: return "AVX-512";
+    case SimdLevel::Avx2:   return "AVX2";
+    default:                return "Scalar";
+    }
+}
+
+void accumulatePairwise(SimdLevel level, const BodySoA& bodies, double G, double soften, AccelerationSoA& acc)
+{
+    accumulatePairwiseRows(level, bodies, 0, 1, G, soften, acc);
+}
+
+void accumulatePairwiseRows(SimdLevel level, const BodySoA& bodies, size_t firstRow, size_t rowStride,
+    double G, double soften, AccelerationSoA& acc)
+{
+    static const SimdLevel supported = detectSimdLevel();
+    if (level > supported)
+        level = supported;
+
+#if defined(SOLARSIM_X86)
+    if (level == SimdLevel::Avx512)
+    {
+        pairwiseAvx512(bodies, firstRow, rowStride, G, soften, acc);
+        return;
+    }
+    if (level == SimdLevel::Avx2)
+    {
+        pairwiseAvx2(bodies, firstRow, rowStride, G, soften, acc);
+        return;
+    }
+#endif
+
+    pairwiseScalar(bodies, firstRow, rowStride, G, soften, acc);
+}
+
+void accumulateTargets(SimdLevel level, const BodySoA& bodies, const uint32_t* targets, size_t count,
+    double G, double soften, AccelerationSoA& acc, AccelerationSoA& jerk)
+{
+    static const SimdLevel supported = detectSimdLevel();
+    if (level > supported)
+        level = supported;
+
+    // Targets are few per call; the AVX2 kernel also serves AVX-512 machines.
+#if defined(SOLARSIM_X86)
+    if (level >= SimdLevel::Avx2)
+    {
+        targetsAvx2(bodies, targets, count, G, soften, acc, jerk);
+        return;
+    }
+#endif
+
+    targetsScalar(bodies, targets, count, G, soften, acc, jerk);
+}
+
+void accumulateSources(SimdLevel level, const BodySoA& bodies, const double* x, const double* y, const double* z,
+    size_t count, double G, double soften, double* ax, double* ay, double* az)
+{
+    static const SimdLevel supported = detectSimdLevel();
+    if (level > supported)
+        level = supported;
+
+    size_t done = 0;
+#if defined(SOLARSIM_X86)
+    if (level == SimdLevel::Avx512)
+    {
+        sourcesAvx512(bodies, x, y, z, count, G, soften, ax, ay, az);
+        return;
+    }
+    if (level == SimdLevel::Avx2)
+        done = sourcesAvx2(bodies, x, y, z, count, G, soften, ax, ay, az);
+#endif
+
+    sourcesScalar(bodies, x, y, z, done, count, G, soften, ax, ay, az);
+}
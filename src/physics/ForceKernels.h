@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include "BodySoA.h"
+
+enum class SimdLevel
+{
+    Scalar,
+    Avx2,
+    Avx512
+};
+
+// Widest instruction set the running CPU and OS support.
+SimdLevel detectSimdLevel();
+const char* simdLevelName(SimdLevel level);
+
+// Adds the acceleration of every body due to every other body to acc. Each
+// pair is evaluated once and applied to both bodies (Newton's third law).
+// Levels above what the CPU supports fall back to the widest available one.
+void accumulatePairwise(SimdLevel level, const BodySoA& bodies, double G, double soften, AccelerationSoA& acc);
+
+// Same as accumulatePairwise, restricted to the rows i = firstRow,
+// firstRow + rowStride, ...; each row covers the pairs (i, j > i).
+void accumulatePairwiseRows(SimdLevel level, const BodySoA& bodies, size_t firstRow, size_t rowStride,
+    double G, double soften, AccelerationSoA& acc);
+
+// Acceleration and jerk (da/dt) of each listed target due to all bodies,
+// written to acc and jerk at the target's index. Used by the block timestep
+// integrator, which only needs forces on the bodies whose step has ended.
+void accumulateTargets(SimdLevel level, const BodySoA& bodies, const uint32_t* targets, size_t count,
+    double G, double soften, AccelerationSoA& acc, AccelerationSoA& jerk);
+
+// Acceleration of count massless points at (x, y, z) due to all bodies,
+// overwriting ax, ay and az. The points are the vector lanes and the bodies
+// the inner loop, so the cost is count x bodies with no pair symmetry.
+void accumulateSources(SimdLevel level, const BodySoA& bodies, const double* x, const double* y, const double* z,
+    size_t count, double G, double soften, double* ax, double* ay, double* az);
@@ -0,0 +1,570 @@
+#include "Integrator.h"
+#include "Kepler.h"
+#include "StateBytes.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    void kickAll(BodySoA& b, const AccelerationSoA& acc, double dt)
+    {
+        for (size_t i = 0; i < b.size(); ++i)
+        {
+            b.vx[i] += acc.x[i] * dt;
+            b.vy[i] += acc.y[i] * dt;
+            b.vz[i] += acc.z[i] * dt;
+        }
+    }
+
+    void driftAll(BodySoA& b, double dt)
+    {
+        for (size_t i = 0; i < b.size(); ++i)
+        {
+            b.x[i] += b.vx[i] * dt;
+            b.y[i] += b.vy[i] * dt;
+            b.z[i] += b.vz[i] * dt;
+        }
+    }
+
+    bool sameColumn(const AlignedVector<double>& a, const AlignedVector<double>& b)
+    {
+        return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(double)) == 0;
+    }
+
+    // Columns that decide whether a Kepler fit still holds.
+    AlignedVector<double> BodySoA::* const STATE_COLUMNS[] = {
+        &BodySoA::x, &BodySoA::y, &BodySoA::z, &BodySoA::vx, &BodySoA::vy, &BodySoA::vz, &BodySoA::mass
+    };
+
+    // Columns a force evaluation depends on.
+    AlignedVector<double> BodySoA::* const FORCE_COLUMNS[] = {
+        &BodySoA::x, &BodySoA::y, &BodySoA::z, &BodySoA::mass
+    };
+
+    bool sameForceColumns(const BodySoA& a, const BodySoA& b)
+    {
+        for (auto column : FORCE_COLUMNS)
+            if (!sameColumn(a.*column, b.*column))
+                return false;
+        return true;
+    }
+
+    void keepForceColumns(const BodySoA& bodies, BodySoA& cachedFor)
+    {
+        for (auto column : FORCE_COLUMNS)
+            cachedFor.*column = bodies.*column;
+    }
+
+    // A cached evaluation for checkpoints: the columns it was made for, then
+    // its results. An empty or mismatched cache is simply not reused.
+    void saveCache(std::vector<uint8_t>& out, const BodySoA& cachedFor, const AccelerationSoA& acc)
+    {
+        for (auto column : FORCE_COLUMNS)
+            appendColumn(out, cachedFor.*column);
+        appendColumn(out, acc.x);
+        appendColumn(out, acc.y);
+        appendColumn(out, acc.z);
+    }
+
+    bool loadCache(const std::vector<uint8_t>& in, size_t& offset, BodySoA& cachedFor, AccelerationSoA& acc)
+    {
+        bool ok = true;
+        for (auto column : FORCE_COLUMNS)
+            ok = ok && readColumn(in, offset, cachedFor.*column);
+        ok = ok && readColumn(in, offset, acc.x) && readColumn(in, offset, acc.y) && readColumn(in, offset, acc.z);
+
+        size_t n = cachedFor.x.size();
+        return ok && cachedFor.y.size() == n && cachedFor.z.size() == n && cachedFor.mass.size() == n
+            && acc.y.size() == acc.size() && acc.z.size() == acc.size();
+    }
+
+    std::vector<double> yoshida4Weights()
+    {
+        double cbrt2 = std::cbrt(2.0);
+        double w1 = 1.0 / (2.0 - cbrt2);
+        double w0 = -cbrt2 / (2.0 - cbrt2);
+        return { w1, w0, w1 };
+    }
+
+    std::vector<double> yoshida6Weights()
+    {
+        // Yoshida (1990), solution A.
+        double w1 = -1.17767998417887;
+        double w2 = 0.235573213359357;
+        double w3 = 0.784513610477560;
+        double w0 = 1.0 - 2.0 * (w1 + w2 + w3);
+        return { w3, w2, w1, w0, w1, w2, w3 };
+    }
+}
+
+const char* integratorName(IntegratorType type)
+{
+    switch (type)
+    {
+    case IntegratorType::SemiImplicitEuler: return "Semi-implicit Euler";
+    case IntegratorType::LeapfrogKDK:       return "Leapfrog KDK";
+    case IntegratorType::Yoshida4:          return "Yoshida 4th order";
+    case IntegratorType::Yoshida6:          return "Yoshida 6th order";
+    case IntegratorType::WisdomHolman:      return "Wisdom-Holman";
+    case IntegratorType::BlockTimestep:     return "Block timesteps";
+    case IntegratorType::Kepler:            return "Kepler (analytic)";
+    }
+    return "Unknown";
+}
+
+std::unique_ptr<Integrator> makeIntegrator(IntegratorType type, const IntegratorParams& params)
+{
+    switch (type)
+    {
+    case IntegratorType::LeapfrogKDK:   return std::make_unique<CompositionIntegrator>(type, std::vector<double>{ 1.0 });
+    case IntegratorType::Yoshida4:      return std::make_unique<CompositionIntegrator>(type, yoshida4Weights());
+    case IntegratorType::Yoshida6:      return std::make_unique<CompositionIntegrator>(type, yoshida6Weights());
+    case IntegratorType::WisdomHolman:  return std::make_unique<WisdomHolmanIntegrator>(params.G);
+    case IntegratorType::BlockTimestep: return std::make_unique<BlockTimestepIntegrator>(params.blockEta);
+    case IntegratorType::Kepler:        return std::make_unique<KeplerIntegrator>(params.G, params.pool);
+    default:                            return std::make_unique<SemiImplicitEulerIntegrator>();
+    }
+}
+
+void SemiImplicitEulerIntegrator::step(BodySoA& bodies, double dt, ForceModel& forces)
+{
+    forces.computeAccelerations(bodies, acc);
+    kickAll(bodies, acc, dt);
+    driftAll(bodies, dt);
+}
+
+CompositionIntegrator::CompositionIntegrator(IntegratorType type, std::vector<double> weights)
+    : kind(type), weights(std::move(weights))
+{
+}
+
+bool CompositionIntegrator::cacheValid(const BodySoA& bodies) const
+{
+    return acc.size() == bodies.size() && sameForceColumns(cachedFor, bodies);
+}
+
+void CompositionIntegrator::step(BodySoA& bodies, double dt, ForceModel& forces)
+{
+    if (!cacheValid(bodies))
+        forces.computeAccelerations(bodies, acc);
+
+    for (double w : weights)
+    {
+        double h = w * dt;
+        kickAll(bodies, acc, 0.5 * h);
+        driftAll(bodies, h);
+        forces.computeAccelerations(bodies, acc);
+        kickAll(bodies, acc, 0.5 * h);
+    }
+
+    keepForceColumns(bodies, cachedFor);
+}
+
+bool WisdomHolmanIntegrator::cacheValid(const BodySoA& bodies) const
+{
+    return acc.size() + 1 == bodies.size() && sameForceColumns(cachedFor, bodies);
+}
+
+void WisdomHolmanIntegrator::step(BodySoA& bodies, double dt, ForceModel& forces)
+{
+    size_t n = bodies.size();
+    if (n < 2)
+    {
+        driftAll(bodies, dt);
+        return;
+    }
+
+    size_t central = static_cast<size_t>(std::max_element(bodies.mass.begin(), bodies.mass.end()) - bodies.mass.begin());
+    double m0 = bodies.mass[central];
+
+    double     totalMass = 0.0;
+    glm::dvec3 com(0.0), vcm(0.0);
+    for (size_t i = 0; i < n; ++i)
+    {
+        totalMass += bodies.mass[i];
+        com += bodies.mass[i] * glm::dvec3(bodies.x[i], bodies.y[i], bodies.z[i]);
+        vcm += bodies.mass[i] * glm::dvec3(bodies.vx[i], bodies.vy[i], bodies.vz[i]);
+    }
+    com /= totalMass;
+    vcm /= totalMass;
+
+    // Heliocentric positions, barycentric velocities.
+    planets.resize(n - 1);
+    for (size_t i = 0, k = 0; i < n; ++i)
+    {
+        if (i == central) continue;
+
+        planets.x[k] = bodies.x[i] - bodies.x[central];
+        planets.y[k] = bodies.y[i] - bodies.y[central];
+        planets.z[k] = bodies.z[i] - bodies.z[central];
+        planets.vx[k] = bodies.vx[i] - vcm.x;
+        planets.vy[k] = bodies.vy[i] - vcm.y;
+        planets.vz[k] = bodies.vz[i] - vcm.z;
+        planets.mass[k] = bodies.mass[i];
+        ++k;
+    }
+
+    // The last closing kick was evaluated at these positions, up to the
+    // rounding of the change of frame.
+    if (!cacheValid(bodies))
+        forces.computeAccelerations(planets, acc);
+    kickAll(planets, acc, 0.5 * dt);
+    jump(0.5 * dt, m0);
+
+    double mu = G * m0;
+    for (size_t k = 0; k < planets.size(); ++k)
+    {
+        glm::dvec3 r(planets.x[k], planets.y[k], planets.z[k]);
+        glm::dvec3 v(planets.vx[k], planets.vy[k], planets.vz[k]);
+        keplerDrift(r, v, mu, dt);
+
+        planets.x[k] = r.x;  planets.y[k] = r.y;  planets.z[k] = r.z;
+        planets.vx[k] = v.x; planets.vy[k] = v.y; planets.vz[k] = v.z;
+    }
+
+    jump(0.5 * dt, m0);
+    kick(0.5 * dt, forces);
+
+    // Back to barycentric-frame positions and velocities.
+    com += vcm * dt;
+
+    glm::dvec3 weightedPos(0.0), weightedVel(0.0);
+    for (size_t k = 0; k < planets.size(); ++k)
+    {
+        weightedPos += planets.mass[k] * glm::dvec3(planets.x[k], planets.y[k], planets.z[k]);
+        weightedVel += planets.mass[k] * glm::dvec3(planets.vx[k], planets.vy[k], planets.vz[k]);
+    }
+
+    glm::dvec3 centralPos = com - weightedPos / totalMass;
+    glm::dvec3 centralVel = vcm - weightedVel / m0;
+
+    bodies.x[central] = centralPos.x;
+    bodies.y[central] = centralPos.y;
+    bodies.z[central] = centralPos.z;
+    bodies.vx[central] = centralVel.x;
+    bodies.vy[central] = centralVel.y;
+    bodies.vz[central] = centralVel.z;
+
+    for (size_t i = 0, k = 0; i < n; ++i)
+    {
+        if (i == central) continue;
+
+        bodies.x[i] = planets.x[k] + centralPos.x;
+        bodies.y[i] = planets.y[k] + centralPos.y;
+        bodies.z[i] = planets.z[k] + centralPos.z;
+        bodies.vx[i] = planets.vx[k] + vcm.x;
+        bodies.vy[i] = planets.vy[k] + vcm.y;
+        bodies.vz[i] = planets.vz[k] + vcm.z;
+        ++k;
+    }
+
+    keepForceColumns(bodies, cachedFor);
+}
+
+void WisdomHolmanIntegrator::saveState(std::vector<uint8_t>& out) const
+{
+    out.clear();
+    if (cachedFor.size() > 0)
+        saveCache(out, cachedFor, acc);
+}
+
+bool WisdomHolmanIntegrator::loadState(const std::vector<uint8_t>& in)
+{
+    cachedFor = BodySoA();
+    size_t offset = 0;
+    if (in.empty() || (loadCache(in, offset, cachedFor, acc) && offset == in.size()))
+        return true;
+
+    cachedFor = BodySoA();
+    return false;
+}
+
+void WisdomHolmanIntegrator::kick(double dt, ForceModel& forces)
+{
+    // Interactions between the non-central bodies only; the central mass is
+    // handled exactly by the Kepler drift.
+    forces.computeAccelerations(planets, acc);
+    kickAll(planets, acc, dt);
+}
+
+void WisdomHolmanIntegrator::jump(double dt, double centralMass)
+{
+    glm::dvec3 momentum(0.0);
+    for (size_t k = 0; k < planets.size(); ++k)
+        momentum += planets.mass[k] * glm::dvec3(planets.vx[k], planets.vy[k], planets.vz[k]);
+
+    glm::dvec3 shift = momentum / centralMass * dt;
+    for (size_t k = 0; k < planets.size(); ++k)
+    {
+        planets.x[k] += shift.x;
+        planets.y[k] += shift.y;
+        planets.z[k] += shift.z;
+    }
+}
+
+bool BlockTimestepIntegrator::cacheValid(const BodySoA& bodies) const
+{
+    return acc.size() == bodies.size() && jerk.size() == bodies.size() && sameForceColumns(cachedFor, bodies);
+}
+
+int BlockTimestepIntegrator::levelFor(size_t i, double dt) const
+{
+    double a = std::sqrt(acc.x[i] * acc.x[i] + acc.y[i] * acc.y[i] + acc.z[i] * acc.z[i]);
+    double j = std::sqrt(jerk.x[i] * jerk.x[i] + jerk.y[i] * jerk.y[i] + jerk.z[i] * jerk.z[i]);
+    if (j <= 0.0 || a <= 0.0)
+        return 0;
+
+    double ideal = eta * a / j;
+    if (ideal >= dt)
+        return 0;
+
+    int level = static_cast<int>(std::ceil(std::log2(dt / ideal)));
+    return std::clamp(level, 0, MAX_LEVEL);
+}
+
+void BlockTimestepIntegrator::step(BodySoA& bodies, double dt, ForceModel& forces)
+{
+    size_t n = bodies.size();
+    const uint64_t ticks = uint64_t(1) << MAX_LEVEL;
+    const double   tickDt = dt / static_cast<double>(ticks);
+
+    auto stepTicks = [](int level) { return uint64_t(1) << (MAX_LEVEL - level); };
+
+    // Every body is synchronized at the start of the outer step.
+    active.resize(n);
+    for (size_t i = 0; i < n; ++i)
+        active[i] = static_cast<uint32_t>(i);
+
+    if (!cacheValid(bodies))
+    {
+        acc.reset(n);
+        jerk.reset(n);
+        forces.computeTargetForces(bodies, active, acc, jerk);
+    }
+
+    levels.resize(n);
+    for (size_t i = 0; i < n; ++i)
+        levels[i] = static_cast<uint8_t>(levelFor(i, dt));
+
+    deepestLevel = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        double half = 0.5 * stepTicks(levels[i]) * tickDt;
+        bodies.vx[i] += acc.x[i] * half;
+        bodies.vy[i] += acc.y[i] * half;
+        bodies.vz[i] += acc.z[i] * half;
+        deepestLevel = std::max(deepestLevel, static_cast<int>(levels[i]));
+    }
+
+    uint64_t now = 0;
+    while (now < ticks)
+    {
+        int finest = 0;
+        for (size_t i = 0; i < n; ++i)
+            finest = std::max(finest, static_cast<int>(levels[i]));
+
+        uint64_t next = now + stepTicks(finest);
+        double   h = static_cast<double>(next - now) * tickDt;
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            bodies.x[i] += bodies.vx[i] * h;
+            bodies.y[i] += bodies.vy[i] * h;
+            bodies.z[i] += bodies.vz[i] * h;
+        }
+
+        active.clear();
+        for (size_t i = 0; i < n; ++i)
+            if (next % stepTicks(levels[i]) == 0)
+                active.push_back(static_cast<uint32_t>(i));
+
+        forces.computeTargetForces(bodies, active, acc, jerk);
+
+        for (uint32_t i : active)
+        {
+            double half = 0.5 * stepTicks(levels[i]) * tickDt;
+            bodies.vx[i] += acc.x[i] * half;
+            bodies.vy[i] += acc.y[i] * half;
+            bodies.vz[i] += acc.z[i] * half;
+        }
+
+        now = next;
+        if (now == ticks)
+            break;
+
+        // New block for the bodies that just closed theirs, then the opening kick.
+        for (uint32_t i : active)
+        {
+            int current = levels[i];
+            int wanted = levelFor(i, dt);
+
+            if (wanted < current)
+            {
+                int coarser = current - 1;
+                wanted = (now % stepTicks(coarser) == 0) ? coarser : current;
+            }
+
+            levels[i] = static_cast<uint8_t>(wanted);
+            deepestLevel = std::max(deepestLevel, wanted);
+
+            double half = 0.5 * stepTicks(wanted) * tickDt;
+            bodies.vx[i] += acc.x[i] * half;
+            bodies.vy[i] += acc.y[i] * half;
+            bodies.vz[i] += acc.z[i] * half;
+        }
+    }
+
+    keepForceColumns(bodies, cachedFor);
+}
+
+void BlockTimestepIntegrator::saveState(std::vector<uint8_t>& out) const
+{
+    out.clear();
+    if (cachedFor.size() == 0)
+        return;
+
+    saveCache(out, cachedFor, acc);
+    appendColumn(out, jerk.x);
+    appendColumn(out, jerk.y);
+    appendColumn(out, jerk.z);
+}
+
+bool BlockTimestepIntegrator::loadState(const std::vector<uint8_t>& in)
+{
+    cachedFor = BodySoA();
+    if (in.empty())
+        return true;
+
+    size_t offset = 0;
+    bool ok = loadCache(in, offset, cachedFor, acc) && readColumn(in, offset, jerk.x)
+        && readColumn(in, offset, jerk.y) && readColumn(in, offset, jerk.z);
+    if (ok && offset == in.size() && jerk.x.size() == acc.size() && jerk.y.size() == acc.size() && jerk.z.size() == acc.size())
+        return true;
+
+    cachedFor = BodySoA();
+    return false;
+}
+
+KeplerIntegrator::KeplerIntegrator(double G, ThreadPool* pool)
+    : G(G)
+{
+    orbits.pool = pool;
+}
+
+bool KeplerIntegrator::cacheValid(const BodySoA& bodies) const
+{
+    return sameColumn(cachedFor.x, bodies.x) && sameColumn(cachedFor.y, bodies.y) && sameColumn(cachedFor.z, bodies.z)
+        && sameColumn(cachedFor.vx, bodies.vx) && sameColumn(cachedFor.vy, bodies.vy) && sameColumn(cachedFor.vz, bodies.vz)
+        && sameColumn(cachedFor.mass, bodies.mass);
+}
+
+void KeplerIntegrator::fit(const BodySoA& bodies)
+{
+    size_t n = bodies.size();
+    central = static_cast<size_t>(std::max_element(bodies.mass.begin(), bodies.mass.end()) - bodies.mass.begin());
+    centralPos = glm::dvec3(bodies.x[central], bodies.y[central], bodies.z[central]);
+    centralVel = glm::dvec3(bodies.vx[central], bodies.vy[central], bodies.vz[central]);
+    elapsed = 0.0;
+
+    orbits.clear();
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (i == central)
+            continue;
+
+        glm::dvec3 r = glm::dvec3(bodies.x[i], bodies.y[i], bodies.z[i]) - centralPos;
+        glm::dvec3 v = glm::dvec3(bodies.vx[i], bodies.vy[i], bodies.vz[i]) - centralVel;
+        orbits.add(r, v, G * (bodies.mass[central] + bodies.mass[i]));
+    }
+
+    relative.resize(n - 1);
+}
+
+void KeplerIntegrator::step(BodySoA& bodies, double dt, ForceModel&)
+{
+    size_t n = bodies.size();
+    if (n < 2)
+    {
+        driftAll(bodies, dt);
+        return;
+    }
+
+    if (!cacheValid(bodies))
+        fit(bodies);
+
+    elapsed += dt;
+    orbits.evaluate(elapsed, relative.x.data(), relative.y.data(), relative.z.data(),
+        relative.vx.data(), relative.vy.data(), relative.vz.data());
+
+    glm::dvec3 origin = centralPos + centralVel * elapsed;
+    for (size_t i = 0, k = 0; i < n; ++i)
+    {
+        if (i == central)
+        {
+            bodies.x[i] = origin.x;  bodies.y[i] = origin.y;  bodies.z[i] = origin.z;
+            bodies.vx[i] = centralVel.x; bodies.vy[i] = centralVel.y; bodies.vz[i] = centralVel.z;
+            continue;
+        }
+
+        bodies.x[i] = origin.x + relative.x[k];
+        bodies.y[i] = origin.y + relative.y[k];
+        bodies.z[i] = origin.z + relative.z[k];
+        bodies.vx[i] = centralVel.x + relative.vx[k];
+        bodies.vy[i] = centralVel.y + relative.vy[k];
+        bodies.vz[i] = centralVel.z + relative.vz[k];
+        ++k;
+    }
+
+    cachedFor.x = bodies.x;
+    cachedFor.y = bodies.y;
+    cachedFor.z = bodies.z;
+    cachedFor.vx = bodies.vx;
+    cachedFor.vy = bodies.vy;
+    cachedFor.vz = bodies.vz;
+    cachedFor.mass = bodies.mass;
+}
+
+void KeplerIntegrator::saveState(std::vector<uint8_t>& out) const
+{
+    out.clear();
+    if (cachedFor.size() == 0)
+        return;
+
+    appendValue(out, static_cast<uint64_t>(central));
+    appendValue(out, centralPos);
+    appendValue(out, centralVel);
+    appendValue(out, elapsed);
+    orbits.save(out);
+    for (auto column : STATE_COLUMNS)
+        appendColumn(out, cachedFor.*column);
+}
+
+bool KeplerIntegrator::loadState(const std::vector<uint8_t>& in)
+{
+    cachedFor = BodySoA();
+    if (in.empty())
+        return true;
+
+    uint64_t centre = 0;
+    size_t offset = 0;
+    BodySoA last;
+    bool ok = readValue(in, offset, centre) && readValue(in, offset, centralPos) && readValue(in, offset, centralVel)
+        && readValue(in, offset, elapsed) && orbits.load(in, offset);
+    for (auto column : STATE_COLUMNS)
+        ok = ok && readColumn(in, offset, last.*column);
+
+    size_t n = orbits.size() + 1;
+    if (!ok || offset != in.size() || centre >= n || last.x.size() != n || last.y.size() != n || last.z.size() != n
+        || last.vx.size() != n || last.vy.size() != n || last.vz.size() != n || last.mass.size() != n)
+    {
+        orbits.clear();
+        return false;
+    }
+
+    central = static_cast<size_t>(centre);
+    relative.resize(n - 1);
+    for (auto column : STATE_COLUMNS)
+        cachedFor.*column = std::move(last.*column);
+    return true;
+}
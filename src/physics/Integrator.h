@@ -0,0 +1,192 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "BodySoA.h"
+#include "Kepler.h"
+
+class ThreadPool;
+
+enum class IntegratorType
+{
+    SemiImplicitEuler,
+    LeapfrogKDK,
+    Yoshida4,
+    Yoshida6,
+    WisdomHolman,
+    BlockTimestep,
+    Kepler
+};
+
+constexpr int INTEGRATOR_COUNT = 7;
+const char* integratorName(IntegratorType type);
+
+// Source of gravitational forces for the integrators; implemented by PhysicsSystem.
+class ForceModel
+{
+public:
+    virtual ~ForceModel() = default;
+
+    // Accelerations of all bodies; acc is resized and overwritten.
+    virtual void computeAccelerations(const BodySoA& bodies, AccelerationSoA& acc) = 0;
+
+    // Acceleration and jerk of the listed bodies due to all bodies. Results are
+    // written at the listed indices of acc and jerk, which must be sized already.
+    virtual void computeTargetForces(const BodySoA& bodies, const std::vector<uint32_t>& targets,
+        AccelerationSoA& acc, AccelerationSoA& jerk) = 0;
+};
+
+class Integrator
+{
+public:
+    virtual ~Integrator() = default;
+
+    virtual IntegratorType type() const = 0;
+    virtual void step(BodySoA& bodies, double dt, ForceModel& forces) = 0;
+
+    // What a step carries over to the next one besides the bodies, for
+    // checkpoints. Loaded into a new integrator of the same type, it makes
+    // the next step bit-identical to the one the saving instance would take.
+    // Caches that are rebuilt exactly from the bodies are not included.
+    virtual void saveState(std::vector<uint8_t>& out) const { out.clear(); }
+    virtual bool loadState(const std::vector<uint8_t>& in) { return in.empty(); }
+};
+
+struct IntegratorParams
+{
+    double G = 6.67430e-11;
+    double blockEta = 0.02;   // Aarseth accuracy parameter for block timesteps
+    ThreadPool* pool = nullptr;
+};
+
+std::unique_ptr<Integrator> makeIntegrator(IntegratorType type, const IntegratorParams& params);
+
+// First order: v += a dt, then x += v dt. The original PhysicsSystem step.
+class SemiImplicitEulerIntegrator : public Integrator
+{
+public:
+    IntegratorType type() const override { return IntegratorType::SemiImplicitEuler; }
+    void step(BodySoA& bodies, double dt, ForceModel& forces) override;
+
+private:
+    AccelerationSoA acc;
+};
+
+// Kick-drift-kick leapfrog stages with the given weights. One weight is the
+// plain second order leapfrog; Yoshida's symmetric weights give 4th and 6th
+// order. The closing acceleration of a step is reused for the next one while
+// the positions and masses are unchanged.
+class CompositionIntegrator : public Integrator
+{
+public:
+    CompositionIntegrator(IntegratorType type, std::vector<double> weights);
+
+    IntegratorType type() const override { return kind; }
+    void step(BodySoA& bodies, double dt, ForceModel& forces) override;
+
+private:
+    IntegratorType kind;
+    std::vector<double> weights;
+    AccelerationSoA acc;
+    BodySoA cachedFor;
+
+    bool cacheValid(const BodySoA& bodies) const;
+};
+
+// Wisdom-Holman map in democratic heliocentric coordinates: the most massive
+// body is the central mass, each other body follows an exact Kepler drift
+// around it, and the mutual interactions are applied as kicks. The closing
+// kick's accelerations are reused for the next opening kick while the
+// positions and masses are unchanged.
+class WisdomHolmanIntegrator : public Integrator
+{
+public:
+    explicit WisdomHolmanIntegrator(double G) : G(G) {}
+
+    IntegratorType type() const override { return IntegratorType::WisdomHolman; }
+    void step(BodySoA& bodies, double dt, ForceModel& forces) override;
+
+    // The reused accelerations: they were evaluated before the change back
+    // to barycentric coordinates, so re-evaluating would differ by rounding.
+    void saveState(std::vector<uint8_t>& out) const override;
+    bool loadState(const std::vector<uint8_t>& in) override;
+
+private:
+    double G;
+    BodySoA planets;
+    AccelerationSoA acc;
+    BodySoA cachedFor;
+
+    bool cacheValid(const BodySoA& bodies) const;
+    void kick(double dt, ForceModel& forces);
+    void jump(double dt, double centralMass);
+};
+
+// Hierarchical (block) timesteps. Every body gets its own power-of-two
+// fraction of the outer step, chosen from dt_i = eta |a| / |jerk|. Between
+// substeps all bodies drift, but only the bodies whose own step ends there
+// get a force evaluation and a kick. Levels may always get finer, and get
+// coarser by one at a time once the body is aligned with the coarser block.
+// Every body is evaluated at the end of an outer step, and that evaluation
+// opens the next one while the positions and masses are unchanged.
+class BlockTimestepIntegrator : public Integrator
+{
+public:
+    explicit BlockTimestepIntegrator(double eta) : eta(eta) {}
+
+    IntegratorType type() const override { return IntegratorType::BlockTimestep; }
+    void step(BodySoA& bodies, double dt, ForceModel& forces) override;
+
+    // The reused evaluation; its jerk saw the velocities before the closing
+    // kick, so re-evaluating would not give the same levels.
+    void saveState(std::vector<uint8_t>& out) const override;
+    bool loadState(const std::vector<uint8_t>& in) override;
+
+    static constexpr int MAX_LEVEL = 16;
+
+    int maxLevel() const { return deepestLevel; }
+
+private:
+    double eta;
+    int deepestLevel = 0;
+    std::vector<uint8_t> levels;
+    std::vector<uint32_t> active;
+    AccelerationSoA acc;
+    AccelerationSoA jerk;
+    BodySoA cachedFor;
+
+    bool cacheValid(const BodySoA& bodies) const;
+
+    int levelFor(size_t i, double dt) const;
+};
+
+// Closed-form two-body motion for fast time-warp: the most massive body
+// drifts in a straight line and every other body follows the Kepler orbit
+// it has around it; mutual pulls are ignored and no forces are evaluated.
+// The orbits are fitted whenever the bodies were changed by anything else
+// (another integrator, an edit, a merge) and then evaluated at the time
+// since that fit, so a step costs O(N) for any dt.
+class KeplerIntegrator : public Integrator
+{
+public:
+    KeplerIntegrator(double G, ThreadPool* pool);
+
+    IntegratorType type() const override { return IntegratorType::Kepler; }
+    void step(BodySoA& bodies, double dt, ForceModel& forces) override;
+
+    // The fitted orbits, the time since the fit and the last result.
+    void saveState(std::vector<uint8_t>& out) const override;
+    bool loadState(const std::vector<uint8_t>& in) override;
+
+private:
+    double G;
+    KeplerOrbits orbits;
+    size_t central = 0;
+    glm::dvec3 centralPos, centralVel;
+    double elapsed = 0.0;
+    BodySoA relative;   // orbit states around the central body
+    BodySoA cachedFor;
+
+    bool cacheValid(const BodySoA& bodies) const;
+    void fit(const BodySoA& bodies);
+};
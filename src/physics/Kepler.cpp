@@ -0,0 +1,330 @@
+#define _USE_MATH_DEFINES
+#include "Kepler.h"
+#include "StateBytes.h"
+#include "core/Profiler.h"
+#include "core/ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // Stumpff functions C(z) and S(z); series near zero avoid cancellation.
+    void stumpff(double z, double& c, double& s)
+    {
+        if (std::abs(z) < 1e-3)
+        {
+            c = 1.0 / 2.0 - z / 24.0 + z * z / 720.0 - z * z * z / 40320.0;
+            s = 1.0 / 6.0 - z / 120.0 + z * z / 5040.0 - z * z * z / 362880.0;
+        }
+        else if (z > 0.0)
+        {
+            double sz = std::sqrt(z);
+            c = (1.0 - std::cos(sz)) / z;
+            s = (sz - std::sin(sz)) / (sz * z);
+        }
+        else
+        {
+            double sz = std::sqrt(-z);
+            c = (std::cosh(sz) - 1.0) / -z;
+            s = (std::sinh(sz) - sz) / (sz * -z);
+        }
+    }
+
+    // Taylor series, accurate to rounding for |x| <= 1.
+    inline double sinSmall(double x)
+    {
+        double x2 = x * x;
+        return x * (1.0 + x2 * (-1.0 / 6.0 + x2 * (1.0 / 120.0 + x2 * (-1.0 / 5040.0 + x2 * (1.0 / 362880.0
+            + x2 * (-1.0 / 39916800.0 + x2 * (1.0 / 6227020800.0 + x2 * (-1.0 / 1307674368000.0
+            + x2 * (1.0 / 355687428096000.0)))))))));
+    }
+
+    inline double cosSmall(double x)
+    {
+        double x2 = x * x;
+        return 1.0 + x2 * (-1.0 / 2.0 + x2 * (1.0 / 24.0 + x2 * (-1.0 / 720.0 + x2 * (1.0 / 40320.0
+            + x2 * (-1.0 / 3628800.0 + x2 * (1.0 / 479001600.0 + x2 * (-1.0 / 87178291200.0
+            + x2 * (1.0 / 20922789888000.0 + x2 * (-1.0 / 6402373705728000.0)))))))));
+    }
+}
+
+void keplerDrift(glm::dvec3& r, glm::dvec3& v, double mu, double dt)
+{
+    double r0 = glm::length(r);
+    if (r0 <= 0.0 || mu <= 0.0 || dt == 0.0)
+    {
+        r += v * dt;
+        return;
+    }
+
+    double sqrtMu = std::sqrt(mu);
+    double vr0 = glm::dot(r, v) / r0;
+    double alpha = 2.0 / r0 - glm::dot(v, v) / mu;
+
+    // Whole periods of a bound orbit change nothing; dropping them keeps the
+    // Newton iteration close to its starting guess.
+    if (alpha > 0.0)
+    {
+        double period = 2.0 * M_PI / (sqrtMu * alpha * std::sqrt(alpha));
+        dt = std::fmod(dt, period);
+    }
+
+    double chi = alpha > 0.0 ? sqrtMu * alpha * dt : sqrtMu * dt / r0;
+    double c = 0.5, s = 1.0 / 6.0, z = 0.0;
+
+    for (int iter = 0; iter < 64; ++iter)
+    {
+        z = alpha * chi * chi;
+        stumpff(z, c, s);
+
+        double chi2 = chi * chi;
+        double f = r0 * vr0 / sqrtMu * chi2 * c + (1.0 - alpha * r0) * chi2 * chi * s + r0 * chi - sqrtMu * dt;
+        double df = r0 * vr0 / sqrtMu * chi * (1.0 - z * s) + (1.0 - alpha * r0) * chi2 * c + r0;
+        double delta = f / df;
+
+        chi -= delta;
+        if (std::abs(delta) <= 1e-13 * std::max(1.0, std::abs(chi)))
+            break;
+    }
+
+    z = alpha * chi * chi;
+    stumpff(z, c, s);
+
+    double chi2 = chi * chi;
+    double f = 1.0 - chi2 / r0 * c;
+    double g = dt - chi2 * chi / sqrtMu * s;
+
+    glm::dvec3 r1 = f * r + g * v;
+    double     rn = glm::length(r1);
+    double     fdot = sqrtMu / (rn * r0) * (z * s - 1.0) * chi;
+    double     gdot = 1.0 - chi2 / rn * c;
+
+    v = fdot * r + gdot * v;
+    r = r1;
+}
+
+void elementsToState(const OrbitalElements& elements, double mu, glm::dvec3& r, glm::dvec3& v)
+{
+    double a = elements.semiMajorAxis_m;
+    double e = elements.eccentricity;
+
+    // Kepler's equation M = E - e sin E by Newton's method.
+    double M = std::remainder(elements.meanAnomaly_rad, 2.0 * M_PI);
+    double E = e < 0.8 ? M : M_PI;
+    for (int k = 0; k < 30; ++k)
+    {
+        double delta = (E - e * std::sin(E) - M) / (1.0 - e * std::cos(E));
+        E -= delta;
+        if (std::abs(delta) < 1e-14)
+            break;
+    }
+
+    double cosE = std::cos(E), sinE = std::sin(E);
+    double root = std::sqrt(1.0 - e * e);
+    double distance = a * (1.0 - e * cosE);
+    double speed = std::sqrt(mu * a) / distance;
+
+    // Perifocal frame: x towards periapsis, z along the angular momentum.
+    glm::dvec3 rp(a * (cosE - e), a * root * sinE, 0.0);
+    glm::dvec3 vp(-speed * sinE, speed * root * cosE, 0.0);
+
+    double cO = std::cos(elements.ascendingNode_rad), sO = std::sin(elements.ascendingNode_rad);
+    double ci = std::cos(elements.inclination_rad), si = std::sin(elements.inclination_rad);
+    double cw = std::cos(elements.argumentOfPeriapsis_rad), sw = std::sin(elements.argumentOfPeriapsis_rad);
+
+    glm::dmat3 rotation(
+        glm::dvec3(cO * cw - sO * sw * ci, sO * cw + cO * sw * ci, sw * si),
+        glm::dvec3(-cO * sw - sO * cw * ci, -sO * sw + cO * cw * ci, cw * si),
+        glm::dvec3(sO * si, -cO * si, ci));
+
+    // Reference frame (x, y, z) to scenario axes (x, -z, y).
+    glm::dvec3 rr = rotation * rp;
+    glm::dvec3 vr = rotation * vp;
+    r = glm::dvec3(rr.x, -rr.z, rr.y);
+    v = glm::dvec3(vr.x, -vr.z, vr.y);
+}
+
+void KeplerOrbits::clear()
+{
+    for (std::vector<double>* column : { &a, &e, &root, &n, &meanAnomaly, &speed, &px, &py, &pz, &qx, &qy, &qz })
+        column->clear();
+    unbound.clear();
+}
+
+void KeplerOrbits::save(std::vector<uint8_t>& out) const
+{
+    for (const std::vector<double>* column : { &a, &e, &root, &n, &meanAnomaly, &speed, &px, &py, &pz, &qx, &qy, &qz })
+        appendColumn(out, *column);
+
+    appendValue(out, static_cast<uint64_t>(unbound.size()));
+    for (const Unbound& orbit : unbound)
+    {
+        appendValue(out, orbit.index);
+        appendValue(out, orbit.r);
+        appendValue(out, orbit.v);
+        appendValue(out, orbit.mu);
+    }
+}
+
+bool KeplerOrbits::load(const std::vector<uint8_t>& in, size_t& offset)
+{
+    clear();
+    for (std::vector<double>* column : { &a, &e, &root, &n, &meanAnomaly, &speed, &px, &py, &pz, &qx, &qy, &qz })
+    {
+        if (!readColumn(in, offset, *column) || column->size() != a.size())
+            return false;
+    }
+
+    uint64_t count = 0;
+    if (!readValue(in, offset, count) || count > a.size())
+        return false;
+    unbound.resize(static_cast<size_t>(count));
+    for (Unbound& orbit : unbound)
+    {
+        if (!readValue(in, offset, orbit.index) || !readValue(in, offset, orbit.r)
+            || !readValue(in, offset, orbit.v) || !readValue(in, offset, orbit.mu) || orbit.index >= a.size())
+            return false;
+    }
+    return true;
+}
+
+void KeplerOrbits::add(const glm::dvec3& r, const glm::dvec3& v, double mu)
+{
+    uint32_t index = static_cast<uint32_t>(size());
+    for (std::vector<double>* column : { &a, &e, &root, &n, &meanAnomaly, &speed, &px, &py, &pz, &qx, &qy, &qz })
+        column->push_back(0.0);
+
+    double distance = glm::length(r);
+    double alpha = distance > 0.0 && mu > 0.0 ? 2.0 / distance - glm::dot(v, v) / mu : 0.0;
+    glm::dvec3 h = glm::cross(r, v);
+    glm::dvec3 eccentricity = distance > 0.0 && mu > 0.0 ? glm::cross(v, h) / mu - r / distance : glm::dvec3(0.0);
+    double ecc = glm::length(eccentricity);
+
+    if (alpha <= 0.0 || ecc >= MAX_ECCENTRICITY || glm::length(h) <= 0.0)
+    {
+        // The columns still get evaluated; a unit circle at zero speed is harmless.
+        a[index] = 1.0;
+        root[index] = 1.0;
+        unbound.push_back({ index, r, v, mu });
+        return;
+    }
+
+    double semiMajor = 1.0 / alpha;
+    double sqrtMuA = std::sqrt(mu * semiMajor);
+
+    // A circular orbit has no periapsis; measure from the current position.
+    glm::dvec3 P = ecc > 0.0 ? eccentricity / ecc : r / distance;
+    glm::dvec3 Q = glm::normalize(glm::cross(h, P));
+    double E = ecc > 0.0 ? std::atan2(glm::dot(r, v) / sqrtMuA, 1.0 - distance / semiMajor) : 0.0;
+
+    a[index] = semiMajor;
+    e[index] = ecc;
+    root[index] = std::sqrt(1.0 - ecc * ecc);
+    n[index] = std::sqrt(mu * alpha * alpha * alpha);
+    meanAnomaly[index] = E - ecc * std::sin(E);
+    speed[index] = sqrtMuA;
+    px[index] = P.x; py[index] = P.y; pz[index] = P.z;
+    qx[index] = Q.x; qy[index] = Q.y; qz[index] = Q.z;
+}
+
+void KeplerOrbits::evaluate(double t, double* x, double* y, double* z, double* vx, double* vy, double* vz) const
+{
+    PROFILE_SCOPE("kepler.evaluate");
+
+    auto range = [&](size_t begin, size_t end) { evaluateRange(t, begin, end, x, y, z, vx, vy, vz); };
+
+    if (pool && size() > GRAIN)
+        pool->parallelFor(size(), GRAIN, range);
+    else
+        range(0, size());
+
+    for (const Unbound& orbit : unbound)
+    {
+        glm::dvec3 r = orbit.r, v = orbit.v;
+        keplerDrift(r, v, orbit.mu, t);
+        x[orbit.index] = r.x; y[orbit.index] = r.y; z[orbit.index] = r.z;
+        vx[orbit.index] = v.x; vy[orbit.index] = v.y; vz[orbit.index] = v.z;
+    }
+}
+
+// Each pass is a plain loop over one block of orbits so that it vectorizes;
+// only the first calls into libm.
+void KeplerOrbits::evaluateRange(double t, size_t begin, size_t end,
+    double* x, double* y, double* z, double* vx, double* vy, double* vz) const
+{
+    constexpr size_t BLOCK = 256;
+    constexpr double TWO_PI = 2.0 * M_PI;
+    double sinM[BLOCK], cosM[BLOCK], dx[BLOCK], sinE[BLOCK], cosE[BLOCK];
+
+    for (size_t first = begin; first < end; first += BLOCK)
+    {
+        size_t count = std::min(BLOCK, end - first);
+        const double* A = a.data() + first;
+        const double* ecc = e.data() + first;
+        const double* R = root.data() + first;
+        const double* N = n.data() + first;
+        const double* M0 = meanAnomaly.data() + first;
+        const double* S = speed.data() + first;
+
+        for (size_t k = 0; k < count; ++k)
+        {
+            double M = M0[k] + N[k] * t;
+            M -= TWO_PI * std::floor(M / TWO_PI + 0.5);
+            sinM[k] = std::sin(M);
+            cosM[k] = std::cos(M);
+        }
+
+        // Newton on x = E - M, which always lies in [-e, e].
+        for (size_t k = 0; k < count; ++k)
+        {
+            double d = ecc[k] * sinM[k] / (1.0 - ecc[k] * cosM[k]);
+            dx[k] = d > ecc[k] ? ecc[k] : (d < -ecc[k] ? -ecc[k] : d);
+        }
+        for (int iter = 0; iter < ITERATIONS; ++iter)
+        {
+            for (size_t k = 0; k < count; ++k)
+            {
+                double s = sinSmall(dx[k]), c = cosSmall(dx[k]);
+                double se = sinM[k] * c + cosM[k] * s;
+                double ce = cosM[k] * c - sinM[k] * s;
+                double d = dx[k] - (dx[k] - ecc[k] * se) / (1.0 - ecc[k] * ce);
+                dx[k] = d > ecc[k] ? ecc[k] : (d < -ecc[k] ? -ecc[k] : d);
+            }
+        }
+        for (size_t k = 0; k < count; ++k)
+        {
+            double s = sinSmall(dx[k]), c = cosSmall(dx[k]);
+            sinE[k] = sinM[k] * c + cosM[k] * s;
+            cosE[k] = cosM[k] * c - sinM[k] * s;
+        }
+
+        const double* Px = px.data() + first;
+        const double* Py = py.data() + first;
+        const double* Pz = pz.data() + first;
+        const double* Qx = qx.data() + first;
+        const double* Qy = qy.data() + first;
+        const double* Qz = qz.data() + first;
+        double* X = x + first;
+        double* Y = y + first;
+        double* Z = z + first;
+        double* VX = vx + first;
+        double* VY = vy + first;
+        double* VZ = vz + first;
+
+        for (size_t k = 0; k < count; ++k)
+        {
+            double u = A[k] * (cosE[k] - ecc[k]);
+            double w = A[k] * R[k] * sinE[k];
+            double scale = S[k] / (A[k] * (1.0 - ecc[k] * cosE[k]));
+            double du = -scale * sinE[k];
+            double dw = scale * R[k] * cosE[k];
+
+            X[k] = u * Px[k] + w * Qx[k];
+            Y[k] = u * Py[k] + w * Qy[k];
+            Z[k] = u * Pz[k] + w * Qz[k];
+            VX[k] = du * Px[k] + dw * Qx[k];
+            VY[k] = du * Py[k] + dw * Qy[k];
+            VZ[k] = du * Pz[k] + dw * Qz[k];
+        }
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Advances a two-body relative orbit (r, v) around gravitational parameter mu
+// by dt seconds using universal variables, so elliptic, parabolic and
+// hyperbolic orbits are all handled.
+void keplerDrift(glm::dvec3& r, glm::dvec3& v, double mu, double dt);
+
+// Classical elements of an elliptic orbit. Angles are measured in the frame of
+// the built-in scenario: the reference plane is y = 0, and zero inclination is
+// the prograde direction in which the planets orbit (angular momentum along -y).
+struct OrbitalElements
+{
+    double semiMajorAxis_m = 0.0;
+    double eccentricity = 0.0;          // below 1
+    double inclination_rad = 0.0;
+    double ascendingNode_rad = 0.0;
+    double argumentOfPeriapsis_rad = 0.0;
+    double meanAnomaly_rad = 0.0;
+};
+
+// Position and velocity relative to the central body for the given elements.
+void elementsToState(const OrbitalElements& elements, double mu, glm::dvec3& r, glm::dvec3& v);
+
+class ThreadPool;
+
+// Two-body orbits of many bodies around one centre, stored as elements so
+// that any time after the epoch is reached in O(N), however far away.
+//
+// Bound orbits with e < MAX_ECCENTRICITY are kept column-wise: semi-major
+// axis, eccentricity, mean motion, mean anomaly at the epoch and the
+// perifocal axes P (towards periapsis) and Q. They are solved together: with
+// x = E - M, Kepler's equation becomes x = e sin(M + x), so after one sin/cos
+// of M per orbit the fixed ITERATIONS Newton steps need only polynomial sin
+// and cos of |x| <= e, and the loops have no branches for the compiler to
+// trip over. Other orbits are advanced from their epoch state with keplerDrift.
+class KeplerOrbits
+{
+public:
+    static constexpr double MAX_ECCENTRICITY = 0.99;
+    static constexpr int    ITERATIONS = 8;
+    static constexpr size_t GRAIN = 1024;
+
+    ThreadPool* pool = nullptr;   // serial when null
+
+    void clear();
+    size_t size() const { return a.size(); }
+
+    // State relative to the centre at the epoch; mu is G (M + m).
+    void add(const glm::dvec3& r, const glm::dvec3& v, double mu);
+
+    // States relative to the centre t seconds after the epoch, written at
+    // [0, size()) of each output array.
+    void evaluate(double t, double* x, double* y, double* z, double* vx, double* vy, double* vz) const;
+
+    // The fitted orbits as bytes for checkpoints (see StateBytes.h); loading
+    // them back gives bit-identical evaluations.
+    void save(std::vector<uint8_t>& out) const;
+    bool load(const std::vector<uint8_t>& in, size_t& offset);
+
+private:
+    struct Unbound
+    {
+        uint32_t   index;
+        glm::dvec3 r, v;
+        double     mu;
+    };
+
+    std::vector<double> a, e, root, n, meanAnomaly, speed;   // root = sqrt(1 - e^2), speed = sqrt(mu a)
+    std::vector<double> px, py, pz, qx, qy, qz;
+    std::vector<Unbound> unbound;
+
+    void evaluateRange(double t, size_t begin, size_t end,
+        double* x, double* y, double* z, double* vx, double* vy, double* vz) const;
+};
@@ -1,28 +1,189 @@
 #include "PhysicsSystem.h"
+#include "core/Profiler.h"
 #include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
 
-void PhysicsSystem::update(std::vector<BodyState>& bodies, double dtReal) const
+void PhysicsSystem::update(std::vector<BodyState>& bodies, double dtReal)
 {
-    double dtSim = dtReal * timeScale;
+    PROFILE_SCOPE("physics.update");
 
-    for (size_t i = 0; i < bodies.size(); ++i)
+    soa.assign(bodies);
+    step(soa, dtReal * timeScale);
+    soa.store(bodies);
+}
+
+void PhysicsSystem::step(BodySoA& bodies, double dtSim)
+{
+    PROFILE_SCOPE("physics.step");
+
+    activeIntegrator().step(bodies, dtSim, *this);
+}
+
+void PhysicsSystem::saveIntegratorState(std::vector<uint8_t>& out) const
+{
+    out.clear();
+    if (active.instance && active.instance->type() == integrator)
+        active.instance->saveState(out);
+}
+
+bool PhysicsSystem::restoreIntegratorState(const std::vector<uint8_t>& in)
+{
+    return activeIntegrator().loadState(in);
+}
+
+Integrator& PhysicsSystem::activeIntegrator()
+{
+    if (!active.instance || active.instance->type() != integrator || active.params.blockEta != blockEta)
     {
-        glm::dvec3 acc(0.0);
+        active.params.G = G;
+        active.params.blockEta = blockEta;
+        active.params.pool = pool;
+        active.instance = makeIntegrator(integrator, active.params);
+    }
+    return *active.instance;
+}
 
-        for (size_t j = 0; j < bodies.size(); ++j)
+void PhysicsSystem::computeAccelerations(const BodySoA& bodies, AccelerationSoA& acc)
+{
+    PROFILE_SCOPE("physics.forces");
+
+    acc.reset(bodies.size());
+    evaluations += bodies.size();
+
+    if (solver == GravitySolver::BarnesHut)
+        treeAccelerations(bodies, acc);
+    else
+        directAccelerations(bodies, acc);
+}
+
+void PhysicsSystem::computeTargetForces(const BodySoA& bodies, const std::vector<uint32_t>& targets,
+    AccelerationSoA& acc, AccelerationSoA& jerk)
+{
+    PROFILE_SCOPE("physics.targetForces");
+
+    evaluations += targets.size();
+
+    // Each target is independent, so chunking does not change the result.
+    size_t grain = bodies.size() < PARALLEL_MIN_BODIES ? targets.size() + 1 : 64;
+    forEachChunk(targets.size(), grain, [&](size_t begin, size_t end)
         {
-            if (i == j) continue;
+            accumulateTargets(simdLevel, bodies, targets.data() + begin, end - begin, G, SOFTEN, acc, jerk);
+        });
+}
 
-            glm::dvec3 r = bodies[j].pos_m - bodies[i].pos_m;
-            double     dist2 = glm::dot(r, r) + SOFTEN;
-            double     invD = 1.0 / sqrt(dist2);
+void PhysicsSystem::forEachChunk(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body)
+{
+    if (pool)
+    {
+        pool->parallelFor(count, grain, body);
+        return;
+    }
+
+    for (size_t begin = 0; begin < count; begin += grain)
+        body(begin, std::min(begin + grain, count));
+}
 
-            acc += (G * bodies[j].mass_kg * invD * invD) * r * invD;
+void PhysicsSystem::directAccelerations(const BodySoA& bodies, AccelerationSoA& acc)
+{
+    size_t n = bodies.size();
+    if (n < PARALLEL_MIN_BODIES)
+    {
+        accumulatePairwise(simdLevel, bodies, G, SOFTEN, acc);
+        return;
+    }
+
+    slices.resize(REDUCTION_SLICES);
+    forEachChunk(REDUCTION_SLICES, 1, [&](size_t begin, size_t end)
+        {
+            for (size_t s = begin; s < end; ++s)
+            {
+                slices[s].reset(n);
+                accumulatePairwiseRows(simdLevel, bodies, s, REDUCTION_SLICES, G, SOFTEN, slices[s]);
+            }
+        });
+
+    forEachChunk(n, 4096, [&](size_t begin, size_t end)
+        {
+            for (size_t s = 0; s < REDUCTION_SLICES; ++s)
+            {
+                const AccelerationSoA& slice = slices[s];
+                for (size_t i = begin; i < end; ++i)
+                {
+                    acc.x[i] += slice.x[i];
+                    acc.y[i] += slice.y[i];
+                    acc.z[i] += slice.z[i];
+                }
+            }
+        });
+}
+
+void PhysicsSystem::treeAccelerations(const BodySoA& bodies, AccelerationSoA& acc)
+{
+    tree.build(bodies);
+
+    forEachChunk(bodies.size(), 256, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                glm::dvec3 a = tree.accelerationAt(glm::dvec3(bodies.x[i], bodies.y[i], bodies.z[i]), G, SOFTEN, theta);
+                acc.x[i] = a.x;
+                acc.y[i] = a.y;
+                acc.z[i] = a.z;
+            }
+        });
+}
+
+double PhysicsSystem::totalEnergy(const BodySoA& bodies) const
+{
+    double kinetic = 0.0, potential = 0.0;
+    size_t n = bodies.size();
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        kinetic += 0.5 * bodies.mass[i] * (bodies.vx[i] * bodies.vx[i] + bodies.vy[i] * bodies.vy[i] + bodies.vz[i] * bodies.vz[i]);
+
+        for (size_t j = i + 1; j < n; ++j)
+        {
+            double dx = bodies.x[j] - bodies.x[i];
+            double dy = bodies.y[j] - bodies.y[i];
+            double dz = bodies.z[j] - bodies.z[i];
+            potential -= G * bodies.mass[i] * bodies.mass[j] / std::sqrt(dx * dx + dy * dy + dz * dz + SOFTEN);
         }
+    }
+
+    return kinetic + potential;
+}
+
+ForceErrorReport PhysicsSystem::measureTreeError(const std::vector<BodyState>& bodies)
+{
+    AccelerationSoA exact, approx;
+    soa.assign(bodies);
+
+    exact.reset(soa.size());
+    approx.reset(soa.size());
+    directAccelerations(soa, exact);
+    treeAccelerations(soa, approx);
+
+    ForceErrorReport report;
+    report.bodyCount = bodies.size();
+    if (bodies.empty())
+        return report;
+
+    double sum = 0.0, sum2 = 0.0;
+    for (size_t i = 0; i < soa.size(); ++i)
+    {
+        glm::dvec3 ref(exact.x[i], exact.y[i], exact.z[i]);
+        glm::dvec3 err = glm::dvec3(approx.x[i], approx.y[i], approx.z[i]) - ref;
+        double     refLen = glm::length(ref);
+        double     rel = refLen > 0.0 ? glm::length(err) / refLen : glm::length(err);
 
-        bodies[i].vel_m += acc * dtSim;
+        sum += rel;
+        sum2 += rel * rel;
+        report.maxRelative = std::max(report.maxRelative, rel);
     }
 
-    for (auto& b : bodies)
-        b.pos_m += b.vel_m * dtSim;
+    report.meanRelative = sum / bodies.size();
+    report.rmsRelative = std::sqrt(sum2 / bodies.size());
+    return report;
 }
@@ -1,14 +1,95 @@
 #pragma once
+#include <cstdint>
 #include <vector>
+#include <glm/glm.hpp>
 #include "BodyState.h"
+#include "BodySoA.h"
+#include "BarnesHutTree.h"
+#include "ForceKernels.h"
+#include "Integrator.h"
+#include "core/ThreadPool.h"
 
-class PhysicsSystem
+enum class GravitySolver
+{
+    Direct,
+    BarnesHut
+};
+
+struct ForceErrorReport
+{
+    double meanRelative = 0.0;
+    double rmsRelative = 0.0;
+    double maxRelative = 0.0;
+    size_t bodyCount = 0;
+};
+
+class PhysicsSystem : public ForceModel
 {
 public:
     double timeScale = 860'400.0; // 10 days / s 
+    GravitySolver solver = GravitySolver::Direct;
+    IntegratorType integrator = IntegratorType::SemiImplicitEuler;
+    double theta = 0.5;           // Barnes-Hut opening angle
+    double blockEta = 0.02;       // block timestep accuracy, dt_i = eta |a| / |jerk|
+    SimdLevel simdLevel = detectSimdLevel();
+    ThreadPool* pool = nullptr;   // serial when null; results do not depend on it
 
     static constexpr double G = 6.67430e-11;
     static constexpr double SOFTEN = 1e3;
 
-    void update(std::vector<BodyState>& bodies, double dtReal) const;
+    // Below this size the direct sum runs as a single pass. Above it, rows are
+    // dealt round-robin into a fixed number of slices that are summed in slice
+    // order, so the result is the same for any thread count.
+    static constexpr size_t PARALLEL_MIN_BODIES = 256;
+    static constexpr size_t REDUCTION_SLICES = 16;
+
+    void update(std::vector<BodyState>& bodies, double dtReal);
+    void step(BodySoA& bodies, double dtSim);
+    void computeAccelerations(const BodySoA& bodies, AccelerationSoA& acc) override;
+
+    // Direct sum for the listed bodies only, whatever the solver; see ForceModel.
+    void computeTargetForces(const BodySoA& bodies, const std::vector<uint32_t>& targets,
+        AccelerationSoA& acc, AccelerationSoA& jerk) override;
+
+    // The active integrator's carry-over between steps, for checkpoints; see
+    // Integrator::saveState. Restoring creates the integrator for the current
+    // settings first, and fails when the state does not belong to it.
+    void saveIntegratorState(std::vector<uint8_t>& out) const;
+    bool restoreIntegratorState(const std::vector<uint8_t>& in);
+
+    // Bodies whose acceleration has been evaluated, summed over all calls.
+    uint64_t forceEvaluations() const { return evaluations; }
+
+    // Kinetic plus softened potential energy, matching the force law (O(N^2)).
+    double totalEnergy(const BodySoA& bodies) const;
+
+    // Compares the tree solver against the direct sum for the current state.
+    ForceErrorReport measureTreeError(const std::vector<BodyState>& bodies);
+
+private:
+    // Owns the integrator instance for the selected type. Copies start empty,
+    // so a copied PhysicsSystem never shares integrator scratch or caches;
+    // moves keep the instance and its carry-over.
+    struct IntegratorSlot
+    {
+        std::unique_ptr<Integrator> instance;
+        IntegratorParams params;
+
+        IntegratorSlot() = default;
+        IntegratorSlot(const IntegratorSlot&) {}
+        IntegratorSlot(IntegratorSlot&&) = default;
+        IntegratorSlot& operator=(const IntegratorSlot&) { instance.reset(); return *this; }
+        IntegratorSlot& operator=(IntegratorSlot&&) = default;
+    };
+
+    IntegratorSlot active;
+    uint64_t evaluations = 0;
+    BarnesHutTree tree;
+    BodySoA soa;
+    std::vector<AccelerationSoA> slices;
+
+    Integrator& activeIntegrator();
+    void forEachChunk(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body);
+    void directAccelerations(const BodySoA& bodies, AccelerationSoA& acc);
+    void treeAccelerations(const BodySoA& bodies, AccelerationSoA& acc);
 };
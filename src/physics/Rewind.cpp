@@ -0,0 +1,81 @@
+#include "Rewind.h"
+#include "core/Profiler.h"
+#include <algorithm>
+
+void RewindHistory::add(Checkpoint&& keyframe, bool boundary)
+{
+    if (!enabled())
+        return;
+
+    PROFILE_SCOPE("rewind.add");
+
+    while (!keyframes.empty() && keyframes.back().state.time_s >= keyframe.time_s)
+    {
+        total -= keyframes.back().bytes;
+        keyframes.pop_back();
+    }
+    if (!keyframes.empty() && keyframes.back().state.bodies.id != keyframe.bodies.id)
+        clear();
+
+    size_t bytes = keyframe.bytes();
+    keyframes.push_back({ std::move(keyframe), bytes, boundary });
+    total += bytes;
+    thin();
+}
+
+void RewindHistory::append(RewindHistory&& later)
+{
+    for (Keyframe& keyframe : later.keyframes)
+        add(std::move(keyframe.state), keyframe.boundary);
+    later.clear();
+}
+
+const Checkpoint* RewindHistory::find(double time_s) const
+{
+    auto after = std::upper_bound(keyframes.begin(), keyframes.end(), time_s,
+        [](double t, const Keyframe& k) { return t < k.state.time_s; });
+    return after == keyframes.begin() ? nullptr : &std::prev(after)->state;
+}
+
+void RewindHistory::dropAfter(double time_s)
+{
+    while (!keyframes.empty() && keyframes.back().state.time_s > time_s)
+    {
+        total -= keyframes.back().bytes;
+        keyframes.pop_back();
+    }
+}
+
+void RewindHistory::clear()
+{
+    keyframes.clear();
+    total = 0;
+}
+
+void RewindHistory::thin()
+{
+    // The newest keyframe always stays, even alone over the budget.
+    while (total > options.budgetBytes && keyframes.size() > 1)
+    {
+        double now = keyframes.back().state.time_s;
+        size_t victim = 0;
+        double best = 2.0;
+        for (size_t i = 1; i + 1 < keyframes.size(); ++i)
+        {
+            if (keyframes[i].boundary)
+                continue;
+
+            double before = keyframes[i - 1].state.time_s;
+            double gap = keyframes[i + 1].state.time_s - before;
+            double cost = gap / std::max(now - before, 1e-9);
+            if (cost < best)
+            {
+                best = cost;
+                victim = i;
+            }
+        }
+
+        total -= keyframes[victim].bytes;
+        keyframes.erase(keyframes.begin() + victim);
+    }
+}
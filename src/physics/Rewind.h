@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include "Checkpoint.h"
+
+struct RewindOptions
+{
+    uint64_t interval = 256;                  // steps between keyframes (Kepler spans count as one)
+    size_t   budgetBytes = size_t(256) << 20;  // 0 keeps no history
+};
+
+// Keyframes of the simulation state, oldest first, for going back in time:
+// restore the newest keyframe at or before the target and step forward to
+// it. Stepping is deterministic, so that lands on the same bits the run
+// had, provided nothing changed the state in between; a keyframe taken
+// right after such a change is a boundary and only goes once it is the
+// oldest.
+//
+// Over the budget, the keyframe whose removal leaves the smallest gap
+// relative to its age goes first, so gaps grow in proportion to age and the
+// history covers a span exponential in the number of keyframes. The work of
+// a seek is at most the gap around the target.
+class RewindHistory
+{
+public:
+    explicit RewindHistory(const RewindOptions& options = RewindOptions()) : options(options) {}
+
+    const RewindOptions& getOptions() const { return options; }
+    bool enabled() const { return options.budgetBytes > 0; }
+
+    // Keyframes at or after its time are dropped first, and all of them
+    // when it has other bodies: going back past a change of bodies would
+    // need the ones that are gone.
+    void add(Checkpoint&& keyframe, bool boundary);
+
+    // Newest keyframe at or before time_s, or null.
+    const Checkpoint* find(double time_s) const;
+
+    // Adds the keyframes of later, oldest first.
+    void append(RewindHistory&& later);
+
+    void dropAfter(double time_s);
+    void clear();
+
+    size_t size() const     { return keyframes.size(); }
+    size_t bytes() const    { return total; }
+    double earliest() const { return keyframes.empty() ? 0.0 : keyframes.front().state.time_s; }
+
+private:
+    struct Keyframe
+    {
+        Checkpoint state;
+        size_t     bytes = 0;
+        bool       boundary = false;
+    };
+
+    RewindOptions options;
+    std::deque<Keyframe> keyframes;
+    size_t total = 0;
+
+    void thin();
+};
@@ -0,0 +1,117 @@
+#include "Scenario.h"
+#include "core/Constants.h"
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+void Scenario::add(const std::string& name, const BodyState& body)
+{
+    names.push_back(name);
+    bodies.push_back(body);
+}
+
+Scenario builtinSolarSystem()
+{
+    Scenario scenario;
+
+    auto addBody = [&](const char* name, double a_au, double v, double m, double density)
+        {
+            scenario.add(name, {
+                glm::dvec3(a_au * L_SCALE, 0.0, 0.0),
+                glm::dvec3(0.0, 0.0, v),
+                m,
+                sphereRadius_m(m, density) });
+        };
+
+    addBody("Sun", 0.000, 0.0, 1.989e30, 1408.0);
+    addBody("Mercury", 0.387, 47900.0, 3.3011e23, 5427.0);
+    addBody("Venus", 0.723, 35000.0, 4.8675e24, 5243.0);
+    addBody("Earth", 1.000, 29780.0, 5.9720e24, 5514.0);
+    addBody("Mars", 1.524, 24100.0, 6.4171e23, 3933.0);
+    addBody("Jupiter", 5.203, 13070.0, 1.8980e27, 1326.0);
+    addBody("Saturn", 9.537, 9680.0, 5.6834e26, 687.0);
+    addBody("Uranus", 19.191, 6800.0, 8.6810e25, 1271.0);
+    addBody("Neptune", 30.070, 5430.0, 1.0240e26, 1638.0);
+
+    return scenario;
+}
+
+bool loadScenario(const std::string& path, Scenario& scenario, std::string& error)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    Scenario loaded;
+    std::string line;
+    int lineNumber = 0;
+
+    while (std::getline(file, line))
+    {
+        ++lineNumber;
+
+        size_t start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos || line[start] == '#')
+            continue;
+
+        std::istringstream in(line);
+        std::string name;
+        BodyState body{};
+        in >> name
+           >> body.pos_m.x >> body.pos_m.y >> body.pos_m.z
+           >> body.vel_m.x >> body.vel_m.y >> body.vel_m.z
+           >> body.mass_kg;
+
+        if (!in || body.mass_kg < 0.0)
+        {
+            error = path + ":" + std::to_string(lineNumber) + ": expected name, position, velocity and mass";
+            return false;
+        }
+
+        if (!(in >> body.radius_m))
+            body.radius_m = 0.0;
+        else if (body.radius_m < 0.0)
+        {
+            error = path + ":" + std::to_string(lineNumber) + ": negative radius";
+            return false;
+        }
+
+        loaded.add(name, body);
+    }
+
+    if (loaded.bodies.empty())
+    {
+        error = path + ": no bodies";
+        return false;
+    }
+
+    scenario = std::move(loaded);
+    return true;
+}
+
+bool saveScenario(const std::string& path, const Scenario& scenario, std::string& error)
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        error = "cannot write " + path;
+        return false;
+    }
+
+    file << "# name x_m y_m z_m vx_m_s vy_m_s vz_m_s mass_kg radius_m\n";
+    file << std::setprecision(17);
+
+    for (size_t i = 0; i < scenario.bodies.size(); ++i)
+    {
+        const BodyState& b = scenario.bodies[i];
+        file << scenario.names[i] << ' '
+             << b.pos_m.x << ' ' << b.pos_m.y << ' ' << b.pos_m.z << ' '
+             << b.vel_m.x << ' ' << b.vel_m.y << ' ' << b.vel_m.z << ' '
+             << b.mass_kg << ' ' << b.radius_m << '\n';
+    }
+
+    return true;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "BodyState.h"
+
+// A named set of initial body states.
+struct Scenario
+{
+    std::vector<std::string> names;
+    std::vector<BodyState>   bodies;
+
+    void add(const std::string& name, const BodyState& body);
+};
+
+// The Sun and the eight planets the application starts with.
+Scenario builtinSolarSystem();
+
+// Text format, one body per line, SI units:
+//   name  x_m y_m z_m  vx_m_s vy_m_s vz_m_s  mass_kg  [radius_m]
+// A missing radius is 0, a point mass that never collides.
+// Blank lines and lines starting with '#' are ignored. On failure returns
+// false and describes the problem in error.
+bool loadScenario(const std::string& path, Scenario& scenario, std::string& error);
+bool saveScenario(const std::string& path, const Scenario& scenario, std::string& error);
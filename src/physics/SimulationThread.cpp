@@ -0,0 +1,652 @@
+#include "SimulationThread.h"
+#include "core/Constants.h"
+#include "core/Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+double BodySnapshot::alphaAt(double now_s) const
+{
+    if (step_s <= 0.0)
+        return 1.0;
+
+    double owed = leftover_s;
+    if (!paused)
+        owed += std::max(0.0, now_s - publishedAt_s) * timeScale;
+
+    return std::clamp(owed / step_s, 0.0, 1.0);
+}
+
+void interpolatePositions(const BodySnapshot& snapshot, double alpha, double metersPerUnit, std::vector<glm::vec3>& out)
+{
+    size_t count = snapshot.current_m.size();
+    out.resize(count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        glm::dvec3 p = glm::mix(snapshot.previous_m[i], snapshot.current_m[i], alpha);
+        out[i] = glm::vec3(p / metersPerUnit);
+    }
+}
+
+void interpolatePositions(const BodySnapshot& snapshot, double alpha, BodyRegistry& registry)
+{
+    const std::vector<BodyId>& ids = registry.getIds();
+    std::vector<glm::vec3>& positions = registry.getPositions();
+
+    for (size_t k = 0; k < snapshot.current_m.size(); ++k)
+    {
+        // Both sides usually list the bodies in the same order.
+        size_t i = k < ids.size() && ids[k] == snapshot.ids[k] ? k : registry.indexOf(snapshot.ids[k]);
+        if (i == BodyRegistry::NPOS)
+            continue;
+
+        glm::dvec3 p = glm::mix(snapshot.previous_m[k], snapshot.current_m[k], alpha);
+        positions[i] = glm::vec3(p / METERS_PER_WU);
+    }
+}
+
+void addCheckpointBodies(Checkpoint& checkpoint, BodyRegistry& registry)
+{
+    BodySoA& b = checkpoint.bodies;
+    for (size_t i = 0; i < b.size(); ++i)
+    {
+        std::string name = i < checkpoint.names.size() ? checkpoint.names[i] : "Body " + std::to_string(i);
+        glm::vec3 color = i < checkpoint.colors.size() ? checkpoint.colors[i] : glm::vec3(0.8f);
+        b.id[i] = registry.add(name, b.get(i), color);
+    }
+    b.reindex();
+}
+
+SimulationThread::SimulationThread(const PhysicsSystem& physics, const std::vector<BodyState>& bodies)
+{
+    state.physics = physics;
+    state.bodies.assign(bodies);
+    state.particles.pool = physics.pool;
+    state.particles.simdLevel = physics.simdLevel;
+    state.particles.G = PhysicsSystem::G;
+    state.particles.soften = PhysicsSystem::SOFTEN;
+    state.collisions.pool = physics.pool;
+
+    capturePositions(previous);
+    captureParticles(previousParticles);
+    addKeyframe(history, state, true);
+    publish(0.0);
+}
+
+SimulationThread::~SimulationThread()
+{
+    stop();
+}
+
+void SimulationThread::start()
+{
+    if (running.exchange(true))
+        return;
+
+    thread = std::thread(&SimulationThread::run, this);
+}
+
+void SimulationThread::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(commandMutex);
+        if (!running.exchange(false))
+            return;
+    }
+    wake.notify_all();
+
+    if (thread.joinable())
+        thread.join();
+    if (checkpointWriter.joinable())
+        checkpointWriter.join();
+}
+
+void SimulationThread::post(Command command, CommandKind kind)
+{
+    {
+        std::lock_guard<std::mutex> lock(commandMutex);
+        commands.emplace_back(std::move(command), kind);
+    }
+    wake.notify_all();
+}
+
+double SimulationThread::clock()
+{
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+void SimulationThread::run()
+{
+    PROFILE_THREAD("physics");
+    double last = clock();
+    double accumulator = 0.0;
+    double rateStart = last;
+    uint64_t rateSteps = 0;
+    uint64_t rateEvaluations = state.physics.forceEvaluations();
+    uint64_t rateInteractions = state.particles.interactions();
+    PerfReading rateCounters;
+
+    while (running.load())
+    {
+        // A jump holds the live state and its commands until it ends.
+        if (jump)
+        {
+            if (advanceJump())
+            {
+                // The jump's work would skew the rates of the current window.
+                accumulator = 0.0;
+                last = clock();
+                rateStart = last;
+                rateSteps = 0;
+                rateEvaluations = state.physics.forceEvaluations();
+                rateInteractions = state.particles.interactions();
+                rateCounters = counters.read();
+            }
+            continue;
+        }
+
+        // The render thread (the main one) is left out; the pool workers
+        // it shares with the physics are not.
+        bool countersWanted = countersEnabled.load();
+        if (countersWanted != countersAttached)
+        {
+            countersAttached = countersWanted;
+            counters.close();
+            if (countersAttached)
+                counters.attachProcess(false);
+            rateCounters = counters.read();
+            countersPerStep = PerfReading();
+            countersPerPair = PerfReading();
+        }
+
+        // Re-simulation cannot replay an edit, so its result is a keyframe.
+        bool edited = false;
+        bool changed = applyCommands(edited);
+        if (edited)
+        {
+            state.particles.invalidate();
+            addKeyframe(history, state, true);
+        }
+
+        double now = clock();
+        double frame = std::min(now - last, MAX_FRAME_S);
+        last = now;
+
+        double step = state.step_s;
+        if (!state.paused)
+            accumulator += frame * state.physics.timeScale;
+
+        size_t due = static_cast<size_t>(accumulator / step);
+        bool   capped = due > MAX_STEPS_PER_TICK;
+        due = std::min(due, MAX_STEPS_PER_TICK);
+
+        // Closed-form orbits cost the same for any dt, so the whole backlog
+        // is one step and nothing is capped.
+        bool     analytic = state.physics.integrator == IntegratorType::Kepler;
+        double   span = step;
+        uint64_t covered = due;   // fixed steps advanced this tick
+        bool     merged = false;
+        if (analytic && due > 0)
+        {
+            double steps = std::floor(accumulator / step);
+            span = steps * step;
+            covered = static_cast<uint64_t>(steps);
+            due = 1;
+            capped = false;
+        }
+
+        if (changed && due == 0)
+        {
+            capturePositions(previous);
+            captureParticles(previousParticles);
+        }
+
+        for (size_t k = 0; k < due; ++k)
+        {
+            if (k + 1 == due)
+            {
+                capturePositions(previous);
+                captureParticles(previousParticles);
+            }
+
+            stepMerges.clear();
+            if (advance(state, span, stepMerges) > 0 && k + 1 == due)
+            {
+                for (const MergeEvent& merge : stepMerges)
+                    previous.erase(previous.begin() + merge.absorbed);
+            }
+            if (!stepMerges.empty())
+            {
+                merged = true;
+                std::lock_guard<std::mutex> lock(mergeMutex);
+                pendingMerges.insert(pendingMerges.end(), stepMerges.begin(), stepMerges.end());
+                mergeCount += stepMerges.size();
+            }
+
+            accumulator -= span;
+        }
+
+        // Physics cannot keep up: drop the backlog instead of spiralling.
+        if (capped)
+            accumulator = std::min(accumulator, step);
+
+        // Counted in advances, which is what replaying costs; a merge changes
+        // the bodies, which ends the history before it.
+        keyframeSteps += due;
+        if (merged || keyframeSteps >= history.getOptions().interval)
+            addKeyframe(history, state, false);
+
+        stepCount += covered;
+        rateSteps += covered;
+        if (now - rateStart >= 1.0)
+        {
+            uint64_t evaluations = state.physics.forceEvaluations();
+            stepsPerSecond = rateSteps / (now - rateStart);
+            if (rateSteps > 0)
+                evaluationsPerStep = static_cast<double>(evaluations - rateEvaluations) / rateSteps;
+            if (counters.available())
+            {
+                uint64_t interactions = state.particles.interactions();
+                size_t n = state.bodies.size();
+                double pairs = (evaluations - rateEvaluations) * (n > 1 ? (n - 1) / 2.0 : 0.0)
+                    + static_cast<double>(interactions - rateInteractions);
+
+                PerfReading reading = counters.read();
+                PerfReading counted = reading - rateCounters;
+                countersPerStep = counted.scaled(rateSteps > 0 ? 1.0 / rateSteps : 0.0);
+                countersPerPair = counted.scaled(pairs > 0.0 ? 1.0 / pairs : 0.0);
+                rateCounters = reading;
+                rateInteractions = interactions;
+            }
+            rateEvaluations = evaluations;
+            rateStart = now;
+            rateSteps = 0;
+        }
+
+        if (due > 0)
+            recorder.append(state.time_s, state.bodies);
+
+        if (due > 0 || changed)
+            publish(accumulator);
+
+        double wait = state.paused ? 0.05 : (step - accumulator) / std::max(state.physics.timeScale, 1e-9);
+        wait = std::clamp(wait, 0.0, 0.05);
+
+        std::unique_lock<std::mutex> lock(commandMutex);
+        wake.wait_for(lock, std::chrono::duration<double>(wait), [&]()
+            {
+                return !running.load() || !commands.empty();
+            });
+    }
+}
+
+void SimulationThread::setCountersEnabled(bool enabled)
+{
+    countersEnabled = enabled;
+    wake.notify_all();
+}
+
+void SimulationThread::jumpTo(double target_s)
+{
+    jumpCancelled = false;
+    post([this, target_s](State& live)
+        {
+            const Checkpoint* keyframe = target_s < live.time_s ? history.find(target_s) : nullptr;
+            if (target_s == live.time_s || (target_s < live.time_s && !keyframe))
+                return;
+
+            // A State copy starts its integrator empty; going through a
+            // checkpoint keeps the carry-over the live run would step with.
+            Checkpoint seed;
+            jumpBack = keyframe != nullptr;
+            if (!jumpBack)
+                captureState(live, seed);
+            jump = std::make_unique<State>(live);
+            if (!restoreState(jumpBack ? *keyframe : seed, *jump))
+            {
+                jump.reset();
+                return;
+            }
+            jumpTarget_s = target_s;
+            jumpStart = clock();
+            jumpSteps = 0;
+            jumpMerges.clear();
+
+            // Commands after this one in the same batch do not reach the
+            // jump, so it starts its own keyframes, the first being its seed.
+            jumpHistory = RewindHistory(history.getOptions());
+            if (!jumpBack)
+                addKeyframe(jumpHistory, std::move(seed), true);
+
+            std::lock_guard<std::mutex> lock(jumpMutex);
+            jumpProgress = { true, jump->time_s, target_s, jump->time_s, 0.0 };
+        }, CommandKind::Query);
+}
+
+void SimulationThread::cancelJump()
+{
+    jumpCancelled = true;
+    wake.notify_all();
+}
+
+JumpStatus SimulationThread::jumpStatus() const
+{
+    std::lock_guard<std::mutex> lock(jumpMutex);
+    return jumpProgress;
+}
+
+void SimulationThread::startRecording(const std::string& path, const TrajectoryOptions& options)
+{
+    post([this, path, options](State& s)
+        {
+            recorder.close(recorderError);
+            if (recorder.open(path, options, recorderError))
+                recorder.append(s.time_s, s.bodies);
+        }, CommandKind::Setting);
+}
+
+void SimulationThread::stopRecording()
+{
+    post([this](State&)
+        {
+            recorder.close(recorderError);
+        }, CommandKind::Setting);
+}
+
+std::future<std::string> SimulationThread::saveCheckpoint(const std::string& path, const BodyRegistry& registry)
+{
+    auto done = std::make_shared<std::promise<std::string>>();
+    std::future<std::string> result = done->get_future();
+
+    std::vector<BodyId> ids = registry.getIds();
+    std::vector<std::string> names = registry.getNames();
+    std::vector<glm::vec3> colors = registry.getColors();
+
+    post([this, path, done, ids = std::move(ids), names = std::move(names), colors = std::move(colors)](State& s) mutable
+        {
+            auto checkpoint = std::make_shared<Checkpoint>();
+            captureState(s, *checkpoint);
+
+            if (checkpointWriter.joinable())
+                checkpointWriter.join();
+            checkpointWriter = std::thread([path, done, checkpoint, ids = std::move(ids), names = std::move(names),
+                colors = std::move(colors)]()
+                {
+                    // Bodies the registry does not know (yet) keep an empty name.
+                    size_t n = checkpoint->bodies.size();
+                    checkpoint->names.assign(n, std::string());
+                    checkpoint->colors.assign(n, glm::vec3(0.8f));
+                    for (size_t k = 0; k < ids.size(); ++k)
+                    {
+                        size_t i = checkpoint->bodies.find(ids[k]);
+                        if (i < n)
+                        {
+                            checkpoint->names[i] = names[k];
+                            checkpoint->colors[i] = colors[k];
+                        }
+                    }
+
+                    std::string error;
+                    ::saveCheckpoint(path, *checkpoint, error);
+                    done->set_value(error);
+                });
+        }, CommandKind::Query);
+    return result;
+}
+
+void SimulationThread::restoreCheckpoint(Checkpoint checkpoint)
+{
+    cancelJump();
+    auto shared = std::make_shared<Checkpoint>(std::move(checkpoint));
+    post([this, shared](State& s)
+        {
+            recorder.close(recorderError);
+            restoreState(*shared, s);
+            history.clear();
+
+            // Merges not taken yet refer to bodies that are gone.
+            std::lock_guard<std::mutex> lock(mergeMutex);
+            pendingMerges.clear();
+            mergesTaken = mergeCount;
+        });
+}
+
+void SimulationThread::captureState(const State& s, Checkpoint& out)
+{
+    out.time_s = s.time_s;
+    out.step_s = s.step_s;
+    out.collisions = s.collisions.enabled;
+    out.bodies = s.bodies;
+    out.capture(s.physics, s.particles);
+}
+
+bool SimulationThread::restoreState(const Checkpoint& checkpoint, State& s)
+{
+    s.time_s = checkpoint.time_s;
+    s.step_s = checkpoint.step_s;
+    s.collisions.enabled = checkpoint.collisions;
+    s.bodies = checkpoint.bodies;
+    return checkpoint.apply(s.physics, s.particles);
+}
+
+// Runs the jump for one slice; returns true once it was swapped in or dropped.
+bool SimulationThread::advanceJump()
+{
+    PROFILE_SCOPE("sim.jump");
+
+    State& s = *jump;
+    bool analytic = s.physics.integrator == IntegratorType::Kepler;
+    double sliceEnd = clock() + JUMP_SLICE_S;
+
+    while (!jumpCancelled.load() && s.time_s < jumpTarget_s && clock() < sliceEnd)
+    {
+        // The last step is shortened to land on the target.
+        double remaining = jumpTarget_s - s.time_s;
+        double dt = analytic || remaining < s.step_s * (1.0 + 1e-9) ? remaining : s.step_s;
+        advance(s, dt, jumpMerges);
+        if (dt == remaining)
+            s.time_s = jumpTarget_s;
+        jumpSteps += analytic ? static_cast<uint64_t>(std::ceil(dt / s.step_s)) : 1;
+
+        // Going back only replays what the history already covers, and
+        // keyframes before a merge would be dropped anyway.
+        keyframeSteps += 1;
+        if (!jumpBack && jumpMerges.empty() && keyframeSteps >= history.getOptions().interval)
+            addKeyframe(jumpHistory, s, false);
+    }
+
+    bool cancelled = jumpCancelled.load() || !running.load();
+    bool finished = !cancelled && s.time_s >= jumpTarget_s;
+    {
+        std::lock_guard<std::mutex> lock(jumpMutex);
+        double elapsed = clock() - jumpStart;
+        jumpProgress.reached_s = s.time_s;
+        jumpProgress.stepsPerSecond = elapsed > 0.0 ? jumpSteps / elapsed : 0.0;
+        jumpProgress.active = !cancelled && !finished;
+    }
+
+    if (cancelled)
+    {
+        jump.reset();
+        jumpHistory.clear();
+        return true;
+    }
+    if (!finished)
+        return false;
+
+    // The live state moved on after the jump began; its keyframes from
+    // then on go, and the jump's take their place.
+    if (!jumpBack)
+        history.dropAfter(jumpProgress.from_s);
+    history.append(std::move(jumpHistory));
+    addKeyframe(history, s, true);
+
+    // A trajectory cannot go back in time.
+    if (jumpBack)
+        recorder.close(recorderError);
+
+    state = std::move(s);
+    jump.reset();
+    stepCount += jumpSteps;
+    {
+        std::lock_guard<std::mutex> lock(mergeMutex);
+        pendingMerges.insert(pendingMerges.end(), jumpMerges.begin(), jumpMerges.end());
+        mergeCount += jumpMerges.size();
+    }
+    jumpMerges.clear();
+    recorder.append(state.time_s, state.bodies);
+
+    capturePositions(previous);
+    captureParticles(previousParticles);
+    publish(0.0);
+    return true;
+}
+
+void SimulationThread::addKeyframe(RewindHistory& to, const State& s, bool boundary)
+{
+    keyframeSteps = 0;
+    if (!to.enabled())
+        return;
+
+    Checkpoint keyframe;
+    captureState(s, keyframe);
+    to.add(std::move(keyframe), boundary);
+}
+
+void SimulationThread::addKeyframe(RewindHistory& to, Checkpoint&& keyframe, bool boundary)
+{
+    keyframeSteps = 0;
+    if (to.enabled())
+        to.add(std::move(keyframe), boundary);
+}
+
+size_t SimulationThread::advance(State& s, double dt, std::vector<MergeEvent>& merges)
+{
+    if (s.physics.integrator == IntegratorType::Kepler)
+    {
+        // Two-body orbits never meet, and a swept test over a whole
+        // time-warp span would be meaningless.
+        s.particles.keplerStep(s.bodies, dt);
+        s.physics.step(s.bodies, dt);
+        s.time_s += dt;
+        return 0;
+    }
+
+    s.particles.beginStep(s.bodies, dt);
+    s.physics.step(s.bodies, dt);
+    s.particles.endStep(s.bodies, dt);
+
+    size_t merged = s.collisions.resolve(s.bodies, dt, s.time_s, merges);
+    if (merged > 0)
+        s.particles.invalidate();
+
+    s.time_s += dt;
+    return merged;
+}
+
+void SimulationThread::takeMerges(uint64_t upTo, std::vector<MergeEvent>& out)
+{
+    out.clear();
+
+    std::lock_guard<std::mutex> lock(mergeMutex);
+    size_t count = static_cast<size_t>(std::min<uint64_t>(upTo - std::min(upTo, mergesTaken), pendingMerges.size()));
+    out.assign(pendingMerges.begin(), pendingMerges.begin() + count);
+    pendingMerges.erase(pendingMerges.begin(), pendingMerges.begin() + count);
+    mergesTaken += count;
+}
+
+bool SimulationThread::applyCommands(bool& edited)
+{
+    PROFILE_SCOPE("sim.commands");
+
+    std::vector<std::pair<Command, CommandKind>> pending;
+    {
+        std::lock_guard<std::mutex> lock(commandMutex);
+        pending.swap(commands);
+    }
+
+    bool changed = false;
+    for (auto& [command, kind] : pending)
+    {
+        command(state);
+        edited = edited || kind == CommandKind::Edit;
+        changed = changed || kind != CommandKind::Query;
+    }
+    return changed;
+}
+
+void SimulationThread::capturePositions(std::vector<glm::dvec3>& out) const
+{
+    const BodySoA& b = state.bodies;
+    out.resize(b.size());
+
+    for (size_t i = 0; i < b.size(); ++i)
+        out[i] = glm::dvec3(b.x[i], b.y[i], b.z[i]);
+}
+
+void SimulationThread::captureParticles(std::vector<glm::vec3>& out) const
+{
+    const ParticleSoA& p = state.particles.particles;
+    out.resize(p.size());
+
+    for (size_t i = 0; i < p.size(); ++i)
+        out[i] = glm::vec3(glm::dvec3(p.x[i], p.y[i], p.z[i]));
+}
+
+void SimulationThread::publish(double leftover_s)
+{
+    PROFILE_SCOPE("sim.publish");
+
+    BodySnapshot& snap = snapshots.writeSlot();
+
+    capturePositions(snap.current_m);
+    const BodySoA& b = state.bodies;
+    snap.ids = b.id;
+    snap.velocity_m_s.resize(b.size());
+    for (size_t i = 0; i < b.size(); ++i)
+        snap.velocity_m_s[i] = glm::vec3(glm::dvec3(b.vx[i], b.vy[i], b.vz[i]));
+    snap.previous_m = previous;
+    if (snap.previous_m.size() != snap.current_m.size())
+        snap.previous_m = snap.current_m;
+
+    captureParticles(snap.particleCurrent_m);
+    snap.particlePrevious_m = previousParticles;
+    if (snap.particlePrevious_m.size() != snap.particleCurrent_m.size())
+        snap.particlePrevious_m = snap.particleCurrent_m;
+
+    snap.simTime_s = state.time_s;
+    snap.step_s = state.step_s;
+    snap.leftover_s = leftover_s;
+    snap.publishedAt_s = clock();
+    snap.timeScale = state.physics.timeScale;
+    snap.stepsPerSecond = stepsPerSecond;
+    snap.evaluationsPerStep = evaluationsPerStep;
+    snap.countersEnabled = countersAttached;
+    snap.countersError = countersAttached && !counters.available() ? counters.error() : std::string();
+    snap.countersPerStep = countersPerStep;
+    snap.countersPerPair = countersPerPair;
+    snap.recording = recorder.isOpen();
+    snap.recordingPath = recorder.getPath();
+    snap.recordingError = recorderError;
+    snap.recordedFrames = recorder.framesAppended();
+    snap.recordedDrops = recorder.chunksDropped();
+    snap.rewindFrom_s = history.earliest();
+    snap.rewindKeyframes = history.size();
+    snap.rewindBytes = history.bytes();
+    snap.stepCount = stepCount;
+    {
+        std::lock_guard<std::mutex> lock(mergeMutex);
+        snap.mergeCount = mergeCount;
+    }
+    snap.paused = state.paused;
+    snap.collisions = state.collisions.enabled;
+    snap.solver = state.physics.solver;
+    snap.integrator = state.physics.integrator;
+    snap.theta = state.physics.theta;
+    snap.blockEta = state.physics.blockEta;
+    snap.simdLevel = state.physics.simdLevel;
+
+    snapshots.publish();
+}
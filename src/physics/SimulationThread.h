@@ -0,0 +1,272 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+#include "core/BodyRegistry.h"
+#include "core/PerfCounters.h"
+#include "BodySoA.h"
+#include "Checkpoint.h"
+#include "Collisions.h"
+#include "PhysicsSystem.h"
+#include "Rewind.h"
+#include "TestParticles.h"
+#include "Trajectory.h"
+
+// Body positions at the last two fixed steps plus the settings that were in
+// effect, as published by the physics thread.
+struct BodySnapshot
+{
+    std::vector<glm::dvec3> previous_m;
+    std::vector<glm::dvec3> current_m;
+    std::vector<glm::vec3>  velocity_m_s;   // at current_m
+    std::vector<BodyId>     ids;
+
+    // Test particles, in single precision to halve the copy.
+    std::vector<glm::vec3> particlePrevious_m;
+    std::vector<glm::vec3> particleCurrent_m;
+
+    double   simTime_s = 0.0;
+    double   step_s = 0.0;
+    double   leftover_s = 0.0;    // accumulated time not yet stepped when published
+    double   publishedAt_s = 0.0; // SimulationThread::clock() at publication
+    double   timeScale = 0.0;
+    double   stepsPerSecond = 0.0;
+    double   evaluationsPerStep = 0.0; // body force evaluations per fixed step
+
+    // Hardware counters over the last rate window; see setCountersEnabled.
+    bool        countersEnabled = false;
+    std::string countersError;         // set when enabled but unavailable
+    PerfReading countersPerStep;
+    PerfReading countersPerPair;       // per body pair of the direct sum or particle interaction
+    // Trajectory recording; see SimulationThread::startRecording.
+    bool        recording = false;
+    std::string recordingPath;
+    std::string recordingError;        // from the last start or stop
+    uint64_t    recordedFrames = 0;
+    uint64_t    recordedDrops = 0;      // chunks the disk could not keep up with
+    // How far back jumpTo can go; see RewindHistory.
+    double      rewindFrom_s = 0.0;
+    size_t      rewindKeyframes = 0;
+    size_t      rewindBytes = 0;
+
+    uint64_t stepCount = 0;
+    uint64_t mergeCount = 0;      // merges so far; see SimulationThread::takeMerges
+    bool     paused = false;
+    bool     collisions = false;
+
+    GravitySolver  solver = GravitySolver::Direct;
+    IntegratorType integrator = IntegratorType::SemiImplicitEuler;
+    double         theta = 0.0;
+    double         blockEta = 0.0;
+    SimdLevel      simdLevel = SimdLevel::Scalar;
+
+    // Blend factor between previous_m and current_m for wall time now_s.
+    double alphaAt(double now_s) const;
+};
+
+void interpolatePositions(const BodySnapshot& snapshot, double alpha, double metersPerUnit, std::vector<glm::vec3>& out);
+
+// Writes the blended positions into the registry, matching bodies by id.
+// Registry bodies the snapshot does not have yet keep their position.
+void interpolatePositions(const BodySnapshot& snapshot, double alpha, BodyRegistry& registry);
+
+// Adds the checkpoint's bodies to the registry, with their names and colors,
+// and gives the checkpoint the registry's ids for them.
+void addCheckpointBodies(Checkpoint& checkpoint, BodyRegistry& registry);
+
+// Progress of a jump started with SimulationThread::jumpTo.
+struct JumpStatus
+{
+    bool   active = false;
+    double from_s = 0.0;
+    double to_s = 0.0;
+    double reached_s = 0.0;
+    double stepsPerSecond = 0.0;
+
+    double progress() const { return to_s > from_s ? (reached_s - from_s) / (to_s - from_s) : 1.0; }
+};
+
+// Single-producer, single-consumer triple buffer. The writer and the reader
+// each own a slot and trade it for the middle one with one atomic exchange.
+template <typename T>
+class TripleBuffer
+{
+public:
+    T& writeSlot() { return slots[back]; }
+    void publish() { back = middle.exchange(back | DIRTY) & INDEX; }
+
+    const T& acquire()
+    {
+        if (middle.load() & DIRTY)
+            front = middle.exchange(front) & INDEX;
+        return slots[front];
+    }
+    const T& current() const { return slots[front]; }
+
+private:
+    static constexpr unsigned INDEX = 3;
+    static constexpr unsigned DIRTY = 4;
+
+    T slots[3];
+    std::atomic<unsigned> middle{ 1 };
+    unsigned back = 0;
+    unsigned front = 2;
+};
+
+// Runs PhysicsSystem on its own thread with a fixed step. Wall time, scaled by
+// timeScale, feeds an accumulator that is drained in whole steps; the render
+// thread interpolates between the two latest published positions.
+class SimulationThread
+{
+public:
+    struct State
+    {
+        BodySoA       bodies;
+        PhysicsSystem physics;
+        TestParticles particles;
+        CollisionSystem collisions;
+        double        time_s = 0.0;
+        double        step_s = 3600.0;
+        bool          paused = false;
+    };
+
+    using Command = std::function<void(State&)>;
+
+    // What a command does to the state. An Edit changes what the steps
+    // compute, so caches are dropped and a rewind keyframe is taken, as
+    // re-simulation cannot replay it. A Setting only changes whether and how
+    // fast time runs, or what is done with the results; a Query only reads.
+    enum class CommandKind
+    {
+        Edit,
+        Setting,
+        Query,
+    };
+
+    static constexpr double MAX_FRAME_S = 0.25;
+    static constexpr size_t MAX_STEPS_PER_TICK = 4096;
+    static constexpr double JUMP_SLICE_S = 0.02;   // wall time between progress updates of a jump
+
+    SimulationThread(const PhysicsSystem& physics, const std::vector<BodyState>& bodies);
+    ~SimulationThread();
+
+    SimulationThread(const SimulationThread&) = delete;
+    SimulationThread& operator=(const SimulationThread&) = delete;
+
+    void start();
+    void stop();
+
+    // Queues a change to the simulation; it runs on the physics thread between steps.
+    void post(Command command, CommandKind kind = CommandKind::Edit);
+
+    // Counts hardware events on the physics thread and the pool workers
+    // (Linux only) and publishes per-step and per-pair rates once a second.
+    void setCountersEnabled(bool enabled);
+
+    // Integrates a copy of the state to target_s at the fixed step, as fast
+    // as the workers allow, and swaps it in with one publish when it gets
+    // there. Meanwhile the live state stands still and commands posted after
+    // this one wait for the swap. A target behind starts from the newest
+    // keyframe before it, and stops a recording; one before the oldest
+    // keyframe is ignored.
+    void jumpTo(double target_s);
+    void cancelJump();
+    JumpStatus jumpStatus() const;
+
+    // Appends the body positions after every tick (and after a jump) to a
+    // trajectory file, replacing any recording in progress.
+    void startRecording(const std::string& path, const TrajectoryOptions& options = TrajectoryOptions());
+    void stopRecording();
+
+    // Copies the state between two steps, with the names and colors of the
+    // registry's bodies, and writes it on a background thread, so neither
+    // the physics nor the frame waits for the disk. The future holds the
+    // error, empty on success.
+    std::future<std::string> saveCheckpoint(const std::string& path, const BodyRegistry& registry);
+
+    // Replaces the state; the checkpoint's body ids must be the registry's.
+    // A jump in progress is cancelled and a recording is stopped, since time
+    // may go backwards.
+    void restoreCheckpoint(Checkpoint checkpoint);
+
+    // Between steps, for the physics thread's commands.
+    static void captureState(const State& s, Checkpoint& out);
+    static bool restoreState(const Checkpoint& checkpoint, State& s);
+
+    // Render thread only: picks up the newest snapshot, if any, and returns it.
+    const BodySnapshot& acquireSnapshot() { return snapshots.acquire(); }
+    const BodySnapshot& snapshot() const { return snapshots.current(); }
+
+    // Render thread only: moves the merges up to snapshot.mergeCount that
+    // were not taken yet into out, oldest first. Applying them in order to a
+    // list that matched the previous snapshot makes it match this one.
+    void takeMerges(uint64_t upTo, std::vector<MergeEvent>& out);
+
+    static double clock();
+
+private:
+    State state;
+    TripleBuffer<BodySnapshot> snapshots;
+    std::vector<glm::dvec3> previous;
+    std::vector<glm::vec3> previousParticles;
+    std::vector<MergeEvent> stepMerges;
+
+    std::mutex mergeMutex;
+    std::vector<MergeEvent> pendingMerges;
+    uint64_t mergesTaken = 0;
+    uint64_t mergeCount = 0;
+
+    std::mutex commandMutex;
+    std::condition_variable wake;
+    std::vector<std::pair<Command, CommandKind>> commands;
+    std::atomic<bool> running{ false };
+    std::thread thread;
+
+    std::unique_ptr<State> jump;   // physics thread only
+    double jumpTarget_s = 0.0;
+    double jumpStart = 0.0;        // clock() when the jump began
+    uint64_t jumpSteps = 0;
+    std::vector<MergeEvent> jumpMerges;
+    bool jumpBack = false;
+    RewindHistory jumpHistory;     // keyframes of a forward jump, kept if it finishes
+    std::atomic<bool> jumpCancelled{ false };
+    mutable std::mutex jumpMutex;
+    JumpStatus jumpProgress;
+
+    RewindHistory history;         // physics thread only
+    uint64_t keyframeSteps = 0;    // advances since the last keyframe
+
+    uint64_t stepCount = 0;
+    double   stepsPerSecond = 0.0;
+    double   evaluationsPerStep = 0.0;
+
+    std::atomic<bool> countersEnabled{ false };
+    bool        countersAttached = false;   // physics thread only, like counters
+    PerfCounters counters;
+    PerfReading countersPerStep;
+    PerfReading countersPerPair;
+
+    TrajectoryWriter recorder;   // physics thread only
+    std::string recorderError;
+    std::thread checkpointWriter;   // started and joined by the physics thread
+
+    void run();
+    bool advanceJump();
+    bool applyCommands(bool& edited);   // true when any ran that was not a Query
+    void capturePositions(std::vector<glm::dvec3>& out) const;
+    void captureParticles(std::vector<glm::vec3>& out) const;
+    void publish(double leftover_s);
+    void addKeyframe(RewindHistory& to, const State& s, bool boundary);
+    void addKeyframe(RewindHistory& to, Checkpoint&& keyframe, bool boundary);
+
+    // One step of s, collisions included; merges are appended to merges.
+    static size_t advance(State& s, double dt, std::vector<MergeEvent>& merges);
+};
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Byte packing for the carry-over state that checkpoints keep opaque (see
+// Integrator::saveState). Values are copied as they are in memory; a column
+// is its length followed by its elements. The read functions fail rather
+// than run past the end.
+inline void appendBytes(std::vector<uint8_t>& out, const void* data, size_t bytes)
+{
+    const uint8_t* begin = static_cast<const uint8_t*>(data);
+    out.insert(out.end(), begin, begin + bytes);
+}
+
+inline bool readBytes(const std::vector<uint8_t>& in, size_t& offset, void* data, size_t bytes)
+{
+    if (offset > in.size() || in.size() - offset < bytes)
+        return false;
+    if (bytes > 0)
+        std::memcpy(data, in.data() + offset, bytes);
+    offset += bytes;
+    return true;
+}
+
+template <typename T>
+void appendValue(std::vector<uint8_t>& out, const T& value)
+{
+    appendBytes(out, &value, sizeof(T));
+}
+
+template <typename T>
+bool readValue(const std::vector<uint8_t>& in, size_t& offset, T& value)
+{
+    return readBytes(in, offset, &value, sizeof(T));
+}
+
+template <typename Column>
+void appendColumn(std::vector<uint8_t>& out, const Column& column)
+{
+    appendValue(out, static_cast<uint64_t>(column.size()));
+    appendBytes(out, column.data(), column.size() * sizeof(column[0]));
+}
+
+template <typename Column>
+bool readColumn(const std::vector<uint8_t>& in, size_t& offset, Column& column)
+{
+    uint64_t size = 0;
+    if (!readValue(in, offset, size) || size > (in.size() - offset) / sizeof(column[0]))
+        return false;
+    column.resize(static_cast<size_t>(size));
+    return readBytes(in, offset, column.data(), column.size() * sizeof(column[0]));
+}
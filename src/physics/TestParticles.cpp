@@ -0,0 +1,246 @@
+#define _USE_MATH_DEFINES
+#include "TestParticles.h"
+#include "Kepler.h"
+#include "StateBytes.h"
+#include "core/Constants.h"
+#include "core/Profiler.h"
+#include "core/ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+void ParticleSoA::resize(size_t n)
+{
+    x.resize(n);
+    y.resize(n);
+    z.resize(n);
+    vx.resize(n);
+    vy.resize(n);
+    vz.resize(n);
+}
+
+void ParticleSoA::push_back(const glm::dvec3& pos_m, const glm::dvec3& vel_m)
+{
+    x.push_back(pos_m.x);
+    y.push_back(pos_m.y);
+    z.push_back(pos_m.z);
+    vx.push_back(vel_m.x);
+    vy.push_back(vel_m.y);
+    vz.push_back(vel_m.z);
+}
+
+void TestParticles::clear()
+{
+    particles.resize(0);
+    invalidate();
+}
+
+void TestParticles::forEachChunk(const std::function<void(size_t, size_t)>& body)
+{
+    size_t count = particles.size();
+    if (pool)
+    {
+        pool->parallelFor(count, GRAIN, body);
+        return;
+    }
+
+    for (size_t begin = 0; begin < count; begin += GRAIN)
+        body(begin, std::min(begin + GRAIN, count));
+}
+
+void TestParticles::computeAccelerations(const BodySoA& bodies)
+{
+    ParticleSoA& p = particles;
+    acc.reset(p.size());
+
+    forEachChunk([&](size_t begin, size_t end)
+        {
+            accumulateSources(simdLevel, bodies, &p.x[begin], &p.y[begin], &p.z[begin], end - begin,
+                G, soften, &acc.x[begin], &acc.y[begin], &acc.z[begin]);
+        });
+
+    evaluated += p.size() * bodies.size();
+    accelerationValid = true;
+}
+
+void TestParticles::beginStep(const BodySoA& bodies, double dt)
+{
+    PROFILE_SCOPE("particles.begin");
+
+    if (particles.size() == 0)
+        return;
+
+    if (!accelerationValid || acc.size() != particles.size())
+        computeAccelerations(bodies);
+
+    ParticleSoA& p = particles;
+    double half = 0.5 * dt;
+
+    forEachChunk([&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                p.vx[i] += acc.x[i] * half;
+                p.vy[i] += acc.y[i] * half;
+                p.vz[i] += acc.z[i] * half;
+                p.x[i] += p.vx[i] * dt;
+                p.y[i] += p.vy[i] * dt;
+                p.z[i] += p.vz[i] * dt;
+            }
+        });
+    accelerationValid = false;
+    orbitsValid = false;
+}
+
+void TestParticles::endStep(const BodySoA& bodies, double dt)
+{
+    PROFILE_SCOPE("particles.end");
+
+    if (particles.size() == 0)
+        return;
+
+    computeAccelerations(bodies);
+
+    ParticleSoA& p = particles;
+    double half = 0.5 * dt;
+
+    forEachChunk([&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                p.vx[i] += acc.x[i] * half;
+                p.vy[i] += acc.y[i] * half;
+                p.vz[i] += acc.z[i] * half;
+            }
+        });
+}
+
+void TestParticles::keplerStep(const BodySoA& bodies, double dt)
+{
+    PROFILE_SCOPE("particles.kepler");
+
+    ParticleSoA& p = particles;
+    if (p.size() == 0 || bodies.size() == 0)
+        return;
+
+    if (!orbitsValid || orbits.size() != p.size())
+    {
+        size_t central = static_cast<size_t>(std::max_element(bodies.mass.begin(), bodies.mass.end()) - bodies.mass.begin());
+        orbitOrigin = glm::dvec3(bodies.x[central], bodies.y[central], bodies.z[central]);
+        orbitVelocity = glm::dvec3(bodies.vx[central], bodies.vy[central], bodies.vz[central]);
+        orbitTime = 0.0;
+
+        double mu = G * bodies.mass[central];
+        orbits.pool = pool;
+        orbits.clear();
+        for (size_t i = 0; i < p.size(); ++i)
+        {
+            orbits.add(glm::dvec3(p.x[i], p.y[i], p.z[i]) - orbitOrigin,
+                glm::dvec3(p.vx[i], p.vy[i], p.vz[i]) - orbitVelocity, mu);
+        }
+        orbitsValid = true;
+    }
+
+    orbitTime += dt;
+    orbits.evaluate(orbitTime, p.x.data(), p.y.data(), p.z.data(), p.vx.data(), p.vy.data(), p.vz.data());
+
+    glm::dvec3 origin = orbitOrigin + orbitVelocity * orbitTime;
+    forEachChunk([&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                p.x[i] += origin.x;
+                p.y[i] += origin.y;
+                p.z[i] += origin.z;
+                p.vx[i] += orbitVelocity.x;
+                p.vy[i] += orbitVelocity.y;
+                p.vz[i] += orbitVelocity.z;
+            }
+        });
+    accelerationValid = false;
+}
+
+void TestParticles::saveState(std::vector<uint8_t>& out) const
+{
+    out.clear();
+    if (!orbitsValid)
+        return;
+
+    appendValue(out, orbitOrigin);
+    appendValue(out, orbitVelocity);
+    appendValue(out, orbitTime);
+    orbits.save(out);
+}
+
+bool TestParticles::loadState(const std::vector<uint8_t>& in)
+{
+    invalidate();
+    if (in.empty())
+        return true;
+
+    size_t offset = 0;
+    orbitsValid = readValue(in, offset, orbitOrigin) && readValue(in, offset, orbitVelocity)
+        && readValue(in, offset, orbitTime) && orbits.load(in, offset)
+        && offset == in.size() && orbits.size() == particles.size();
+    orbits.pool = pool;
+    return orbitsValid;
+}
+
+BeltSpec mainAsteroidBelt(size_t count)
+{
+    BeltSpec spec;
+    spec.count = count;
+    spec.innerRadius_m = 2.1 * L_SCALE;
+    spec.outerRadius_m = 3.3 * L_SCALE;
+    spec.maxEccentricity = 0.2;
+    spec.inclinationSigma_rad = 8.0 * M_PI / 180.0;
+    return spec;
+}
+
+BeltSpec kuiperBelt(size_t count)
+{
+    BeltSpec spec;
+    spec.count = count;
+    spec.innerRadius_m = 30.0 * L_SCALE;
+    spec.outerRadius_m = 50.0 * L_SCALE;
+    spec.maxEccentricity = 0.15;
+    spec.inclinationSigma_rad = 10.0 * M_PI / 180.0;
+    spec.seed = 2;
+    return spec;
+}
+
+BeltSpec planetaryRing(size_t count, double planetRadius_m)
+{
+    BeltSpec spec;
+    spec.count = count;
+    spec.innerRadius_m = 1.2 * planetRadius_m;
+    spec.outerRadius_m = 2.3 * planetRadius_m;
+    spec.seed = 3;
+    return spec;
+}
+
+void generateBelt(const BeltSpec& spec, const BodyState& central, double G, ParticleSoA& out)
+{
+    std::mt19937_64 rng(spec.seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::normal_distribution<double> normal(0.0, 1.0);
+
+    double mu = G * central.mass_kg;
+    double inner2 = spec.innerRadius_m * spec.innerRadius_m;
+    double outer2 = spec.outerRadius_m * spec.outerRadius_m;
+
+    for (size_t k = 0; k < spec.count; ++k)
+    {
+        OrbitalElements elements;
+        elements.semiMajorAxis_m = std::sqrt(inner2 + unit(rng) * (outer2 - inner2));
+        elements.eccentricity = spec.maxEccentricity * unit(rng);
+        elements.inclination_rad = std::abs(normal(rng)) * spec.inclinationSigma_rad;
+        elements.ascendingNode_rad = 2.0 * M_PI * unit(rng);
+        elements.argumentOfPeriapsis_rad = 2.0 * M_PI * unit(rng);
+        elements.meanAnomaly_rad = 2.0 * M_PI * unit(rng);
+
+        glm::dvec3 r, v;
+        elementsToState(elements, mu, r, v);
+        out.push_back(central.pos_m + r, central.vel_m + v);
+    }
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <glm/glm.hpp>
+#include "BodySoA.h"
+#include "ForceKernels.h"
+#include "Kepler.h"
+
+class ThreadPool;
+
+// Massless particles (asteroids, ring material) that feel the gravity of the
+// massive bodies but exert none, so a step costs particles x bodies instead
+// of growing the O(N^2) body sum.
+struct ParticleSoA
+{
+    AlignedVector<double> x, y, z;
+    AlignedVector<double> vx, vy, vz;
+
+    size_t size() const { return x.size(); }
+    void   resize(size_t n);
+    void   push_back(const glm::dvec3& pos_m, const glm::dvec3& vel_m);
+};
+
+// Advances the particles with kick-drift-kick leapfrog alongside whatever
+// integrator moves the bodies:
+//
+//     particles.beginStep(bodies, dt);   // kick dt/2 from bodies at t, drift dt
+//     physics.step(bodies, dt);
+//     particles.endStep(bodies, dt);     // kick dt/2 from bodies at t + dt
+//
+// The closing acceleration is kept for the next beginStep; invalidate() drops
+// it when the bodies were changed in between. Particles are independent, so
+// the result does not depend on the thread count.
+//
+// Under IntegratorType::Kepler, keplerStep replaces the pair: each particle
+// follows its two-body orbit around the most massive body, fitted once and
+// then evaluated in closed form like the bodies.
+class TestParticles
+{
+public:
+    static constexpr size_t GRAIN = 4096;
+
+    SimdLevel simdLevel = detectSimdLevel();
+    ThreadPool* pool = nullptr;   // serial when null
+    double G = 6.67430e-11;
+    double soften = 1e3;
+
+    ParticleSoA particles;
+
+    size_t size() const { return particles.size(); }
+    void clear();
+    void invalidate() { accelerationValid = false; orbitsValid = false; }
+
+    void beginStep(const BodySoA& bodies, double dt);
+    void endStep(const BodySoA& bodies, double dt);
+
+    // With the bodies at the start of the step.
+    void keplerStep(const BodySoA& bodies, double dt);
+
+    // The fitted orbits of keplerStep, for checkpoints, like
+    // Integrator::saveState. Load after the particles themselves.
+    void saveState(std::vector<uint8_t>& out) const;
+    bool loadState(const std::vector<uint8_t>& in);
+
+    // Particle-body interactions evaluated, summed over all steps.
+    uint64_t interactions() const { return evaluated; }
+
+private:
+    AccelerationSoA acc;
+    bool accelerationValid = false;
+    uint64_t evaluated = 0;
+
+    KeplerOrbits orbits;
+    glm::dvec3 orbitOrigin, orbitVelocity;   // central body at the fit
+    double orbitTime = 0.0;
+    bool orbitsValid = false;
+
+    void computeAccelerations(const BodySoA& bodies);
+    void forEachChunk(const std::function<void(size_t, size_t)>& body);
+};
+
+// A belt or ring of particles on Keplerian orbits around one body. Semi-major
+// axes are drawn for a uniform surface density between the two radii,
+// eccentricities uniformly up to maxEccentricity, inclinations from a
+// half-normal of width inclinationSigma_rad, and the three angles uniformly.
+// Orbits are prograde in the same plane as the built-in scenario (y up).
+struct BeltSpec
+{
+    size_t   count = 0;
+    double   innerRadius_m = 0.0;
+    double   outerRadius_m = 0.0;
+    double   maxEccentricity = 0.0;
+    double   inclinationSigma_rad = 0.0;
+    uint64_t seed = 1;
+};
+
+BeltSpec mainAsteroidBelt(size_t count);   // 2.1 - 3.3 AU
+BeltSpec kuiperBelt(size_t count);         // 30 - 50 AU
+BeltSpec planetaryRing(size_t count, double planetRadius_m);   // 1.2 - 2.3 planet radii, flat
+
+// Appends spec.count particles orbiting central, as a test particle of
+// gravitational parameter G * central.mass.
+void generateBelt(const BeltSpec& spec, const BodyState& central, double G, ParticleSoA& out);
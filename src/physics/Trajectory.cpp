@@ -0,0 +1,504 @@
+#include "Trajectory.h"
+#include "core/Constants.h"
+#include "core/Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+    constexpr char     FILE_MAGIC[8] = { 'S', 'S', 'T', 'R', 'A', 'J', '\0', '\0' };
+    constexpr char     INDEX_MAGIC[8] = { 'S', 'S', 'I', 'N', 'D', 'E', 'X', '\0' };
+    constexpr uint32_t CHUNK_MAGIC = 0x4b4e4843;   // "CHNK"
+
+    // Largest position, in quanta, that is rounded to an int64 keyframe.
+    constexpr double MAX_QUANTA = 9.0e18;
+
+    static_assert(sizeof(TrajectoryHeader) == 16, "trajectory header layout");
+    static_assert(sizeof(TrajectoryChunkHeader) == 48, "trajectory chunk layout");
+    static_assert(sizeof(TrajectoryIndexEntry) == 24, "trajectory index layout");
+    static_assert(sizeof(TrajectoryTrailer) == 24, "trajectory trailer layout");
+
+    size_t padded(size_t bytes)
+    {
+        return (bytes + 7) & ~size_t(7);
+    }
+
+    // Byte offsets of the arrays in a chunk, from the start of its header.
+    struct ChunkLayout
+    {
+        size_t ids, times, positions, offsets, bytes;
+
+        ChunkLayout(TrajectoryEncoding encoding, size_t bodies, size_t frames)
+        {
+            ids = sizeof(TrajectoryChunkHeader);
+            times = ids + padded(bodies * sizeof(BodyId));
+            positions = times + frames * sizeof(double);
+            if (encoding == TrajectoryEncoding::Raw)
+            {
+                offsets = positions;
+                bytes = positions + frames * bodies * 3 * sizeof(double);
+            }
+            else
+            {
+                offsets = positions + bodies * 3 * sizeof(int64_t);
+                bytes = offsets + padded(frames * bodies * 3 * sizeof(int32_t));
+            }
+        }
+    };
+}
+
+TrajectoryWriter::~TrajectoryWriter()
+{
+    std::string error;
+    close(error);
+}
+
+bool TrajectoryWriter::open(const std::string& filePath, const TrajectoryOptions& trajectoryOptions, std::string& error)
+{
+    close(error);
+    error.clear();
+
+    if (trajectoryOptions.encoding == TrajectoryEncoding::Quantized && !(trajectoryOptions.quantum_m > 0.0))
+    {
+        error = "trajectory quantum must be positive";
+        return false;
+    }
+
+    file = std::fopen(filePath.c_str(), "wb");
+    if (!file)
+    {
+        error = "cannot write " + filePath;
+        return false;
+    }
+
+    options = trajectoryOptions;
+    options.chunkFrames = std::max<uint32_t>(options.chunkFrames, 1);
+    path = filePath;
+    chunk = Chunk();
+    frames = 0;
+    dropped = 0;
+    closing = false;
+    index.clear();
+    writeError.clear();
+    offset = 0;
+
+    TrajectoryHeader header;
+    std::memcpy(header.magic, FILE_MAGIC, sizeof(header.magic));
+    header.version = VERSION;
+    header.chunkFrames = options.chunkFrames;
+    if (!write(&header, sizeof(header)))
+    {
+        std::fclose(file);
+        file = nullptr;
+        error = writeError;
+        return false;
+    }
+
+    thread = std::thread(&TrajectoryWriter::writeLoop, this);
+    return true;
+}
+
+void TrajectoryWriter::append(double time_s, const BodySoA& bodies)
+{
+    if (!file)
+        return;
+
+    PROFILE_SCOPE("trajectory.append");
+
+    if (!encode(time_s, bodies))
+    {
+        submit(false);
+        encode(time_s, bodies);
+    }
+    ++frames;
+
+    if (chunk.header.frames >= options.chunkFrames)
+        submit(false);
+}
+
+bool TrajectoryWriter::close(std::string& error)
+{
+    if (!file)
+        return true;
+
+    submit(true);
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        closing = true;
+    }
+    queueReady.notify_all();
+    thread.join();
+
+    TrajectoryTrailer trailer;
+    std::memcpy(trailer.magic, INDEX_MAGIC, sizeof(trailer.magic));
+    trailer.chunks = index.size();
+    trailer.indexOffset = offset;
+    write(index.data(), index.size() * sizeof(TrajectoryIndexEntry));
+    write(&trailer, sizeof(trailer));
+
+    if (std::fclose(file) != 0 && writeError.empty())
+        writeError = "cannot write " + path;
+    file = nullptr;
+
+    if (dropped.load() > 0 && writeError.empty())
+        error = std::to_string(dropped.load()) + " chunks of " + path + " were dropped";
+    else
+        error = writeError;
+    return error.empty();
+}
+
+// Adds the frame to the open chunk, starting one if it is empty; false when
+// the frame needs a chunk of its own.
+bool TrajectoryWriter::encode(double time_s, const BodySoA& bodies)
+{
+    Chunk& c = chunk;
+    if (c.header.frames == 0)
+        startChunk(bodies);
+    else if (c.ids != bodies.id)
+        return false;
+
+    size_t n = bodies.size();
+    if (c.header.encoding == TrajectoryEncoding::Raw)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            c.raw.push_back(bodies.x[i]);
+            c.raw.push_back(bodies.y[i]);
+            c.raw.push_back(bodies.z[i]);
+        }
+    }
+    else
+    {
+        double inverse = 1.0 / c.header.quantum_m;
+        size_t first = c.offsets.size();
+        c.offsets.resize(first + n * 3);
+        int32_t* out = c.offsets.data() + first;
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            const double p[3] = { bodies.x[i], bodies.y[i], bodies.z[i] };
+            for (size_t a = 0; a < 3; ++a)
+            {
+                double quanta = std::nearbyint(p[a] * inverse) - static_cast<double>(c.key[i * 3 + a]);
+                if (!(std::abs(quanta) <= std::numeric_limits<int32_t>::max()))
+                {
+                    c.offsets.resize(first);
+                    return false;
+                }
+                out[i * 3 + a] = static_cast<int32_t>(quanta);
+            }
+        }
+    }
+
+    if (c.header.frames == 0)
+        c.header.start_s = time_s;
+    c.header.end_s = time_s;
+    c.times.push_back(time_s);
+    ++c.header.frames;
+    return true;
+}
+
+void TrajectoryWriter::startChunk(const BodySoA& bodies)
+{
+    size_t n = bodies.size();
+    Chunk& c = chunk;
+    c.header = TrajectoryChunkHeader();
+    c.header.magic = CHUNK_MAGIC;
+    c.header.encoding = options.encoding;
+    c.header.bodies = static_cast<uint32_t>(n);
+    c.header.quantum_m = options.encoding == TrajectoryEncoding::Quantized ? options.quantum_m : 0.0;
+    c.ids = bodies.id;
+    c.times.clear();
+    c.raw.clear();
+    c.key.clear();
+    c.offsets.clear();
+    c.times.reserve(options.chunkFrames);
+
+    if (c.header.encoding == TrajectoryEncoding::Quantized)
+    {
+        double inverse = 1.0 / c.header.quantum_m;
+        c.key.resize(n * 3);
+        for (size_t i = 0; i < n && !c.key.empty(); ++i)
+        {
+            const double p[3] = { bodies.x[i], bodies.y[i], bodies.z[i] };
+            for (size_t a = 0; a < 3; ++a)
+            {
+                // Positions out of the int64 range (or not finite) are kept exactly.
+                double quanta = std::nearbyint(p[a] * inverse);
+                if (!(std::abs(quanta) <= MAX_QUANTA))
+                {
+                    c.header.encoding = TrajectoryEncoding::Raw;
+                    c.header.quantum_m = 0.0;
+                    c.key.clear();
+                    break;
+                }
+                c.key[i * 3 + a] = static_cast<int64_t>(quanta);
+            }
+        }
+    }
+
+    if (c.header.encoding == TrajectoryEncoding::Raw)
+        c.raw.reserve(size_t(options.chunkFrames) * n * 3);
+    else
+        c.offsets.reserve(size_t(options.chunkFrames) * n * 3);
+}
+
+// Hands the open chunk to the writer thread. Unless wait is set, a chunk the
+// queue has no room for is dropped.
+void TrajectoryWriter::submit(bool wait)
+{
+    if (chunk.header.frames == 0)
+        return;
+
+    chunk.header.bytes = ChunkLayout(chunk.header.encoding, chunk.header.bodies, chunk.header.frames).bytes;
+    {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        if (wait)
+            queueReady.wait(lock, [this]() { return queue.size() < MAX_PENDING_CHUNKS; });
+
+        if (queue.size() < MAX_PENDING_CHUNKS)
+            queue.push_back(std::move(chunk));
+        else
+            ++dropped;
+    }
+    queueReady.notify_all();
+    chunk = Chunk();
+}
+
+void TrajectoryWriter::writeLoop()
+{
+    static const uint8_t zeros[8] = {};
+
+    for (;;)
+    {
+        Chunk c;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueReady.wait(lock, [this]() { return closing || !queue.empty(); });
+            if (queue.empty())
+                return;
+            c = std::move(queue.front());
+            queue.pop_front();
+        }
+        queueReady.notify_all();
+
+        ChunkLayout layout(c.header.encoding, c.header.bodies, c.header.frames);
+        size_t idsBytes = c.ids.size() * sizeof(BodyId);
+        size_t offsetsBytes = c.offsets.size() * sizeof(int32_t);
+
+        bool ok = write(&c.header, sizeof(c.header))
+            && write(c.ids.data(), idsBytes)
+            && write(zeros, layout.times - layout.ids - idsBytes)
+            && write(c.times.data(), c.times.size() * sizeof(double));
+        if (c.header.encoding == TrajectoryEncoding::Raw)
+        {
+            ok = ok && write(c.raw.data(), c.raw.size() * sizeof(double));
+        }
+        else
+        {
+            ok = ok && write(c.key.data(), c.key.size() * sizeof(int64_t))
+                && write(c.offsets.data(), offsetsBytes)
+                && write(zeros, layout.bytes - layout.offsets - offsetsBytes);
+        }
+
+        if (ok)
+        {
+            index.push_back({ c.header.start_s, c.header.end_s, offset - layout.bytes });
+        }
+    }
+}
+
+bool TrajectoryWriter::write(const void* data, size_t bytes)
+{
+    if (!writeError.empty())
+        return false;
+    if (bytes > 0 && std::fwrite(data, 1, bytes, file) != bytes)
+    {
+        writeError = "cannot write " + path;
+        return false;
+    }
+    offset += bytes;
+    return true;
+}
+
+bool TrajectoryReader::open(const std::string& path, std::string& error)
+{
+    close();
+    if (!file.open(path, error))
+        return false;
+
+    const uint8_t* data = file.data();
+    size_t size = file.size();
+
+    const TrajectoryHeader* header = reinterpret_cast<const TrajectoryHeader*>(data);
+    if (size < sizeof(TrajectoryHeader) || std::memcmp(header->magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0)
+    {
+        close();
+        error = path + " is not a trajectory file";
+        return false;
+    }
+    if (header->version != TrajectoryWriter::VERSION)
+    {
+        close();
+        error = path + ": unsupported trajectory version " + std::to_string(header->version);
+        return false;
+    }
+
+    auto validChunk = [&](uint64_t offset)
+    {
+        if (offset % 8 != 0 || offset > size || size - offset < sizeof(TrajectoryChunkHeader))
+            return false;
+        const TrajectoryChunkHeader* chunk = reinterpret_cast<const TrajectoryChunkHeader*>(data + offset);
+        if (chunk->magic != CHUNK_MAGIC || chunk->frames == 0
+            || (chunk->encoding != TrajectoryEncoding::Raw && chunk->encoding != TrajectoryEncoding::Quantized))
+            return false;
+        return chunk->bytes == ChunkLayout(chunk->encoding, chunk->bodies, chunk->frames).bytes
+            && chunk->bytes <= size - offset;
+    };
+
+    // The index written on close, else a walk over the chunk headers.
+    bool indexed = size >= sizeof(TrajectoryHeader) + sizeof(TrajectoryTrailer) && size % 8 == 0;
+    const TrajectoryTrailer* trailer = reinterpret_cast<const TrajectoryTrailer*>(data + size - sizeof(TrajectoryTrailer));
+    indexed = indexed && std::memcmp(trailer->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0
+        && trailer->indexOffset <= size
+        && trailer->chunks == (size - sizeof(TrajectoryTrailer) - trailer->indexOffset) / sizeof(TrajectoryIndexEntry);
+    if (indexed)
+    {
+        const TrajectoryIndexEntry* entries = reinterpret_cast<const TrajectoryIndexEntry*>(data + trailer->indexOffset);
+        chunks.assign(entries, entries + trailer->chunks);
+        for (const TrajectoryIndexEntry& entry : chunks)
+            indexed = indexed && validChunk(entry.offset);
+    }
+    if (!indexed)
+    {
+        chunks.clear();
+        uint64_t offset = sizeof(TrajectoryHeader);
+        while (validChunk(offset))
+        {
+            const TrajectoryChunkHeader* chunk = reinterpret_cast<const TrajectoryChunkHeader*>(data + offset);
+            chunks.push_back({ chunk->start_s, chunk->end_s, offset });
+            offset += chunk->bytes;
+        }
+    }
+
+    if (chunks.empty())
+    {
+        close();
+        error = path + " has no frames";
+        return false;
+    }
+    return true;
+}
+
+void TrajectoryReader::close()
+{
+    chunks.clear();
+    file.close();
+}
+
+glm::dvec3 TrajectoryReader::ChunkView::position(size_t frame, size_t body) const
+{
+    size_t k = (frame * header->bodies + body) * 3;
+    if (header->encoding == TrajectoryEncoding::Raw)
+        return glm::dvec3(raw[k], raw[k + 1], raw[k + 2]);
+
+    const int64_t* q = key + body * 3;
+    return glm::dvec3(static_cast<double>(q[0] + offsets[k]),
+                      static_cast<double>(q[1] + offsets[k + 1]),
+                      static_cast<double>(q[2] + offsets[k + 2])) * header->quantum_m;
+}
+
+TrajectoryReader::ChunkView TrajectoryReader::view(size_t chunk) const
+{
+    const uint8_t* base = file.data() + chunks[chunk].offset;
+    ChunkView v;
+    v.header = reinterpret_cast<const TrajectoryChunkHeader*>(base);
+
+    ChunkLayout layout(v.header->encoding, v.header->bodies, v.header->frames);
+    v.ids = reinterpret_cast<const BodyId*>(base + layout.ids);
+    v.times = reinterpret_cast<const double*>(base + layout.times);
+    if (v.header->encoding == TrajectoryEncoding::Raw)
+    {
+        v.raw = reinterpret_cast<const double*>(base + layout.positions);
+    }
+    else
+    {
+        v.key = reinterpret_cast<const int64_t*>(base + layout.positions);
+        v.offsets = reinterpret_cast<const int32_t*>(base + layout.offsets);
+    }
+    return v;
+}
+
+template <typename Visit>
+bool TrajectoryReader::visit(double time_s, Visit&& visitBody) const
+{
+    if (chunks.empty())
+        return false;
+
+    PROFILE_SCOPE("trajectory.sample");
+
+    auto after = std::upper_bound(chunks.begin(), chunks.end(), time_s,
+        [](double t, const TrajectoryIndexEntry& entry) { return t < entry.start_s; });
+    size_t c = after == chunks.begin() ? 0 : static_cast<size_t>(after - chunks.begin()) - 1;
+
+    ChunkView a = view(c);
+    size_t frames = a.header->frames;
+    size_t f = static_cast<size_t>(std::upper_bound(a.times, a.times + frames, time_s) - a.times);
+    f = f > 0 ? f - 1 : 0;
+
+    // The next frame may open the next chunk; blending needs the same bodies.
+    ChunkView b = a;
+    size_t    g = f + 1;
+    bool      blend = g < frames;
+    if (!blend && c + 1 < chunks.size())
+    {
+        b = view(c + 1);
+        g = 0;
+        blend = b.header->bodies == a.header->bodies
+            && std::memcmp(b.ids, a.ids, a.header->bodies * sizeof(BodyId)) == 0;
+    }
+
+    double alpha = 0.0;
+    if (blend)
+    {
+        double t0 = a.times[f];
+        double t1 = b.times[g];
+        alpha = t1 > t0 ? std::clamp((time_s - t0) / (t1 - t0), 0.0, 1.0) : 0.0;
+    }
+
+    for (size_t k = 0; k < a.header->bodies; ++k)
+    {
+        glm::dvec3 p = a.position(f, k);
+        if (alpha > 0.0)
+            p = glm::mix(p, b.position(g, k), alpha);
+        visitBody(k, a.ids[k], p);
+    }
+    return true;
+}
+
+bool TrajectoryReader::sample(double time_s, BodyRegistry& registry) const
+{
+    const std::vector<BodyId>& ids = registry.getIds();
+    std::vector<glm::vec3>& positions = registry.getPositions();
+
+    return visit(time_s, [&](size_t k, BodyId id, const glm::dvec3& p_m)
+        {
+            size_t i = k < ids.size() && ids[k] == id ? k : registry.indexOf(id);
+            if (i != BodyRegistry::NPOS)
+                positions[i] = glm::vec3(p_m / METERS_PER_WU);
+        });
+}
+
+bool TrajectoryReader::sample(double time_s, std::vector<BodyId>& ids, std::vector<glm::dvec3>& positions_m) const
+{
+    ids.clear();
+    positions_m.clear();
+
+    return visit(time_s, [&](size_t, BodyId id, const glm::dvec3& p_m)
+        {
+            ids.push_back(id);
+            positions_m.push_back(p_m);
+        });
+}
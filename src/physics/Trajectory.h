@@ -0,0 +1,183 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+#include "core/BodyRegistry.h"
+#include "core/MappedFile.h"
+#include "BodySoA.h"
+
+// Trajectory files hold body positions over time. All fields are
+// little-endian and every array starts on 8 bytes:
+//
+//   TrajectoryHeader
+//   chunk*            appended as they fill; each is self-describing
+//   index, trailer    written on close: one entry per chunk
+//
+// A chunk is a TrajectoryChunkHeader, the body ids, the frame times, then
+// the positions of every body in every frame, either as doubles or
+// quantized: one int64 keyframe per body (the first frame, in quanta) and
+// int32 offsets from it for each frame, rounded to the nearest quantum, so
+// every position is within quantum_m / 2 and any frame decodes on its own.
+// A chunk ends after chunkFrames frames, when the bodies change, or when an
+// offset would not fit. Files without the index (the writer never closed)
+// are read by walking the chunk headers.
+enum class TrajectoryEncoding : uint32_t
+{
+    Raw = 0,
+    Quantized = 1,
+};
+
+struct TrajectoryHeader
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t chunkFrames;
+};
+
+struct TrajectoryChunkHeader
+{
+    uint32_t magic;
+    TrajectoryEncoding encoding;
+    uint32_t bodies;
+    uint32_t frames;
+    double   start_s;
+    double   end_s;
+    double   quantum_m;
+    uint64_t bytes;   // whole chunk, header included
+};
+
+struct TrajectoryIndexEntry
+{
+    double   start_s;
+    double   end_s;
+    uint64_t offset;
+};
+
+struct TrajectoryTrailer
+{
+    char     magic[8];
+    uint64_t chunks;
+    uint64_t indexOffset;
+};
+
+struct TrajectoryOptions
+{
+    TrajectoryEncoding encoding = TrajectoryEncoding::Quantized;
+    double   quantum_m = 1000.0;
+    uint32_t chunkFrames = 256;
+};
+
+// Appends frames from the simulation thread. Frames are encoded in place
+// and a full chunk is handed to a writer thread, so append never waits for
+// the disk; if the disk falls MAX_PENDING_CHUNKS behind, chunks are dropped
+// and counted rather than stalling the caller.
+class TrajectoryWriter
+{
+public:
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t   MAX_PENDING_CHUNKS = 64;
+
+    TrajectoryWriter() = default;
+    ~TrajectoryWriter();
+
+    TrajectoryWriter(const TrajectoryWriter&) = delete;
+    TrajectoryWriter& operator=(const TrajectoryWriter&) = delete;
+
+    bool open(const std::string& path, const TrajectoryOptions& options, std::string& error);
+
+    // Times must increase.
+    void append(double time_s, const BodySoA& bodies);
+
+    // Writes what is left and the index; false when any write failed.
+    bool close(std::string& error);
+
+    bool isOpen() const { return file != nullptr; }
+    const std::string& getPath() const { return path; }
+    uint64_t framesAppended() const { return frames; }
+    uint64_t chunksDropped() const  { return dropped.load(); }
+
+private:
+    struct Chunk
+    {
+        TrajectoryChunkHeader header;
+        std::vector<BodyId>   ids;
+        std::vector<double>   times;
+        std::vector<double>   raw;      // x, y, z per body per frame
+        std::vector<int64_t>  key;      // x, y, z per body
+        std::vector<int32_t>  offsets;  // x, y, z per body per frame
+    };
+
+    TrajectoryOptions options;
+    std::string path;
+    std::FILE*  file = nullptr;
+    Chunk       chunk;
+    uint64_t    frames = 0;
+
+    std::mutex              queueMutex;
+    std::condition_variable queueReady;
+    std::deque<Chunk>       queue;
+    bool                    closing = false;
+    std::thread             thread;
+    std::atomic<uint64_t>   dropped{ 0 };
+
+    // Writer thread only until it is joined.
+    std::vector<TrajectoryIndexEntry> index;
+    uint64_t    offset = 0;
+    std::string writeError;
+
+    bool encode(double time_s, const BodySoA& bodies);
+    void startChunk(const BodySoA& bodies);
+    void submit(bool wait);
+    void writeLoop();
+    bool write(const void* data, size_t bytes);
+};
+
+// Plays a trajectory file back from a memory map. Finding the frames around
+// a time is two binary searches, over the chunk index and then the chunk's
+// frame times, and positions are decoded straight from the mapped pages.
+class TrajectoryReader
+{
+public:
+    bool open(const std::string& path, std::string& error);
+    void close();
+
+    bool   isOpen() const     { return !chunks.empty(); }
+    double startTime() const  { return chunks.empty() ? 0.0 : chunks.front().start_s; }
+    double endTime() const    { return chunks.empty() ? 0.0 : chunks.back().end_s; }
+    size_t chunkCount() const { return chunks.size(); }
+
+    // Positions at time_s, blended between the frames on either side and
+    // held at the ends. The registry overload writes world units into the
+    // bodies it has, matched by id; the other lists every recorded body.
+    bool sample(double time_s, BodyRegistry& registry) const;
+    bool sample(double time_s, std::vector<BodyId>& ids, std::vector<glm::dvec3>& positions_m) const;
+
+private:
+    struct ChunkView
+    {
+        const TrajectoryChunkHeader* header = nullptr;
+        const BodyId*  ids = nullptr;
+        const double*  times = nullptr;
+        const double*  raw = nullptr;
+        const int64_t* key = nullptr;
+        const int32_t* offsets = nullptr;
+
+        glm::dvec3 position(size_t frame, size_t body) const;
+    };
+
+    MappedFile file;
+    std::vector<TrajectoryIndexEntry> chunks;
+
+    ChunkView view(size_t chunk) const;
+
+    template <typename Visit>
+    bool visit(double time_s, Visit&& visitBody) const;
+};
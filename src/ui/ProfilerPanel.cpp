@@ -0,0 +1,248 @@
+#include "ProfilerPanel.h"
+#include "imgui/imgui.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+    constexpr int HISTOGRAM_BINS = 40;
+
+    float percentile(const std::vector<float> &sorted, double q) {
+        if (sorted.empty()) {
+            return 0.0f;
+        }
+        size_t i = static_cast<size_t>(q * (sorted.size() - 1) + 0.5);
+        return sorted[std::min(i, sorted.size() - 1)];
+    }
+
+    ImU32 scopeColor(size_t index) {
+        float hue = std::fmod(index * 0.618034f, 1.0f);
+        return ImColor::HSV(hue, 0.55f, 0.9f);
+    }
+}
+
+void ProfilerPanel::render(bool *open) {
+    ImGui::SetNextWindowSize(ImVec2(560.0f, 520.0f), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Profiler", open)) {
+        ImGui::End();
+        return;
+    }
+
+    if (!PROFILE_ENABLED) {
+        ImGui::TextWrapped("Built without timers. Configure with -DSOLARSIM_PROFILE=ON to record them.");
+        ImGui::End();
+        return;
+    }
+
+    collect();
+
+    ImGui::Text("Frames: %zu   Dropped events: %llu", frames,
+        static_cast<unsigned long long>(Profiler::global().dropped()));
+    if (ImGui::Button("Write Trace")) {
+        std::vector<ProfileEvent> events(recent.begin(), recent.end());
+        std::string error;
+        if (writeChromeTrace(TRACE_PATH, events, threads, error)) {
+            traceMessage = "Wrote " + std::to_string(events.size()) + " events to " + TRACE_PATH;
+        }
+        else {
+            traceMessage = error;
+        }
+    }
+    ImGui::SameLine();
+    ImGui::TextUnformatted(traceMessage.c_str());
+
+    renderChart();
+    renderTable();
+    if (selected >= 0 && static_cast<size_t>(selected) < scopes.size()) {
+        renderHistogram(scopes[selected]);
+    }
+
+    ImGui::End();
+}
+
+void ProfilerPanel::collect() {
+    drained.clear();
+    Profiler::global().drain(drained);
+    threads = Profiler::global().threadNames();
+
+    size_t slot = frames % HISTORY;
+    for (Scope &scope : scopes) {
+        scope.frame_ms[slot] = 0.0f;
+    }
+
+    for (const ProfileEvent &e : drained) {
+        auto key = std::make_pair(e.name, e.thread);
+        auto found = scopeIndex.find(key);
+        if (found == scopeIndex.end()) {
+            Scope scope;
+            scope.name = e.name;
+            scope.thread = e.thread;
+            scope.depth = e.depth;
+            found = scopeIndex.emplace(key, scopes.size()).first;
+            scopes.push_back(std::move(scope));
+        }
+
+        Scope &scope = scopes[found->second];
+        float ms = static_cast<float>((e.end_ns - e.start_ns) * 1e-6);
+        scope.frame_ms[slot] += ms;
+        if (scope.samples_ms.size() < SAMPLES) {
+            scope.samples_ms.push_back(ms);
+        }
+        else {
+            scope.samples_ms[scope.nextSample] = ms;
+        }
+        scope.nextSample = (scope.nextSample + 1) % SAMPLES;
+        ++scope.calls;
+    }
+
+    recent.insert(recent.end(), drained.begin(), drained.end());
+    while (recent.size() > TRACE_EVENTS) {
+        recent.pop_front();
+    }
+
+    ++frames;
+}
+
+// Outermost scopes of one thread, stacked per frame, newest on the right.
+void ProfilerPanel::renderChart() {
+    if (threads.empty()) {
+        return;
+    }
+    if (chartThread < 0 || static_cast<size_t>(chartThread) >= threads.size()) {
+        auto render = std::find(threads.begin(), threads.end(), "render");
+        chartThread = render != threads.end() ? static_cast<int>(render - threads.begin()) : 0;
+    }
+
+    if (ImGui::BeginCombo("Thread", threads[chartThread].c_str())) {
+        for (size_t t = 0; t < threads.size(); ++t) {
+            if (ImGui::Selectable(threads[t].c_str(), static_cast<int>(t) == chartThread)) {
+                chartThread = static_cast<int>(t);
+            }
+        }
+        ImGui::EndCombo();
+    }
+
+    std::vector<size_t> stack;
+    for (size_t i = 0; i < scopes.size(); ++i) {
+        if (scopes[i].thread == chartThread && scopes[i].depth == 0) {
+            stack.push_back(i);
+        }
+    }
+
+    size_t count = std::min(frames, HISTORY);
+    float top = 1.0f;
+    for (size_t f = 0; f < count; ++f) {
+        float total = 0.0f;
+        for (size_t i : stack) {
+            total += scopes[i].frame_ms[f];
+        }
+        top = std::max(top, total);
+    }
+
+    ImVec2 size(ImGui::GetContentRegionAvail().x, 120.0f);
+    ImVec2 origin = ImGui::GetCursorScreenPos();
+    ImGui::InvisibleButton("##chart", size);
+    ImDrawList *draw = ImGui::GetWindowDrawList();
+    draw->AddRectFilled(origin, ImVec2(origin.x + size.x, origin.y + size.y), IM_COL32(20, 20, 24, 255));
+
+    float barWidth = size.x / HISTORY;
+    float scale = size.y / top;
+    int hoveredFrame = -1;
+    for (size_t f = 0; f < count; ++f) {
+        size_t slot = (frames - count + f) % HISTORY;
+        float x = origin.x + (HISTORY - count + f) * barWidth;
+        float y = origin.y + size.y;
+        for (size_t i : stack) {
+            float height = scopes[i].frame_ms[slot] * scale;
+            draw->AddRectFilled(ImVec2(x, y - height), ImVec2(x + std::max(barWidth - 1.0f, 1.0f), y), scopeColor(i));
+            y -= height;
+        }
+        if (ImGui::IsItemHovered() && ImGui::GetIO().MousePos.x >= x && ImGui::GetIO().MousePos.x < x + barWidth) {
+            hoveredFrame = static_cast<int>(slot);
+        }
+    }
+    draw->AddText(ImVec2(origin.x + 4.0f, origin.y + 2.0f), IM_COL32(200, 200, 200, 255),
+        (std::to_string(static_cast<int>(std::ceil(top))) + " ms").c_str());
+
+    if (hoveredFrame >= 0) {
+        ImGui::BeginTooltip();
+        for (size_t i : stack) {
+            ImGui::Text("%s: %.3f ms", scopes[i].name, scopes[i].frame_ms[hoveredFrame]);
+        }
+        ImGui::EndTooltip();
+    }
+}
+
+void ProfilerPanel::renderTable() {
+    ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY;
+    if (!ImGui::BeginTable("##scopes", 7, flags, ImVec2(0.0f, 200.0f))) {
+        return;
+    }
+
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn("Scope");
+    ImGui::TableSetupColumn("Thread");
+    ImGui::TableSetupColumn("ms/frame");
+    ImGui::TableSetupColumn("p50");
+    ImGui::TableSetupColumn("p90");
+    ImGui::TableSetupColumn("p99");
+    ImGui::TableSetupColumn("Calls");
+    ImGui::TableHeadersRow();
+
+    size_t count = std::max<size_t>(std::min(frames, HISTORY), 1);
+    std::vector<float> sorted;
+    for (size_t i = 0; i < scopes.size(); ++i) {
+        const Scope &scope = scopes[i];
+        float total = 0.0f;
+        for (float ms : scope.frame_ms) {
+            total += ms;
+        }
+        sorted = scope.samples_ms;
+        std::sort(sorted.begin(), sorted.end());
+
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::PushID(static_cast<int>(i));
+        ImGui::ColorButton("##color", ImColor(scopeColor(i)), ImGuiColorEditFlags_NoTooltip, ImVec2(10.0f, 10.0f));
+        ImGui::SameLine();
+        if (ImGui::Selectable(scope.name, selected == static_cast<int>(i), ImGuiSelectableFlags_SpanAllColumns)) {
+            selected = static_cast<int>(i);
+        }
+        ImGui::PopID();
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(scope.thread < threads.size() ? threads[scope.thread].c_str() : "?");
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", total / count);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", percentile(sorted, 0.50));
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", percentile(sorted, 0.90));
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", percentile(sorted, 0.99));
+        ImGui::TableNextColumn();
+        ImGui::Text("%llu", static_cast<unsigned long long>(scope.calls));
+    }
+
+    ImGui::EndTable();
+}
+
+void ProfilerPanel::renderHistogram(const Scope &scope) {
+    if (scope.samples_ms.empty()) {
+        return;
+    }
+
+    auto range = std::minmax_element(scope.samples_ms.begin(), scope.samples_ms.end());
+    float low = *range.first;
+    float width = std::max((*range.second - low) / HISTOGRAM_BINS, 1e-6f);
+
+    float bins[HISTOGRAM_BINS] = {};
+    for (float ms : scope.samples_ms) {
+        int bin = std::min(static_cast<int>((ms - low) / width), HISTOGRAM_BINS - 1);
+        bins[bin] += 1.0f;
+    }
+
+    char label[96];
+    std::snprintf(label, sizeof(label), "%s: %.3f .. %.3f ms", scope.name, low, *range.second);
+    ImGui::PlotHistogram("##histogram", bins, HISTOGRAM_BINS, 0, label, 0.0f, FLT_MAX, ImVec2(-1.0f, 80.0f));
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include "core/Profiler.h"
+
+// Drains the profiler once a frame while it is open. Shows the time each
+// scope took per frame, stacked for one thread, and the percentiles and
+// histogram of single calls. The most recent events can be written as a
+// Chrome trace.
+class ProfilerPanel {
+public:
+    static constexpr size_t HISTORY = 240;            // frames in the chart
+    static constexpr size_t SAMPLES = 1024;           // single calls kept per scope
+    static constexpr size_t TRACE_EVENTS = 1 << 18;   // events kept for export
+    static constexpr const char *TRACE_PATH = "profile_trace.json";
+
+    void render(bool *open);
+
+private:
+    struct Scope {
+        const char *name = nullptr;
+        uint16_t thread = 0;
+        uint16_t depth = 0;                 // of the first call seen
+        std::vector<float> frame_ms = std::vector<float>(HISTORY, 0.0f);
+        std::vector<float> samples_ms;      // ring of single calls
+        size_t nextSample = 0;
+        uint64_t calls = 0;
+    };
+
+    std::vector<Scope> scopes;
+    std::map<std::pair<const char *, uint16_t>, size_t> scopeIndex;
+    std::vector<ProfileEvent> drained;
+    std::deque<ProfileEvent> recent;
+    std::vector<std::string> threads;
+    size_t frames = 0;
+    int chartThread = -1;   // the render thread once it has recorded
+    int selected = -1;
+    std::string traceMessage;
+
+    void collect();
+    void renderChart();
+    void renderTable();
+    void renderHistogram(const Scope &scope);
+};
@@ -1,10 +1,37 @@
+#define _USE_MATH_DEFINES
 #include "UIManager.h"
 #include "imgui/imgui.h"
+#include "core/Constants.h"
+#include "core/ThreadPool.h"
+#include <cmath>
+#include <cstdio>
 #include <cstring>
 #include <algorithm>
 
-void UIManager::render(Window& window, Camera& camera, float deltaTime,
-    std::vector<std::shared_ptr<Planet>>& planets, Grid& grid) {
+namespace {
+    size_t heaviestBody(const BodySoA& bodies) {
+        size_t central = 0;
+        for (size_t i = 1; i < bodies.size(); ++i) {
+            if (bodies.mass[i] > bodies.mass[central]) central = i;
+        }
+        return central;
+    }
+
+    float orbitDistance(const BodyRegistry& bodies, size_t i) {
+        return std::max(50.0f, bodies.getRadius(i) * 4.0f);
+    }
+}
+
+void UIManager::render(Window& window, Camera& camera, float deltaTime, BodyRegistry& bodies, Grid& grid,
+    SimulationThread& simulation, const Bvh& bvh) {
+
+    size_t target = bodies.indexOf(orbitTarget);
+    if (target == BodyRegistry::NPOS || camera.getMode() != CameraMode::ORBITAL || !camera.hasOrbitalTarget()) {
+        orbitTarget = BodyRegistry::NONE;
+    }
+    else {
+        camera.moveOrbitalTarget(bodies.getPositions()[target]);
+    }
 
     int width, height;
     glfwGetFramebufferSize(window.getGLFWwindow(), &width, &height);
@@ -12,27 +39,54 @@ void UIManager::render(Window& window, Camera& camera, float deltaTime,
     float aspect = static_cast<float>(width) / std::max(height, 1);
     glm::mat4 projection = glm::perspective(glm::radians(45.0f), aspect, 0.1f, 20000.0f);
 
-    renderNavbar(planets);
-    renderPlanetPopup(window, camera, view, projection, planets);
-    renderMainPanel(deltaTime, planets, grid);
-
-    if (selectedPlanetIndex >= 0 && selectedPlanetIndex < planets.size()) {
-        auto& planet = planets[selectedPlanetIndex];
+    renderNavbar(bodies, simulation);
+    renderPlanetPopup(window, camera, view, projection, bodies, bvh);
+    renderRegionSelect(projection * view, bvh, bodies);
+    renderMainPanel(deltaTime, bodies, grid, simulation);
 
-        if (selectedPlanetIndex != lastSelectedIndex) {
-            strncpy_s(editBuffer.name, sizeof(editBuffer.name), planet->getName().c_str(), _TRUNCATE);
-            editBuffer.mass = planet->getMass();
-            editBuffer.density = planet->getDensity();
-            editBuffer.position = planet->getPosition();
-            editBuffer.velocity = planet->getVelocity();
-            lastSelectedIndex = selectedPlanetIndex;
+    size_t selected = bodies.indexOf(selectedBody);
+    if (selected != BodyRegistry::NPOS) {
+        if (selectedBody != lastSelectedBody) {
+            loadEditBuffer(bodies, selected, simulation.snapshot());
+            lastSelectedBody = selectedBody;
         }
 
-        renderPlanetInfo(planet, camera);
+        renderPlanetInfo(bodies, selected, camera, simulation);
     }
+
+    if (showProfiler) {
+        profiler.render(&showProfiler);
+    }
+}
+
+void UIManager::loadEditBuffer(const BodyRegistry& bodies, size_t i, const BodySnapshot& snapshot) {
+    strncpy_s(editBuffer.name, sizeof(editBuffer.name), bodies.getNames()[i].c_str(), _TRUNCATE);
+    editBuffer.mass = static_cast<float>(bodies.getMasses()[i]);
+    editBuffer.density = static_cast<float>(bodies.getDensities()[i]);
+    editBuffer.position = bodies.getPositions()[i];
+
+    auto found = std::find(snapshot.ids.begin(), snapshot.ids.end(), bodies.getIds()[i]);
+    editBuffer.velocity = found != snapshot.ids.end() ? snapshot.velocity_m_s[found - snapshot.ids.begin()] : glm::vec3(0.0f);
+}
+
+// The registry forgets the body at once; the physics thread drops it before
+// its next step.
+void UIManager::removeBody(BodyId id, BodyRegistry& bodies, SimulationThread& simulation) {
+    if (!bodies.remove(id)) {
+        return;
+    }
+    simulation.post([id](SimulationThread::State& state) {
+        size_t i = state.bodies.find(id);
+        if (i < state.bodies.size()) {
+            state.bodies.swapRemove(i);
+        }
+    });
+
+    selection.erase(std::remove(selection.begin(), selection.end(), id), selection.end());
+    hoveredIndex = -1;
 }
 
-void UIManager::renderPlanetPopup(Window& window, Camera& camera, const glm::mat4& view, const glm::mat4& projection, const std::vector<std::shared_ptr<Planet>>& planets)
+void UIManager::renderPlanetPopup(Window& window, Camera& camera, const glm::mat4& view, const glm::mat4& projection, const BodyRegistry& bodies, const Bvh& bvh)
 {
     double mouseX, mouseY;
     glfwGetCursorPos(window.getGLFWwindow(), &mouseX, &mouseY);
@@ -46,25 +100,15 @@ void UIManager::renderPlanetPopup(Window& window, Camera& camera, const glm::mat
         return;
     }
 
-    hoveredIndex = -1;
-    float minDist2 = std::numeric_limits<float>::max();
-    for (size_t i = 0; i < planets.size(); ++i) {
-        if (planets[i]->intersectsRay(rayOrig, rayDir)) {
-            glm::vec3 d = planets[i]->getPosition() - rayOrig;
-            float d2 = glm::dot(d, d);
-            if (d2 < minDist2) {
-                minDist2 = d2;
-                hoveredIndex = static_cast<int>(i);
-            }
-        }
-    }
+    uint32_t hit = bvh.raycast(rayOrig, rayDir);
+    hoveredIndex = hit != Bvh::NONE && hit < bodies.size() ? static_cast<int>(hit) : -1;
     if (hoveredIndex != -1) {
-        glm::vec3 worldAbove = planets[hoveredIndex]->getPosition() + glm::vec3(0.0f, planets[hoveredIndex]->getRadius(), 0.0f);
+        glm::vec3 worldAbove = bodies.getPositions()[hoveredIndex] + glm::vec3(0.0f, bodies.getRadius(hoveredIndex), 0.0f);
         glm::vec2 screenPos = camera.worldToScreen(worldAbove, view, projection, width, height);
         if (screenPos.x > 0 && screenPos.y > 0 && screenPos.x < width && screenPos.y < height) {
             ImGui::SetNextWindowPos(ImVec2(screenPos.x, screenPos.y));
             ImGui::Begin("##planet_label", nullptr, ImGuiWindowFlags_NoBackground | ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_AlwaysAutoResize);
-            ImGui::Text("%s", planets[hoveredIndex]->getName().c_str());
+            ImGui::Text("%s", bodies.getNames()[hoveredIndex].c_str());
             ImGui::End();
         }
     }
@@ -73,45 +117,142 @@ void UIManager::renderPlanetPopup(Window& window, Camera& camera, const glm::mat
     }
 
 
-    if (glfwGetMouseButton(window.getGLFWwindow(), GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS) {
-        selectedPlanetIndex = hoveredIndex;
-        auto& selectedPlanet = planets[hoveredIndex];
-
-        float distance = std::max(50.0f, selectedPlanet->getRadius() * 4.0f);
+    bool regionModifier = ImGui::GetIO().KeyShift || ImGui::GetIO().KeyCtrl;
+    if (!regionModifier && glfwGetMouseButton(window.getGLFWwindow(), GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS) {
+        selectedBody = bodies.getIds()[hoveredIndex];
+        glm::vec3 position = bodies.getPositions()[hoveredIndex];
+        float distance = orbitDistance(bodies, hoveredIndex);
 
         if (camera.getMode() == CameraMode::ORBITAL) {
-            camera.setOrbitalTarget(selectedPlanet->getPositionPtr(), distance);
+            camera.setOrbitalTarget(position, distance);
+            orbitTarget = selectedBody;
+        }
+        else {
+            camera.startSmoothMove(position, distance);
+        }
+    }
+}
+
+// Screen points are kept in ImGui's display coordinates and turned into NDC
+// for the queries; the selected bodies get a ring drawn over the scene.
+void UIManager::renderRegionSelect(const glm::mat4& viewProjection, const Bvh& bvh, const BodyRegistry& bodies) {
+    ImGuiIO& io = ImGui::GetIO();
+    ImDrawList* drawList = ImGui::GetForegroundDrawList();
+    glm::vec2 mouse(io.MousePos.x, io.MousePos.y);
+    glm::vec2 display(std::max(io.DisplaySize.x, 1.0f), std::max(io.DisplaySize.y, 1.0f));
+
+    if (!regionDragging) {
+        if ((io.KeyShift || io.KeyCtrl) && !io.WantCaptureMouse && ImGui::IsMouseClicked(ImGuiMouseButton_Left)) {
+            regionDragging = true;
+            regionLasso = io.KeyCtrl;
+            regionPoints.assign(1, mouse);
+        }
+    }
+    else if (ImGui::IsMouseDown(ImGuiMouseButton_Left)) {
+        if (!regionLasso) {
+            regionPoints.resize(2);
+            regionPoints[1] = mouse;
+        }
+        else if (glm::distance(regionPoints.back(), mouse) > 3.0f) {
+            regionPoints.push_back(mouse);
+        }
+    }
+    else {
+        regionDragging = false;
+
+        std::vector<glm::vec2> polygon;
+        for (const glm::vec2& p : regionPoints) {
+            polygon.emplace_back(2.0f * p.x / display.x - 1.0f, 1.0f - 2.0f * p.y / display.y);
+        }
+
+        std::vector<uint32_t> inside;
+        if (!regionLasso && polygon.size() == 2 && polygon[0].x != polygon[1].x && polygon[0].y != polygon[1].y) {
+            bvh.selectCenters(Frustum::fromRect(viewProjection, glm::min(polygon[0], polygon[1]),
+                glm::max(polygon[0], polygon[1])), inside);
+        }
+        else if (regionLasso && polygon.size() >= 3) {
+            bvh.selectPolygon(viewProjection, polygon, inside);
+        }
+        std::sort(inside.begin(), inside.end());
+
+        selection.clear();
+        for (uint32_t i : inside) {
+            if (i < bodies.size()) {
+                selection.push_back(bodies.getIds()[i]);
+            }
+        }
+    }
+
+    ImU32 outline = IM_COL32(120, 200, 255, 230);
+    if (regionDragging && regionPoints.size() >= 2) {
+        if (regionLasso) {
+            std::vector<ImVec2> points(regionPoints.size());
+            for (size_t i = 0; i < regionPoints.size(); ++i) {
+                points[i] = ImVec2(regionPoints[i].x, regionPoints[i].y);
+            }
+            drawList->AddPolyline(points.data(), static_cast<int>(points.size()), outline, ImDrawFlags_Closed, 1.5f);
         }
         else {
-            camera.startSmoothMove(selectedPlanet->getPosition(), distance);
+            ImVec2 a(regionPoints[0].x, regionPoints[0].y);
+            ImVec2 b(regionPoints[1].x, regionPoints[1].y);
+            drawList->AddRectFilled(ImVec2(std::min(a.x, b.x), std::min(a.y, b.y)),
+                ImVec2(std::max(a.x, b.x), std::max(a.y, b.y)), IM_COL32(120, 200, 255, 40));
+            drawList->AddRect(ImVec2(std::min(a.x, b.x), std::min(a.y, b.y)),
+                ImVec2(std::max(a.x, b.x), std::max(a.y, b.y)), outline, 0.0f, 0, 1.5f);
+        }
+    }
+
+    for (size_t k = 0; k < std::min(selection.size(), MAX_SELECTION_MARKERS); ++k) {
+        size_t i = bodies.indexOf(selection[k]);
+        if (i == BodyRegistry::NPOS) {
+            continue;
+        }
+        glm::vec4 clip = viewProjection * glm::vec4(bodies.getPositions()[i], 1.0f);
+        if (clip.w <= 0.0f) {
+            continue;
         }
+        glm::vec2 ndc = glm::vec2(clip) / clip.w;
+        drawList->AddCircle(ImVec2((ndc.x * 0.5f + 0.5f) * display.x, (0.5f - ndc.y * 0.5f) * display.y), 6.0f, outline);
     }
 }
 
-void UIManager::renderPlanetInfo(std::shared_ptr<Planet>& planet, Camera& camera) {
+void UIManager::renderPlanetInfo(BodyRegistry& bodies, size_t i, Camera& camera, SimulationThread& simulation) {
     ImGui::Begin("Planet Info");
 
+    BodyId id = bodies.getIds()[i];
     ImGui::InputText("Name", editBuffer.name, sizeof(editBuffer.name));
     ImGui::InputFloat("Mass (kg)", &editBuffer.mass, 0.0f, 0.0f, "%.3e");
     ImGui::InputFloat("Density (kg/m³)", &editBuffer.density);
     ImGui::InputFloat3("Position", &editBuffer.position[0]);
-    ImGui::InputFloat3("Velocity", &editBuffer.velocity[0]);
+    ImGui::InputFloat3("Velocity (m/s)", &editBuffer.velocity[0]);
+
+    if (ImGui::Button("Apply Changes") && editBuffer.mass > 0.0f && editBuffer.density > 0.0f) {
+        bodies.setName(i, editBuffer.name);
+        bodies.setMass(i, editBuffer.mass, editBuffer.density);
+        bodies.getPositions()[i] = editBuffer.position;
 
-    if (ImGui::Button("Apply Changes")) {
-        planet->setName(editBuffer.name);
-        planet->setMass(editBuffer.mass);
-        planet->setDensity(editBuffer.density);
-        planet->setPosition(editBuffer.position);
-        planet->setVelocity(editBuffer.velocity);
-        planet->recalculateGeometry();
+        BodyState body;
+        body.pos_m = glm::dvec3(editBuffer.position) * METERS_PER_WU;
+        body.vel_m = glm::dvec3(editBuffer.velocity);
+        body.mass_kg = editBuffer.mass;
+        body.radius_m = bodies.getRadius_m(i);
+        body.id = id;
+        simulation.post([body](SimulationThread::State& state) {
+            size_t k = state.bodies.find(body.id);
+            if (k < state.bodies.size()) {
+                state.bodies.set(k, body);
+            }
+        });
     }
     ImGui::SameLine();
     if (ImGui::Button("Reset")) {
-        strncpy_s(editBuffer.name, sizeof(editBuffer.name), planet->getName().c_str(), _TRUNCATE);
-        editBuffer.mass = planet->getMass();
-        editBuffer.density = planet->getDensity();
-        editBuffer.position = planet->getPosition();
-        editBuffer.velocity = planet->getVelocity();
+        loadEditBuffer(bodies, i, simulation.snapshot());
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Remove")) {
+        removeBody(id, bodies, simulation);
+        ImGui::End();
+        return;
     }
 
     ImGui::Separator();
@@ -120,52 +261,434 @@ void UIManager::renderPlanetInfo(std::shared_ptr<Planet>& planet, Camera& camera
     ImGui::Text("Camera Mode");
     int currentMode = static_cast<int>(camera.getMode());
 
-    if (camera.getMode() == CameraMode::ORBITAL && camera.getOrbitalTarget() != planet->getPositionPtr()) {
+    if (camera.getMode() == CameraMode::ORBITAL && orbitTarget != id) {
         currentMode = static_cast<int>(CameraMode::FREE);
     }
 
     if (ImGui::RadioButton("Free", currentMode == static_cast<int>(CameraMode::FREE))) {
         camera.setMode(CameraMode::FREE);
+        orbitTarget = BodyRegistry::NONE;
     }
     ImGui::SameLine();
     if (ImGui::RadioButton("Orbital", currentMode == static_cast<int>(CameraMode::ORBITAL))) {
         camera.setMode(CameraMode::ORBITAL);
-        float distance = std::max(50.0f, planet->getRadius() * 4.0f);
-        camera.setOrbitalTarget(planet->getPositionPtr(), distance);
+        camera.setOrbitalTarget(bodies.getPositions()[i], orbitDistance(bodies, i));
+        orbitTarget = id;
     }
 
     ImGui::End();
 }
 
-void UIManager::renderMainPanel(float deltaTime, std::vector<std::shared_ptr<Planet>>& planets, Grid& grid) {
+void UIManager::applyMerge(const MergeEvent &merge, BodyRegistry &bodies, Camera &camera) {
+    if (merge.survivorId == merge.absorbedId) {
+        return;
+    }
+
+    size_t survivor = bodies.indexOf(merge.survivorId);
+    if (survivor != BodyRegistry::NPOS) {
+        double density = bodies.getDensities()[survivor];
+        if (merge.radius_m > 0.0) {
+            double volume = 4.0 / 3.0 * M_PI * merge.radius_m * merge.radius_m * merge.radius_m;
+            density = merge.mass_kg / volume;
+        }
+        bodies.setMass(survivor, merge.mass_kg, density);
+
+        if (orbitTarget == merge.absorbedId) {
+            camera.setOrbitalTarget(bodies.getPositions()[survivor], orbitDistance(bodies, survivor));
+            orbitTarget = merge.survivorId;
+        }
+    }
+    bodies.remove(merge.absorbedId);
+
+    auto remap = [&](BodyId id) { return id == merge.absorbedId ? merge.survivorId : id; };
+    selectedBody = remap(selectedBody);
+    lastSelectedBody = remap(lastSelectedBody);
+    hoveredIndex = -1;
+
+    for (BodyId &id : selection) {
+        id = remap(id);
+    }
+    std::sort(selection.begin(), selection.end());
+    selection.erase(std::unique(selection.begin(), selection.end()), selection.end());
+}
+
+void UIManager::renderMainPanel(float deltaTime, BodyRegistry& bodies, Grid& grid, SimulationThread& simulation) {
     ImGui::Begin("Solar System");
     ImGui::Text("FPS: %.1f", 1.0f / deltaTime);
     ImGui::Spacing();
     if (ImGui::Button("Add Planet")) {
-        planets.push_back(std::make_shared<Planet>(
-            "New Planet", 1.0e24f, 3000.0f,
-            glm::vec3(planets.size() * 200.0f, 0.0f, 0.0f),
-            glm::vec3(0.0f),
-            glm::vec3(0.8f, 0.8f, 0.9f)
-        ));
+        BodyState body;
+        body.pos_m = glm::dvec3(bodies.size() * 200.0 * METERS_PER_WU, 0.0, 0.0);
+        body.vel_m = glm::dvec3(0.0);
+        body.mass_kg = 1.0e24;
+        body.radius_m = sphereRadius_m(body.mass_kg, 3000.0);
+        body.id = bodies.add("New Planet", body, glm::vec3(0.8f, 0.8f, 0.9f));
+
+        // Starts on a circular orbit around the most massive body.
+        simulation.post([body](SimulationThread::State& state) {
+            BodyState added = body;
+            if (state.bodies.size() > 0) {
+                BodyState central = state.bodies.get(heaviestBody(state.bodies));
+                glm::dvec3 r = added.pos_m - central.pos_m;
+                glm::dvec3 direction = glm::cross(r, glm::dvec3(0.0, 1.0, 0.0));
+                if (glm::length(direction) > 0.0) {
+                    double speed = std::sqrt(PhysicsSystem::G * central.mass_kg / glm::length(r));
+                    added.vel_m = central.vel_m + glm::normalize(direction) * speed;
+                }
+            }
+            state.bodies.push_back(added);
+        });
+    }
+
+    const BodySnapshot& snapshot = simulation.snapshot();
+
+    ImGui::Separator();
+    ImGui::Text("Simulation");
+    ImGui::Text("Time: %.1f days", snapshot.simTime_s / 86400.0);
+    ImGui::Text("Steps/s: %.0f", snapshot.stepsPerSecond);
+    ImGui::Text("Force evals/step: %.1f", snapshot.evaluationsPerStep);
+
+    // Integrates at the fixed step on the physics thread while the view
+    // keeps showing the state the jump started from.
+    JumpStatus jump = simulation.jumpStatus();
+    if (jump.active) {
+        char label[64];
+        std::snprintf(label, sizeof(label), "Day %.0f / %.0f", jump.reached_s / 86400.0, jump.to_s / 86400.0);
+        ImGui::ProgressBar(static_cast<float>(jump.progress()), ImVec2(-1.0f, 0.0f), label);
+        ImGui::Text("Jump: %.0f steps/s", jump.stepsPerSecond);
+        if (ImGui::Button("Cancel Jump")) {
+            simulation.cancelJump();
+        }
+    } else {
+        ImGui::InputDouble("##jumpDay", &jumpDay, 365.25, 3652.5, "%.1f");
+        ImGui::SameLine();
+        if (ImGui::Button("Jump to Day") && jumpDay * 86400.0 >= snapshot.rewindFrom_s) {
+            simulation.jumpTo(jumpDay * 86400.0);
+        }
+
+        // Goes back when the slider is let go: the physics thread restores
+        // the nearest keyframe and steps forward from it.
+        double fromDay = snapshot.rewindFrom_s / 86400.0;
+        double nowDay = snapshot.simTime_s / 86400.0;
+        if (!rewinding) {
+            rewindDay = nowDay;
+        }
+        ImGui::SliderScalar("Rewind", ImGuiDataType_Double, &rewindDay, &fromDay, &nowDay, "Day %.1f");
+        rewinding = ImGui::IsItemActive();
+        if (ImGui::IsItemDeactivatedAfterEdit()) {
+            simulation.jumpTo(rewindDay * 86400.0);
+        }
+        ImGui::Text("History: %zu keyframes, %.1f MB", snapshot.rewindKeyframes, snapshot.rewindBytes / 1048576.0);
+    }
+
+    bool paused = snapshot.paused;
+    if (ImGui::Checkbox("Paused", &paused)) {
+        simulation.post([paused](SimulationThread::State& state) { state.paused = paused; },
+            SimulationThread::CommandKind::Setting);
+    }
+    ImGui::SameLine();
+    bool collisions = snapshot.collisions;
+    if (ImGui::Checkbox("Collisions", &collisions)) {
+        simulation.post([collisions](SimulationThread::State& state) { state.collisions.enabled = collisions; });
+    }
+    ImGui::Text("Merges: %llu", static_cast<unsigned long long>(snapshot.mergeCount));
+
+    float daysPerSecond = static_cast<float>(snapshot.timeScale / 86400.0);
+    if (ImGui::InputFloat("Days / s", &daysPerSecond, 1.0f, 10.0f, "%.2f") && daysPerSecond > 0.0f) {
+        double timeScale = daysPerSecond * 86400.0;
+        simulation.post([timeScale](SimulationThread::State& state) { state.physics.timeScale = timeScale; },
+            SimulationThread::CommandKind::Setting);
+    }
+
+    float stepHours = static_cast<float>(snapshot.step_s / 3600.0);
+    if (ImGui::InputFloat("Step (h)", &stepHours, 0.5f, 6.0f, "%.2f") && stepHours > 0.0f) {
+        double step = std::max(1.0, stepHours * 3600.0);
+        simulation.post([step](SimulationThread::State& state) { state.step_s = step; });
+    }
+
+    int integrator = static_cast<int>(snapshot.integrator);
+    if (ImGui::BeginCombo("Integrator", integratorName(snapshot.integrator))) {
+        for (int i = 0; i < INTEGRATOR_COUNT; ++i) {
+            IntegratorType type = static_cast<IntegratorType>(i);
+            if (ImGui::Selectable(integratorName(type), i == integrator)) {
+                simulation.post([type](SimulationThread::State& state) { state.physics.integrator = type; });
+            }
+        }
+        ImGui::EndCombo();
+    }
+
+    if (snapshot.integrator == IntegratorType::BlockTimestep) {
+        // Sent on release: each edit starts a new rewind keyframe.
+        if (!etaHeld) {
+            eta = static_cast<float>(snapshot.blockEta);
+        }
+        ImGui::SliderFloat("Eta", &eta, 0.002f, 0.1f, "%.3f", ImGuiSliderFlags_Logarithmic);
+        etaHeld = ImGui::IsItemActive();
+        if (ImGui::IsItemDeactivatedAfterEdit()) {
+            double value = eta;
+            simulation.post([value](SimulationThread::State& state) { state.physics.blockEta = value; });
+        }
+    }
+
+    ImGui::Separator();
+    ImGui::Text("Gravity Solver");
+    int solver = static_cast<int>(snapshot.solver);
+    // Block timesteps evaluate single bodies, which only the direct sum does.
+    ImGui::BeginDisabled(snapshot.integrator == IntegratorType::BlockTimestep);
+    if (ImGui::RadioButton("Direct", solver == static_cast<int>(GravitySolver::Direct))) {
+        simulation.post([](SimulationThread::State& state) { state.physics.solver = GravitySolver::Direct; });
+    }
+    ImGui::SameLine();
+    if (ImGui::RadioButton("Barnes-Hut", solver == static_cast<int>(GravitySolver::BarnesHut))) {
+        simulation.post([](SimulationThread::State& state) { state.physics.solver = GravitySolver::BarnesHut; });
+    }
+    ImGui::EndDisabled();
+
+    ImGui::Text("Force kernel: %s", simdLevelName(snapshot.simdLevel));
+
+    if (ImGui::Checkbox("Hardware counters", &hardwareCounters)) {
+        simulation.setCountersEnabled(hardwareCounters);
+    }
+    if (hardwareCounters && snapshot.countersEnabled) {
+        const PerfReading &perStep = snapshot.countersPerStep;
+        const PerfReading &perPair = snapshot.countersPerPair;
+        if (!snapshot.countersError.empty()) {
+            ImGui::TextWrapped("Unavailable: %s", snapshot.countersError.c_str());
+        }
+        for (int e = 0; e < PERF_EVENT_COUNT; ++e) {
+            PerfEvent event = static_cast<PerfEvent>(e);
+            if (perStep.has(event)) {
+                ImGui::Text("%s: %.3g /step, %.2f /pair", perfEventName(event), perStep.get(event), perPair.get(event));
+            }
+        }
+        if (perStep.has(PerfEvent::Cycles) && perStep.has(PerfEvent::Instructions) && perStep.get(PerfEvent::Cycles) > 0.0) {
+            ImGui::Text("IPC: %.2f", perStep.get(PerfEvent::Instructions) / perStep.get(PerfEvent::Cycles));
+        }
+    }
+
+    ThreadPool& pool = ThreadPool::global();
+    int threads = static_cast<int>(pool.getThreadCount());
+    if (ImGui::SliderInt("Threads", &threads, 1, static_cast<int>(pool.getMaxThreads()))) {
+        pool.setThreadCount(static_cast<unsigned>(threads));
+    }
+
+    if (!thetaHeld) {
+        theta = static_cast<float>(snapshot.theta);
+    }
+    ImGui::SliderFloat("Theta", &theta, 0.1f, 1.5f, "%.2f");
+    thetaHeld = ImGui::IsItemActive();
+    if (ImGui::IsItemDeactivatedAfterEdit()) {
+        double value = theta;
+        simulation.post([value](SimulationThread::State& state) { state.physics.theta = value; });
+    }
+
+    if (ImGui::Button("Check Force Error") && !pendingForceError.valid()) {
+        auto promise = std::make_shared<std::promise<ForceErrorReport>>();
+        pendingForceError = promise->get_future();
+        simulation.post([promise](SimulationThread::State& state) {
+            std::vector<BodyState> bodies;
+            state.bodies.store(bodies);
+            promise->set_value(state.physics.measureTreeError(bodies));
+        }, SimulationThread::CommandKind::Query);
+    }
+    if (pendingForceError.valid() &&
+        pendingForceError.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        forceError = pendingForceError.get();
+        hasForceError = true;
+    }
+    if (hasForceError) {
+        ImGui::Text("Bodies: %zu", forceError.bodyCount);
+        ImGui::Text("Mean rel. error: %.3e", forceError.meanRelative);
+        ImGui::Text("RMS rel. error:  %.3e", forceError.rmsRelative);
+        ImGui::Text("Max rel. error:  %.3e", forceError.maxRelative);
+    }
+
+    ImGui::Separator();
+    ImGui::Text("Test Particles");
+    ImGui::Text("Particles: %zu", snapshot.particleCurrent_m.size());
+    ImGui::InputInt("Batch", &particleBatch, 10000, 100000);
+    particleBatch = std::clamp(particleBatch, 1, 2000000);
+    size_t batch = static_cast<size_t>(particleBatch);
+
+    // Belts orbit the most massive body. Rings are sized from the drawn
+    // planet so they show outside its exaggerated sphere.
+    auto addBelt = [&simulation](BeltSpec spec, BodyId centralId) {
+        simulation.post([spec, centralId](SimulationThread::State& state) {
+            size_t central = centralId != BodyRegistry::NONE ? state.bodies.find(centralId) : heaviestBody(state.bodies);
+            if (central >= state.bodies.size()) {
+                return;
+            }
+            BeltSpec seeded = spec;
+            seeded.seed += state.particles.size();
+            generateBelt(seeded, state.bodies.get(central), PhysicsSystem::G, state.particles.particles);
+        });
+    };
+    if (ImGui::Button("Asteroid Belt")) {
+        addBelt(mainAsteroidBelt(batch), BodyRegistry::NONE);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Kuiper Belt")) {
+        addBelt(kuiperBelt(batch), BodyRegistry::NONE);
+    }
+    size_t selected = bodies.indexOf(selectedBody);
+    if (selected != BodyRegistry::NPOS) {
+        ImGui::SameLine();
+        if (ImGui::Button("Rings")) {
+            double radius_m = bodies.getDrawRadii()[selected] * METERS_PER_WU;
+            addBelt(planetaryRing(batch, radius_m), selectedBody);
+        }
+    }
+    if (ImGui::Button("Clear Particles")) {
+        simulation.post([](SimulationThread::State& state) { state.particles.clear(); });
+    }
+
+    renderTrajectory(simulation);
+
+    ImGui::Separator();
+    ImGui::Text("Grid");
+    if (ImGui::RadioButton("Procedural", grid.getMode() == GridMode::Procedural)) {
+        grid.setMode(GridMode::Procedural);
+    }
+    ImGui::SameLine();
+    if (ImGui::RadioButton("Lines", grid.getMode() == GridMode::Lines)) {
+        grid.setMode(GridMode::Lines);
+    }
+    PotentialField& field = grid.getField();
+    ImGui::Text("Field: %dx%d, %.2f ms", field.getResolution(), field.getResolution(), grid.getFieldTime());
+    ImGui::Checkbox("Tree approximation", &field.useTree);
+    if (field.useTree) {
+        float fieldTheta = static_cast<float>(field.theta);
+        if (ImGui::SliderFloat("Field theta", &fieldTheta, 0.1f, 1.5f, "%.2f")) {
+            field.theta = fieldTheta;
+        }
+    }
+
+    ImGui::Separator();
+    ImGui::Text("Selection: %zu bodies", selection.size());
+    ImGui::TextDisabled("Shift + drag: rectangle, Ctrl + drag: lasso");
+    if (!selection.empty() && ImGui::Button("Clear Selection")) {
+        selection.clear();
     }
     ImGui::End();
 }
 
+// Records to and plays back from the same file. Playback only changes what
+// is drawn; the simulation keeps running underneath.
+void UIManager::renderTrajectory(SimulationThread& simulation) {
+    const BodySnapshot& snapshot = simulation.snapshot();
+
+    ImGui::Separator();
+    ImGui::Text("Trajectory");
+    ImGui::InputText("File", trajectoryPath, sizeof(trajectoryPath));
+    if (snapshot.recording) {
+        if (ImGui::Button("Stop Recording")) {
+            simulation.stopRecording();
+        }
+        ImGui::SameLine();
+        ImGui::Text("%llu frames", static_cast<unsigned long long>(snapshot.recordedFrames));
+        if (snapshot.recordedDrops > 0) {
+            ImGui::Text("Dropped chunks: %llu", static_cast<unsigned long long>(snapshot.recordedDrops));
+        }
+    }
+    else if (ImGui::Button("Record")) {
+        playing = false;
+        playback.close();
+        simulation.startRecording(trajectoryPath);
+    }
+    if (!snapshot.recordingError.empty()) {
+        ImGui::TextWrapped("%s", snapshot.recordingError.c_str());
+    }
+
+    if (!snapshot.recording && ImGui::Button(playing ? "Reopen" : "Play Back")) {
+        playing = playback.open(trajectoryPath, playbackError);
+        if (playing) {
+            playbackError.clear();
+            playbackDay = playback.startTime() / 86400.0;
+        }
+    }
+    if (playing) {
+        ImGui::SameLine();
+        if (ImGui::Button("Live")) {
+            playing = false;
+            playback.close();
+        }
+        double first = playback.startTime() / 86400.0;
+        double last = playback.endTime() / 86400.0;
+        ImGui::SliderScalar("Day", ImGuiDataType_Double, &playbackDay, &first, &last, "%.1f");
+    }
+    else if (!playbackError.empty()) {
+        ImGui::TextWrapped("%s", playbackError.c_str());
+    }
+}
+
+void UIManager::applyPlayback(BodyRegistry& bodies) const {
+    if (playing) {
+        playback.sample(playbackDay * 86400.0, bodies);
+    }
+}
+
 bool UIManager::isRightMousePressed(GLFWwindow* window) {
     return !ImGui::GetIO().WantCaptureMouse && glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_RIGHT) == GLFW_PRESS;
 }
 
-void UIManager::renderNavbar(std::vector<std::shared_ptr<Planet>>& planets) {
+// Replaces the registry and the simulation with the saved state; anything
+// that refers to the old bodies by id is dropped.
+void UIManager::loadCheckpoint(BodyRegistry& bodies, SimulationThread& simulation) {
+    Checkpoint checkpoint;
+    std::string error;
+    if (!::loadCheckpoint(CHECKPOINT_PATH, checkpoint, error)) {
+        checkpointMessage = error;
+        return;
+    }
+
+    bodies.clear();
+    addCheckpointBodies(checkpoint, bodies);
+    simulation.restoreCheckpoint(std::move(checkpoint));
+
+    selectedBody = BodyRegistry::NONE;
+    lastSelectedBody = BodyRegistry::NONE;
+    orbitTarget = BodyRegistry::NONE;
+    hoveredIndex = -1;
+    selection.clear();
+    playing = false;
+    checkpointMessage = std::string("Loaded ") + CHECKPOINT_PATH;
+}
+
+void UIManager::renderNavbar(BodyRegistry& bodies, SimulationThread& simulation) {
+    if (pendingCheckpoint.valid() &&
+        pendingCheckpoint.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        std::string error = pendingCheckpoint.get();
+        checkpointMessage = error.empty() ? std::string("Saved ") + CHECKPOINT_PATH : error;
+    }
+
     if (ImGui::BeginMainMenuBar()) {
+        if (ImGui::BeginMenu("File")) {
+            if (ImGui::MenuItem("Save Checkpoint", nullptr, false, !pendingCheckpoint.valid())) {
+                pendingCheckpoint = simulation.saveCheckpoint(CHECKPOINT_PATH, bodies);
+            }
+            if (ImGui::MenuItem("Load Checkpoint")) {
+                loadCheckpoint(bodies, simulation);
+            }
+            if (!checkpointMessage.empty()) {
+                ImGui::Separator();
+                ImGui::TextDisabled("%s", checkpointMessage.c_str());
+            }
+            ImGui::EndMenu();
+        }
         if (ImGui::BeginMenu("Planets")) {
-            for (size_t i = 0; i < planets.size(); ++i) {
-                if (ImGui::MenuItem(planets[i]->getName().c_str())) {
-                    selectedPlanetIndex = static_cast<int>(i);
+            for (size_t i = 0; i < bodies.size(); ++i) {
+                ImGui::PushID(static_cast<int>(i));
+                if (ImGui::MenuItem(bodies.getNames()[i].c_str())) {
+                    selectedBody = bodies.getIds()[i];
                 }
+                ImGui::PopID();
             }
             ImGui::EndMenu();
         }
+        if (ImGui::BeginMenu("View")) {
+            ImGui::MenuItem("Profiler", nullptr, &showProfiler);
+            ImGui::EndMenu();
+        }
         ImGui::EndMainMenuBar();
     }
 }
\ No newline at end of file
@@ -1,36 +1,85 @@
 #pragma once
 #include <vector>
 #include <memory>
-#include "objects/Planet.h"
+#include <string>
+#include "core/BodyRegistry.h"
 #include "core/Window.h"
 #include "core/Camera.h"
 #include "core/Grid.h"
+#include "core/Bvh.h"
+#include "physics/SimulationThread.h"
+#include "ui/ProfilerPanel.h"
+#include <future>
 
 class UIManager {
 public:
-    void render(Window &window, Camera &camera, float deltaTime,
-        std::vector<std::shared_ptr<Planet>>& planets, Grid& grid);
+    static constexpr const char *CHECKPOINT_PATH = "solarsim.ssckpt";
+
+    void render(Window &window, Camera &camera, float deltaTime, BodyRegistry &bodies, Grid &grid,
+        SimulationThread &simulation, const Bvh &bvh);
     bool isRightMousePressed(GLFWwindow *window);
     bool isHovered(size_t i) const { return static_cast<int>(i) == hoveredIndex; }
 
+    // Removes the absorbed body, grows the survivor and moves selection,
+    // hover and the orbital camera target over to it.
+    void applyMerge(const MergeEvent &merge, BodyRegistry &bodies, Camera &camera);
+
+    // While a recording is played back, replaces the live positions with the
+    // recorded ones at the scrubbed time.
+    void applyPlayback(BodyRegistry &bodies) const;
+
 private:
-    int selectedPlanetIndex = -1;
+    BodyId selectedBody = BodyRegistry::NONE;
+    BodyId lastSelectedBody = BodyRegistry::NONE;
+    BodyId orbitTarget = BodyRegistry::NONE;
     int hoveredIndex = -1;
-    int lastSelectedIndex = -1;
     bool isMouseMoving = false;
+    ForceErrorReport forceError;
+    bool hasForceError = false;
+    std::future<ForceErrorReport> pendingForceError;
+    int particleBatch = 100000;
+    double jumpDay = 36525.0;   // target of "Jump to day", in simulated days
+    double rewindDay = 0.0;
+    bool rewinding = false;     // the rewind slider is held
+    float eta = 0.0f;           // the Eta and Theta sliders while held
+    bool etaHeld = false;
+    float theta = 0.0f;
+    bool thetaHeld = false;
+    ProfilerPanel profiler;
+    bool showProfiler = false;
+    bool hardwareCounters = false;
+    char trajectoryPath[256] = "trajectory.sstraj";
+    TrajectoryReader playback;
+    bool playing = false;
+    double playbackDay = 0.0;
+    std::string playbackError;
+    std::future<std::string> pendingCheckpoint;
+    std::string checkpointMessage;
+
+    // Shift + drag selects a rectangle, Ctrl + drag a lasso.
+    static constexpr size_t MAX_SELECTION_MARKERS = 4096;
+    std::vector<BodyId> selection;
+    std::vector<glm::vec2> regionPoints;   // screen pixels
+    bool regionDragging = false;
+    bool regionLasso = false;
 
     struct PlanetEditBuffer {
         char name[128];
         float mass;
         float density;
         float radius;
-        glm::vec3 position;
-        glm::vec3 velocity;
+        glm::vec3 position;   // world units
+        glm::vec3 velocity;   // m/s
     } editBuffer;
 
+    void loadEditBuffer(const BodyRegistry &bodies, size_t i, const BodySnapshot &snapshot);
+    void removeBody(BodyId id, BodyRegistry &bodies, SimulationThread &simulation);
     void renderPlanetPopup(Window &window, Camera &camera, const glm::mat4 &view, const glm::mat4 &projection,
-        const std::vector<std::shared_ptr<Planet>> &planets);
-    void renderPlanetInfo(std::shared_ptr<Planet> &planet, Camera &camera);
-    void renderMainPanel(float deltaTime, std::vector<std::shared_ptr<Planet>> &planets, Grid &grid);
-    void renderNavbar(std::vector<std::shared_ptr<Planet>> &planets);
+        const BodyRegistry &bodies, const Bvh &bvh);
+    void renderRegionSelect(const glm::mat4 &viewProjection, const Bvh &bvh, const BodyRegistry &bodies);
+    void renderPlanetInfo(BodyRegistry &bodies, size_t i, Camera &camera, SimulationThread &simulation);
+    void renderMainPanel(float deltaTime, BodyRegistry &bodies, Grid &grid, SimulationThread &simulation);
+    void renderTrajectory(SimulationThread &simulation);
+    void loadCheckpoint(BodyRegistry &bodies, SimulationThread &simulation);
+    void renderNavbar(BodyRegistry &bodies, SimulationThread &simulation);
 };